@@ -0,0 +1,93 @@
+/*
+ * eeprom_cache.h
+ * fyras1
+ *
+ */
+
+#ifndef EEPROM_EMUL_EEP_CACHE_H_
+#define EEPROM_EMUL_EEP_CACHE_H_
+
+#include "eeprom_drv.h"
+
+#if EEPROM_CACHE_ENABLE
+
+/********************typedefs*************************/
+typedef struct
+{
+    uint16_t u16VirtAddr; /*0 = unused entry*/
+    BOOL bDirty;          /*value not written to the flash yet*/
+    uint32_t u32DataVal;
+} Tst_EepromCacheEntry;
+
+/*********************Prototypes**************************/
+
+/**
+ * @brief Initialize the EEPROM (u8EEPROM_eInit) and empty the cache
+ * @return Status code indicating the result of the initialization
+ */
+uint8_t u8EEPROM_eCacheInit( void );
+
+/**
+ * @brief Drop all the cached variables, dirty ones included (done by u8EEPROM_eFormat and u8EEPROM_eImportImage)
+ */
+void vEEPROM_eCacheClear( void );
+
+/**
+ * @brief Drop the cached value of a variable, dirty or not: called by the direct writes of the default EEPROM
+ *        (u8EEPROM_eWriteVar, u8EEPROM_eWriteVars, u8EEPROM_eWriteRecord, u8EEPROM_eIncrementCounter), their value is newer
+ * @param Fu16VirtAddr Virtual address of the variable
+ */
+void vEEPROM_eCacheInvalidate( uint16_t Fu16VirtAddr );
+
+/**
+ * @brief Write a variable through the cache
+ * @note nothing is written if the value is unchanged, the flash is updated on commit,
+ *       by u8EEPROM_eCacheTick or when EEPROM_CACHE_FLUSH_THRESHOLD variables are dirty
+ * @param Fu16VirtAddr Virtual address of the variable to write
+ * @param Fu32Data Data value to write
+ * @return Status code indicating the result of the write operation
+ */
+uint8_t u8EEPROM_eCacheWriteVar( uint16_t Fu16VirtAddr,
+                                 uint32_t Fu32Data );
+
+/**
+ * @brief Read a variable through the cache
+ * @param Fu16VirtAddr Virtual address of the variable to read
+ * @param Fpu32Value Pointer to store the read value
+ * @return Status code indicating the result of the read operation
+ */
+uint8_t u8EEPROM_eCacheReadVar( uint16_t Fu16VirtAddr,
+                                uint32_t * Fpu32Value );
+
+/**
+ * @brief Write all the dirty variables to the flash (one batch write)
+ * @return Status code indicating the result of the write operation
+ */
+uint8_t u8EEPROM_eCacheCommit( void );
+
+/**
+ * @brief Commit the cache once the oldest unflushed write is EEPROM_CACHE_FLUSH_INTERVAL_MS old
+ * @param Fu32NowMs Current time in ms (e.g. HAL_GetTick()), may wrap around
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eCacheTick( uint32_t Fu32NowMs );
+
+/**
+ * @brief Write dirty variables in bounded time (brown-out handler)
+ * @note only writes that fit the page are done: no page switch, no transfer (see u32EEPROM_eGetWriteBudget).
+ *       each one costs EEPROM_WRITE_PROGRAMS packet programs
+ * @param Fu32MaxPrograms Maximum number of packet programs (energy left)
+ * @return Du8EEPROM_eSUCCESS if no dirty variable is left, Du8EEPROM_eBUSY if some are left,
+ *         error code otherwise
+ */
+uint8_t u8EEPROM_eCacheEmergencyFlush( uint32_t Fu32MaxPrograms );
+
+/**
+ * @brief Get the number of dirty variables in the cache
+ * @return Number of variables not written to the flash yet
+ */
+uint32_t u32EEPROM_eCacheDirtyCount( void );
+
+#endif /* EEPROM_CACHE_ENABLE */
+
+#endif /* EEPROM_EMUL_EEP_CACHE_H_ */
@@ -0,0 +1,52 @@
+/*
+ * eeprom_crc.h
+ * fyras1
+ *
+ */
+
+#ifndef EEPROM_EMUL_EEP_CRC_H_
+#define EEPROM_EMUL_EEP_CRC_H_
+
+#include "stdint.h"
+#include "eeprom_drv_cfg.h"
+
+#if ( EEPROM_CRC_ENGINE == EEPROM_CRC_ADDITIVE )
+    #define EEPROM_CRC_INIT    ( 0x0000U )
+#elif ( EEPROM_CRC_ENGINE == EEPROM_CRC_CCITT ) || ( EEPROM_CRC_ENGINE == EEPROM_CRC_HW )
+    #define EEPROM_CRC_INIT    ( 0xFFFFU )
+#elif ( EEPROM_CRC_ENGINE == EEPROM_CRC_NONE )
+    #define EEPROM_CRC_INIT    ( 0x0000U )
+#else
+    #error "unknown EEPROM_CRC_ENGINE"
+#endif
+
+#if ( EEPROM_CRC_ENGINE == EEPROM_CRC_CCITT ) && ( EEPROM_CRC_SLICES != 1U ) && ( EEPROM_CRC_SLICES != 2U ) && ( EEPROM_CRC_SLICES != 4U )
+    #error "EEPROM_CRC_SLICES must be 1, 2 or 4"
+#endif
+
+/*********************Prototypes**************************/
+
+/**
+ * @brief Update a checksum with the 6 bytes of a packet (virtual address, then data, MSB first)
+ * @note packet CRC = u16EEPROM_eCrcUpdate( EEPROM_CRC_INIT, address, data ), records chain it over their payload
+ * @param Fu16Crc Checksum of the previous packets, EEPROM_CRC_INIT for the first one
+ * @param Fu16VirtAddr Virtual address of the packet
+ * @param Fu32Data Data of the packet
+ * @return Updated checksum
+ */
+uint16_t u16EEPROM_eCrcUpdate( uint16_t Fu16Crc,
+                               uint16_t Fu16VirtAddr,
+                               uint32_t Fu32Data );
+
+#if EEPROM_CRC_BENCHMARK_ENABLE
+
+/**
+ * @brief Measure the checksum throughput: verify packets read from the eeprom pages
+ * @param Fu32NbPackets Number of packets to verify
+ * @return Verified packets per second
+ */
+uint32_t u32EEPROM_eCrcBenchmark( uint32_t Fu32NbPackets );
+
+#endif
+
+#endif /* EEPROM_EMUL_EEP_CRC_H_ */
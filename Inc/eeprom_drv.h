@@ -11,16 +11,43 @@
 #include "eeprom_mcu_itf.h"
 #include "eeprom_drv_cfg.h"
 
-#define NB_EEPROM_PAGES               ( 2U )
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if ( NB_EEPROM_PAGES < 2U )
+    #error "the eeprom needs at least 2 pages"
+#endif
+#if ( EEPROM_RECORD_MAX_SIZE > 0xFFFFU )
+    #error "EEPROM_RECORD_MAX_SIZE must fit the 16 bits size of a record head"
+#endif
+#if EEPROM_THREAD_SAFE_ENABLE && ( EEPROM_READ_RETRIES == 0U )
+    #error "EEPROM_READ_RETRIES must be at least 1"
+#endif
+#if ( EEPROM_TRANSFER_BURST_PACKETS == 0U )
+    #error "EEPROM_TRANSFER_BURST_PACKETS must be at least 1"
+#endif
+#if ( EEPROM_TRANSFER_MAX_PAGE_SIZE < EEPROM_PAGE_SIZE )
+    #error "EEPROM_TRANSFER_MAX_PAGE_SIZE must cover EEPROM_PAGE_SIZE"
+#endif
+#if EEPROM_COUNTER_ENABLE && ( MCU_FLASH_BIT_REPROGRAM == 0U )
+    #error "the counters program their tally in place, set EEPROM_COUNTER_ENABLE to 0 on this flash"
+#endif
+#if EEPROM_REGISTRY_ENABLE && !defined( EEPROM_REGISTRY )
+    #error "EEPROM_REGISTRY_ENABLE needs the EEPROM_REGISTRY table of the application (see EEPROM_REGISTRY_FILE)"
+#endif
 #define PAGE_0                        ( 0U )     /*DO NOT change page ID*/
 #define PAGE_1                        ( 1U )     /*DO NOT change page ID*/
 #define MAX_PAGE_ID                   ( NB_EEPROM_PAGES - 1U )
 
-#define MAX_EEPROM_VARIABLES          ( ( EEPROM_PAGE_SIZE - PAGE_HEADER_SIZE ) / ( PACKET_SIZE ) ) /*useful, but not used*/
+#define MAX_EEPROM_VARIABLES          ( ( EEPROM_PAGE_SIZE - PAGE_HEADER_SIZE ) / ( PACKET_SIZE ) ) /*packets in a page body*/
 
 #define FLASH_EEPROM_END_ADDR         ( FLASH_EEPROM_START_ADDR + ( EEPROM_PAGE_SIZE * ( NB_EEPROM_PAGES ) ) )
-#define PAGE_STATUS_SIZE              ( 4U )
-#define PAGE_ERASE_COUNT_SIZE         ( 4U )
+/*each header field is one program unit, programmed once: a RECEIVING status is then only cleared to ACTIVE
+ * (all zeros), the import withdrawal clears the erase count to all zeros. the fields are read by their low 32 bits*/
+#define PAGE_STATUS_SIZE              ( MCU_FLASH_PROGRAM_UNIT )
+#define PAGE_ERASE_COUNT_SIZE         ( MCU_FLASH_PROGRAM_UNIT )
+#define PAGE_ERASE_COUNT_IMPORT       ( 0U )     /*erase count of a page withdrawn by an image import (counts start at 1): the next init formats*/
 #define PAGE_HEADER_SIZE              ( PAGE_STATUS_SIZE + PAGE_ERASE_COUNT_SIZE )
 
 
@@ -33,13 +60,62 @@
 #define EMPTY_PACKET                  ( 0xFFFFFFFFFFFFFFFFU )     /*empty packet = not used yet*/
 #define FREED_PACKET                  ( 0x0000000000000000U )     /*freed packet = has been used and no longer needed*/
 #define NO_EMPTY_WRITE_SPACE_FOUND    ( 0xFFFFFFFFU )
-
-#define NEXT_PAGE( pageId )                    ( pageId ^ 1U )
-#define PAGE_HEADER_ADDRESS( pageId )          ( FLASH_EEPROM_START_ADDR + ( pageId * EEPROM_PAGE_SIZE ) )
-#define PAGE_END_ADDRESS( pageId )             ( PAGE_HEADER_ADDRESS( pageId ) + EEPROM_PAGE_SIZE )
-#define PAGE_BODY_ADDRESS( pageId )            ( PAGE_HEADER_ADDRESS( pageId ) + PAGE_HEADER_SIZE )
-#define IS_ADDRESS_IN_EEPROM( ADDRESS )        ( ( ADDRESS >= FLASH_EEPROM_START_ADDR ) && ( ADDRESS < FLASH_EEPROM_END_ADDR ) )
-#define IS_VIRTUAL_ADDRESS_VALID( ADDRESS )    ( ( ADDRESS > 0 ) && ( ADDRESS < 0xFFFF ) ) /*0x0000 and 0xffff mark freed and empty flash locations*/
+#define INDEX_ENTRY_NOT_FOUND         ( 0xFFFFFFFFU )
+#define TRANSFER_STEP_UNLIMITED       ( 0xFFFFFFFFU )
+/*packet programs of a variable write: the packet, then the free of its older copy unless EEPROM_LAZY_FREE_ENABLE*/
+#define EEPROM_WRITE_PROGRAMS         ( ( EEPROM_LAZY_FREE_ENABLE != 0U ) ? 1U : 2U )
+
+#define NEXT_PAGE( pageId )                    ( ( uint8_t ) ( ( ( pageId ) + 1U ) % NB_EEPROM_PAGES ) )
+#define PREV_PAGE( pageId )                    ( ( uint8_t ) ( ( ( pageId ) + NB_EEPROM_PAGES - 1U ) % NB_EEPROM_PAGES ) )
+/*geometry of an instance (Tst_EepromInstance)*/
+#define PAGE_PACKETS( INST )                   ( ( ( INST )->u32PageSize - PAGE_HEADER_SIZE ) / PACKET_SIZE ) /*packets in a page body*/
+#define INSTANCE_END_ADDRESS( INST )           ( ( INST )->u32StartAddr + ( ( INST )->u32PageSize * NB_EEPROM_PAGES ) )
+#define ADDRESS_PAGE( INST, ADDRESS )          ( ( uint8_t ) ( ( ( ADDRESS ) - ( INST )->u32StartAddr ) / ( INST )->u32PageSize ) )
+#define PAGE_HEADER_ADDRESS( INST, pageId )    ( ( INST )->u32StartAddr + ( ( uint32_t ) ( pageId ) * ( INST )->u32PageSize ) )
+#define PAGE_END_ADDRESS( INST, pageId )       ( PAGE_HEADER_ADDRESS( INST, pageId ) + ( INST )->u32PageSize )
+#define PAGE_BODY_ADDRESS( INST, pageId )      ( PAGE_HEADER_ADDRESS( INST, pageId ) + PAGE_HEADER_SIZE )
+#define IS_ADDRESS_IN_EEPROM( INST, ADDRESS )  ( ( ( ADDRESS ) >= ( INST )->u32StartAddr ) && ( ( ADDRESS ) < INSTANCE_END_ADDRESS( INST ) ) )
+#define IS_VIRTUAL_ADDRESS_VALID( ADDRESS )    ( ( ADDRESS > 0 ) && ( ADDRESS < COUNTER_TALLY_MARKER ) ) /*0x0000 and 0xffff mark freed and empty flash locations*/
+
+/*a record is written as its payload slots followed by a head packet: virtual address, CRC complemented
+ * (marks a head), data = size << 16 | record CRC. payload slots use the reserved virtual address below*/
+#define RECORD_SLOT_MARKER                     ( 0xFFFEU )
+#define RECORD_SLOT_PAYLOAD_SIZE               ( 6U ) /*bytes of a payload slot after the marker*/
+#define RECORD_PAYLOAD_SLOTS( SIZE )           ( ( ( uint32_t ) ( SIZE ) + RECORD_SLOT_PAYLOAD_SIZE - 1U ) / RECORD_SLOT_PAYLOAD_SIZE )
+
+/*a counter is a variable packet (base value) just after a tally packet: marker, virtual address of the counter,
+ * 32 bits cleared one at a time from bit 0 by the increments, programmed in place. value = base + bits cleared*/
+#define COUNTER_TALLY_MARKER                   ( 0xFFFDU )
+#define COUNTER_TALLY_BITS                     ( 32U )
+
+/*image of the live variables and records (u8EEPROM_eExportImage), little endian: header then the packets as
+ * programmed in the page body. the checksum chains the version, the number of packets, the reserved bytes and the packets*/
+#define EEPROM_IMAGE_MAGIC                     ( 0x4D494545U ) /*"EEIM"*/
+#define EEPROM_IMAGE_VERSION                   ( 1U )
+#define EEPROM_IMAGE_MAGIC_OFFSET              ( 0U )  /*4 bytes*/
+#define EEPROM_IMAGE_VERSION_OFFSET            ( 4U )  /*2 bytes*/
+#define EEPROM_IMAGE_NB_PACKETS_OFFSET         ( 6U )  /*2 bytes*/
+#define EEPROM_IMAGE_RESERVED_OFFSET           ( 8U )  /*2 bytes, 0xFFFF*/
+#define EEPROM_IMAGE_CHECKSUM_OFFSET           ( 10U ) /*2 bytes*/
+#define EEPROM_IMAGE_HEADER_SIZE               ( 12U )
+#define EEPROM_IMAGE_SIZE( NB_PACKETS )        ( EEPROM_IMAGE_HEADER_SIZE + ( ( uint32_t ) ( NB_PACKETS ) * PACKET_SIZE ) )
+#define PACKET_SLOT( INST, ADDRESS )           ( ( uint16_t ) ( ( ( ADDRESS ) - ( INST )->u32StartAddr ) / PACKET_SIZE ) )
+#define SLOT_ADDRESS( INST, SLOT )             ( ( INST )->u32StartAddr + ( ( uint32_t ) ( SLOT ) * PACKET_SIZE ) )
+
+/*liveness bitmap of the page transfer: bit n <=> packet n of the oldest page body*/
+#define TRANSFER_LIVE_WORDS                    ( ( ( ( EEPROM_TRANSFER_MAX_PAGE_SIZE - PAGE_HEADER_SIZE ) / PACKET_SIZE ) + 31U ) / 32U )
+#define TRANSFER_LIVE_SLOT( INST, ADDRESS )    ( ( ( ADDRESS ) - PAGE_BODY_ADDRESS( INST, ( INST )->u8OldestPage ) ) / PACKET_SIZE )
+
+#if ( ( NB_EEPROM_PAGES * EEPROM_PAGE_SIZE / PACKET_SIZE ) > 0xFFFFU )
+    #error "too many eeprom packets for the 16 bit packet slots"
+#endif
+
+#if EEPROM_RAM_INDEX_ENABLE
+    #if ( ( EEPROM_RAM_INDEX_SIZE & ( EEPROM_RAM_INDEX_SIZE - 1U ) ) != 0U )
+        #error "EEPROM_RAM_INDEX_SIZE must be a power of 2"
+    #endif
+    #define INDEX_HASH( ADDRESS )    ( ( ( uint32_t ) ( ADDRESS ) * 0x9E3779B1U ) >> 16 & ( EEPROM_RAM_INDEX_SIZE - 1U ) )
+#endif
 
 /******************EEPROM RETURN CODES**********************/
 #define Du8EEPROM_eSUCCESS            ( 0U )
@@ -51,6 +127,7 @@
 #define Du8EEPROM_eERASE_ERROR        ( 5U )
 #define Du8EEPROM_eALIGNMENT_ERROR    ( 6U )
 #define Du8EEPROM_eDATA_CORRUPTED     ( 7U )
+#define Du8EEPROM_eBUSY               ( 8U )
 /*********************************************************/
 
 /********************typedefs*************************/
@@ -62,6 +139,14 @@ typedef enum
     EEPROM_PAGE_ERASED,
 } EEpromHeaderTypedef;
 
+typedef enum
+{
+    EEPROM_TRANSFER_IDLE,
+    EEPROM_TRANSFER_COPY,  /*copying the live packets of the oldest page to the active page*/
+    EEPROM_TRANSFER_ERASE, /*starting the erase of the oldest page*/
+    EEPROM_TRANSFER_ERASE_WAIT, /*waiting for the end of the erase, the page already left the ring*/
+} EEpromTransferStateTypedef;
+
 typedef struct
 {
     uint16_t u16VirtAddr;
@@ -69,9 +154,126 @@ typedef struct
     uint32_t u32DataVal;
 } Tst_EppromPacket;
 
+typedef struct
+{
+    uint16_t u16VirtAddr; /*0 = unused entry*/
+    uint16_t u16Slot;     /*packet position, counted in PACKET_SIZE from the start of the instance*/
+} Tst_EepromIndexEntry;
+
+#if EEPROM_STATS_ENABLE
+typedef struct
+{
+    uint32_t u32Programs;            /*flash program operations (packets, page status and erase count words)*/
+    uint32_t u32Erases;              /*page erases started*/
+    uint32_t u32Transfers;           /*page transfers completed*/
+    uint32_t u32TransferPackets;     /*packets copied by the page transfers*/
+    uint32_t u32TransferDropped;     /*stale, freed or damaged packets left behind by them (PACKET_SIZE bytes reclaimed each)*/
+    uint32_t u32TransferVerifyErrors; /*copied bursts that did not read back, freed and copied again*/
+    uint32_t u32Relocations;         /*variables handed to pfRelocate by the page transfers instead of being copied*/
+    uint32_t u32WriteRetries;        /*packets written again at the next slot (WRITE_CORRECTION_ENABLE)*/
+    uint32_t u32Writes;              /*calls to u8EEPROM_eWriteVar, u8EEPROM_eWriteVars, u8EEPROM_eWriteRecord and u8EEPROM_eIncrementCounter*/
+    uint32_t u32CounterInPlace;      /*counter increments programmed in place in their tally (no packet appended)*/
+    uint32_t u32MaxWriteLatency;     /*longest of these calls, in u32FLASH_ITF_eGetTimestamp units*/
+    uint32_t u32Reads;               /*lookups of u8EEPROM_eReadVar and u8EEPROM_eReadRecord*/
+    uint32_t u32ReadScannedPackets;  /*packets read by these lookups (0 when the RAM index has the variable)*/
+    uint32_t u32MaxReadScan;
+    uint32_t u32Frees;               /*older copies searched to be freed (EEPROM_LAZY_FREE_ENABLE == 0)*/
+    uint32_t u32FreeScannedPackets;  /*packets read by these searches*/
+    uint32_t u32MaxFreeScan;
+    uint32_t u32ActiveLiveSlots;     /*slots of the active page holding the newest copy of a variable or record*/
+    uint32_t u32ActiveStaleSlots;    /*superseded, freed or damaged slots of the active page*/
+    uint32_t u32ActiveFreeSlots;     /*slots of the active page still erased*/
+    uint32_t au32PageEraseCount[ NB_EEPROM_PAGES ];
+} Tst_EepromStats;
+#endif
+
+/*flash operations of an instance, stEEPROM_eMcuFlash for the MCU flash (eeprom_mcu_itf.h).
+ * the instances on the same flash controller must share the same table: one erase runs at a time and
+ * the writers of all of them are serialized on its mutex. the instance region must be memory mapped (reads)*/
+typedef struct
+{
+    uint8_t ( * pfSectorEraseStart )( uint8_t Fu8Sector );
+    uint8_t ( * pfEraseStatus )( void );
+    void ( * pfEraseWaitHook )( void );
+    uint8_t ( * pfProgram )( uint32_t Fu32Address,
+                             uint64_t Fu64Data,
+                             uint8_t Fu8WriteSizeBytes );
+    uint8_t ( * pfProgramBurst )( uint32_t Fu32Address,
+                                  const uint64_t * Fpu64Data,
+                                  uint32_t Fu32NbPackets );
+    void ( * pfSessionBegin )( void );
+    void ( * pfSessionEnd )( void );
+    void ( * pfMutexTake )( void );
+    void ( * pfMutexGive )( void );
+} Tst_EepromFlashItf;
+
+/*called by the page transfer for each live variable of the page being compacted, before it is copied.
+ * TRUE => the variable was written elsewhere (e.g. another instance) and is left out of the copy, its index entry
+ * goes when the page is erased. it must not write to the instance being compacted*/
+typedef BOOL ( * Tpf_EepromRelocate )( uint16_t Fu16VirtAddr,
+                                       uint32_t Fu32Data );
+
+/*called by u8EEPROM_eForEachVar once per stored variable with its newest value (counters folded).
+ * FALSE => the walk stops there. it must not write to the instance being walked*/
+typedef BOOL ( * Tpf_EepromVarVisitor )( uint16_t Fu16VirtAddr,
+                                         uint32_t Fu32Data,
+                                         void * FpvContext );
+
+/*an emulated eeprom: NB_EEPROM_PAGES consecutive flash sectors of the same size and their RAM state.
+ * set the 4 first fields (EEPROM_INSTANCE_INIT) and optionally pfRelocate, then call u8EEPROM_eInstInit,
+ * the other fields are private*/
+typedef struct
+{
+    uint32_t u32StartAddr;                 /*address of page 0*/
+    uint32_t u32PageSize;                  /*size of a page (one flash sector) in bytes*/
+    uint8_t u8FirstSector;                 /*MCU sector of page 0, page n is erased as sector u8FirstSector + n*/
+    const Tst_EepromFlashItf * pstFlash;
+    Tpf_EepromRelocate pfRelocate;         /*NULL => every live variable is copied*/
+
+    BOOL bStateSet;                        /*FALSE until the first init or format sets the fields below*/
+    BOOL bInitDone;
+    uint8_t u8ActivePage;                  /*page receiving the writes (newest page of the ring)*/
+    uint8_t u8OldestPage;                  /*oldest page still holding data, next one to be compacted*/
+    uint32_t u32NextWriteAddress;
+    EEpromTransferStateTypedef eTransferState;
+    uint32_t u32TransferCursor;            /*next packet of the oldest page to be copied*/
+    uint32_t u32TransferRemaining;         /*packets still to be copied (relocated ones stay counted)*/
+    uint32_t u32TransferMarkEnd;           /*next write address when the bitmap was built, newer copies are after it*/
+    uint8_t u8TransferRetries;             /*copies of the page started again after a failed read back*/
+    uint32_t au32TransferLive[ TRANSFER_LIVE_WORDS ]; /*newest valid copies of the oldest page, to be copied*/
+    uint8_t u8ErasingPage;                 /*page whose sector erase runs in background, 0xFF if none*/
+    uint32_t u32ErasingPageCount;          /*erase count to write once that erase is done*/
+    #if EEPROM_DEBUG_MODE
+        uint32_t u32EraseCounter;
+    #endif
+    #if EEPROM_RAM_INDEX_ENABLE
+        Tst_EepromIndexEntry astIndex[ EEPROM_RAM_INDEX_SIZE ];
+        uint16_t u16IndexCount;
+        BOOL bIndexOverflow;               /*TRUE when some stored variables could not be indexed*/
+    #endif
+    #if EEPROM_STATS_ENABLE
+        Tst_EepromStats stStats;
+    #endif
+    #if EEPROM_THREAD_SAFE_ENABLE
+        volatile uint32_t u32UpdateSequence; /*odd while a writer changes the state the reads rely on*/
+        uint32_t u32UpdateDepth;             /*nesting of the update windows (writers only)*/
+    #endif
+} Tst_EepromInstance;
+
+/*static initializer of an instance. its page size must be at most EEPROM_TRANSFER_MAX_PAGE_SIZE (EEPROM_PAGE_SIZE by
+ * default, the transfer bitmap of every instance is sized for it), a larger page fails u8EEPROM_eInstInit
+ * (Du8EEPROM_eBAD_PARAM). e.g. a partition for the factory data on the 128 KB sectors of the stm32f205, next to the
+ * default one, with EEPROM_TRANSFER_MAX_PAGE_SIZE set to ( 128U * 1024U ) (2 KB of bitmap in each instance):
+ * static Tst_EepromInstance stFactory = EEPROM_INSTANCE_INIT( 0x08020000U, 128U * 1024U, FLASH_SECTOR_5, &stEEPROM_eMcuFlash );*/
+#define EEPROM_INSTANCE_INIT( START_ADDR, PAGE_SIZE, FIRST_SECTOR, FLASH ) \
+    { .u32StartAddr = ( START_ADDR ), .u32PageSize = ( PAGE_SIZE ), .u8FirstSector = ( FIRST_SECTOR ), .pstFlash = ( FLASH ) }
+
+/*eeprom_mcu_itf.h functions*/
+extern const Tst_EepromFlashItf stEEPROM_eMcuFlash;
+
 /*********************Prototypes******  ********************/
 
-/*external APIs*/
+/*external APIs, on the default instance (FLASH_EEPROM_START_ADDR, EEPROM_PAGE_SIZE, MCU flash)*/
 
 /**
  * @brief Initialize the EEPROM by checking the page headers and setting the active page and next write address
@@ -80,7 +282,7 @@ typedef struct
 uint8_t u8EEPROM_eInit( void );
 
 /**
- * @brief Format the EEPROM by erasing both pages and setting the active page
+ * @brief Format the EEPROM by erasing all pages and setting the active page
  * @return Status code indicating the result of the formatting operation
  */
 uint8_t u8EEPROM_eFormat( void );
@@ -96,8 +298,67 @@ uint8_t u8EEPROM_eWriteVar( uint16_t Fu16VirtAddr,
                             uint32_t Fu32Data );
 
 
+/**
+ * @brief Write several variables to the EEPROM at once
+ * @note when a virtual address appears more than once the last value is kept, space is reserved
+ *       for the whole batch first so at most one page switch happens
+ * @param Fpst Array of variables to write (u16VirtAddr, u32DataVal), u16CRC is ignored
+ * @param Fu32NbVars Number of entries in Fpst
+ * @return Status code indicating the result of the write operation
+ */
+uint8_t u8EEPROM_eWriteVars( const Tst_EppromPacket * Fpst,
+                             uint32_t Fu32NbVars );
+
+
+/**
+ * @brief Write a record (blob, struct, string) of up to EEPROM_RECORD_MAX_SIZE bytes
+ * @note the record is programmed in one burst of consecutive packets and replaces any
+ *       variable or record with the same virtual address
+ * @param Fu16VirtAddr Virtual address of the record
+ * @param Fpu8Data Data to write
+ * @param Fu16Size Size of the data in bytes
+ * @return Status code indicating the result of the write operation
+ */
+uint8_t u8EEPROM_eWriteRecord( uint16_t Fu16VirtAddr,
+                               const uint8_t * Fpu8Data,
+                               uint16_t Fu16Size );
+
+
+#if EEPROM_COUNTER_ENABLE
+/**
+ * @brief Add 1 to a counter (boot, run hours, cycles), read back with u8EEPROM_eReadVar and set with u8EEPROM_eWriteVar
+ * @note most increments clear one more bit of the tally of the counter in place, a new tally and base packet
+ *       are appended on its first increment, after COUNTER_TALLY_BITS increments and after a u8EEPROM_eWriteVar.
+ *       needs MCU_FLASH_BIT_REPROGRAM (EEPROM_COUNTER_ENABLE)
+ * @param Fu16VirtAddr Virtual address of the counter, a variable never written counts from 0
+ * @param Fpu32Value Pointer to store the new value, may be NULL
+ * @return Status code indicating the result of the write operation
+ */
+uint8_t u8EEPROM_eIncrementCounter( uint16_t Fu16VirtAddr,
+                                    uint32_t * Fpu32Value );
+#endif
+
+
+/**
+ * @brief Read a record written by u8EEPROM_eWriteRecord
+ * @note lock-free with EEPROM_THREAD_SAFE_ENABLE (see u8EEPROM_eReadVar), Fpu8Data can be written more than once
+ * @param Fu16VirtAddr Virtual address of the record
+ * @param Fpu8Data Buffer to store the data
+ * @param Fu16MaxSize Size of the buffer in bytes
+ * @param Fpu16Size Pointer to store the size of the record (also set when the buffer is too small)
+ * @return Status code indicating the result of the read operation, Du8EEPROM_eBAD_PARAM if the buffer is too small,
+ *         Du8EEPROM_eREAD_ERROR if no record is stored at this address
+ */
+uint8_t u8EEPROM_eReadRecord( uint16_t Fu16VirtAddr,
+                              uint8_t * Fpu8Data,
+                              uint16_t Fu16MaxSize,
+                              uint16_t * Fpu16Size );
+
+
 /**
  * @brief Read a variable from the EEPROM based on the virtual address
+ * @note with EEPROM_THREAD_SAFE_ENABLE the read does not wait for a running write or transfer,
+ *       it is retried if a page switch or an index update happened meanwhile
  * @param Fu16VirtAddr Virtual address of the variable to read
  * @param Fpu32Value Pointer to store the read value
  * @return Status code indicating the result of the read operation
@@ -114,23 +375,117 @@ uint8_t u8EEPROM_eCheckDataIntegrity( void );
 
 
 /**
- * @brief Read all variables from the EEPROM and store them in the provided array
+ * @brief Read all variables from the EEPROM and store them in the provided array, newest written first
+ * @note kept for the existing callers, u8EEPROM_eForEachVar does not need an array
  * @param Fu64arr Pointer to the array to store the read variables
  * @param u32MaArrSize Maximum size of the array
  * @param Fu32Size Pointer to a variable to store the actual size of the read variables
- * @return Status code indicating the result of the read operation
+ * @return Status code indicating the result of the read operation, Du8EEPROM_eBAD_PARAM if more than
+ *         u32MaArrSize variables are stored (the array holds the u32MaArrSize newest ones)
  */
 uint8_t u8EEPROM_eReadAllVar( Tst_EppromPacket * Fu64arr,
                               uint32_t u32MaArrSize,
                               uint32_t * Fu32Size );
 
+/**
+ * @brief Walk the pages once, from the newest packet, and call FpfVisit once per stored variable with its newest value
+ * @note the writers are held off during the walk. records are not visited
+ * @param FpfVisit Visitor, returns FALSE to stop the walk
+ * @param FpvContext Passed to FpfVisit
+ * @return Status code indicating the result of the walk, Du8EEPROM_eDATA_CORRUPTED if the newest copy
+ *         of a variable is corrupted (the variable is not visited, the walk goes on)
+ */
+uint8_t u8EEPROM_eForEachVar( Tpf_EepromVarVisitor FpfVisit,
+                              void * FpvContext );
+
+/**
+ * @brief Load the variables of the virtual addresses Fu16FirstVirtAddr to Fu16FirstVirtAddr + Fu32NbVars - 1 in a table
+ *        indexed by virtual address (one walk of the pages, the table is sorted by construction)
+ * @note Fpst[ n ] is the variable Fu16FirstVirtAddr + n, its u16VirtAddr is 0 if it is not stored.
+ *       the other stored variables are ignored
+ * @param Fu16FirstVirtAddr Virtual address of the first entry of the table
+ * @param Fpst Table of Fu32NbVars entries
+ * @param Fu32NbVars Number of entries
+ * @param Fpu32NbStored Pointer to store the number of entries found in the EEPROM (can be NULL)
+ * @return Status code indicating the result of the read operation (see u8EEPROM_eForEachVar)
+ */
+uint8_t u8EEPROM_eReadSnapshot( uint16_t Fu16FirstVirtAddr,
+                                Tst_EppromPacket * Fpst,
+                                uint32_t Fu32NbVars,
+                                uint32_t * Fpu32NbStored );
+
+/**
+ * @brief Serialize the newest copy of every variable and record in an image (counters are folded)
+ * @note a buffer of EEPROM_IMAGE_SIZE( MAX_EEPROM_VARIABLES ) bytes takes any image
+ * @param Fpu8Image Buffer receiving the image
+ * @param Fu32MaxSize Size of the buffer
+ * @param Fpu32Size Pointer to store the size of the image
+ * @return Status code indicating the result of the operation, Du8EEPROM_eBAD_PARAM if the buffer is too small,
+ *         Du8EEPROM_eDATA_CORRUPTED if the newest copy of a variable is corrupted (left out of the image)
+ */
+uint8_t u8EEPROM_eExportImage( uint8_t * Fpu8Image,
+                               uint32_t Fu32MaxSize,
+                               uint32_t * Fpu32Size );
+
+/**
+ * @brief Replace the content of the EEPROM with an image (u8EEPROM_eExportImage): the pages are erased unless
+ *        they are blank, the image is programmed in one pass in the first page and read back, then its header is set
+ * @note faster than u8EEPROM_eFormat followed by a write per variable (factory provisioning). after a power loss
+ *       the next init finds the old content, the image or an EEPROM it formats, never a mix of them
+ * @param Fpu8Image Image
+ * @param Fu32Size Size of the image
+ * @return Status code indicating the result of the operation, Du8EEPROM_eBAD_PARAM if the image is not valid or does not
+ *         fit a page, Du8EEPROM_eDATA_CORRUPTED if its checksum is wrong (the EEPROM is not modified in both cases)
+ */
+uint8_t u8EEPROM_eImportImage( const uint8_t * Fpu8Image,
+                               uint32_t Fu32Size );
+
+/**
+ * @brief Run a slice of the pending page transfer (copy of the oldest page, then its erase)
+ * @note reads and writes keep working while a transfer is pending, a write that would run out of
+ *       space finishes the transfer itself
+ * @param Fu32MaxPackets Maximum number of source packets to process, TRANSFER_STEP_UNLIMITED to finish the transfer
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eTransferStep( uint32_t Fu32MaxPackets );
+
+/**
+ * @brief Check if a page transfer is pending
+ * @return TRUE if u8EEPROM_eTransferStep has work to do, FALSE otherwise
+ */
+BOOL bEEPROM_eIsTransferPending( void );
+
+/**
+ * @brief Get the number of variables that can be written before a write has to switch page or finish a transfer
+ * @note each of these writes costs EEPROM_WRITE_PROGRAMS packet programs (bounded time, e.g. for a brown-out handler),
+ *       without EEPROM_LAZY_FREE_ENABLE nor EEPROM_RAM_INDEX_ENABLE the free also scans the pages for the older copy
+ * @return Number of variables
+ */
+uint32_t u32EEPROM_eGetWriteBudget( void );
+
 /**
  * @brief Check if the EEPROM is erased
- * @return TRUE if both EEPROM pages (PAGE_0 and PAGE_1) are erased, FALSE otherwise
+ * @return TRUE if all EEPROM pages are erased, FALSE otherwise
  */
 BOOL bEEPROM_eIsEepromErased( void );
 
 
+#if EEPROM_STATS_ENABLE
+/**
+ * @brief Get the runtime statistics of the driver
+ * @note the slot usage of the active page is computed by this call (scan of the page)
+ * @param Fpst Pointer to store the statistics
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eGetStats( Tst_EepromStats * Fpst );
+
+/**
+ * @brief Reset the counters of the runtime statistics
+ */
+void vEEPROM_eResetStats( void );
+#endif
+
+
 /**
  * @brief Get the erase count of a specific EEPROM page
  * @param Fu8PageId ID of the EEPROM page
@@ -141,4 +496,228 @@ uint8_t u8EEPROM_iGetEraseCount( uint8_t Fu8PageId,
                                  uint32_t * Fpu32EraseCount );
 
 
+
+/*instance APIs: same as the functions above on the instance FpstInst, instances don't share any state
+ * (a transfer of one never copies or waits for the data of another)*/
+
+/**
+ * @brief Initialize an instance (see u8EEPROM_eInit)
+ * @param FpstInst Instance, its geometry and flash operations set (EEPROM_INSTANCE_INIT)
+ * @return Status code indicating the result of the initialization, Du8EEPROM_eBAD_PARAM if the geometry is not valid
+ */
+uint8_t u8EEPROM_eInstInit( Tst_EepromInstance * FpstInst );
+
+/**
+ * @brief Format an instance (see u8EEPROM_eFormat)
+ * @param FpstInst Instance
+ * @return Status code indicating the result of the formatting operation
+ */
+uint8_t u8EEPROM_eInstFormat( Tst_EepromInstance * FpstInst );
+
+/**
+ * @brief Write a variable to an instance (see u8EEPROM_eWriteVar)
+ * @param FpstInst Instance
+ * @param Fu16VirtAddr Virtual address of the variable to write
+ * @param Fu32Data Data value to write
+ * @return Status code indicating the result of the write operation
+ */
+uint8_t u8EEPROM_eInstWriteVar( Tst_EepromInstance * FpstInst,
+                                uint16_t Fu16VirtAddr,
+                                uint32_t Fu32Data );
+
+/**
+ * @brief Write several variables to an instance at once (see u8EEPROM_eWriteVars)
+ * @param FpstInst Instance
+ * @param Fpst Array of variables to write (u16VirtAddr, u32DataVal), u16CRC is ignored
+ * @param Fu32NbVars Number of entries in Fpst
+ * @return Status code indicating the result of the write operation
+ */
+uint8_t u8EEPROM_eInstWriteVars( Tst_EepromInstance * FpstInst,
+                                 const Tst_EppromPacket * Fpst,
+                                 uint32_t Fu32NbVars );
+
+/**
+ * @brief Write a record to an instance (see u8EEPROM_eWriteRecord)
+ * @param FpstInst Instance
+ * @param Fu16VirtAddr Virtual address of the record
+ * @param Fpu8Data Data to write
+ * @param Fu16Size Size of the data in bytes
+ * @return Status code indicating the result of the write operation
+ */
+uint8_t u8EEPROM_eInstWriteRecord( Tst_EepromInstance * FpstInst,
+                                   uint16_t Fu16VirtAddr,
+                                   const uint8_t * Fpu8Data,
+                                   uint16_t Fu16Size );
+
+#if EEPROM_COUNTER_ENABLE
+/**
+ * @brief Add 1 to a counter of an instance (see u8EEPROM_eIncrementCounter)
+ * @param FpstInst Instance
+ * @param Fu16VirtAddr Virtual address of the counter
+ * @param Fpu32Value Pointer to store the new value, may be NULL
+ * @return Status code indicating the result of the write operation
+ */
+uint8_t u8EEPROM_eInstIncrementCounter( Tst_EepromInstance * FpstInst,
+                                        uint16_t Fu16VirtAddr,
+                                        uint32_t * Fpu32Value );
+#endif
+
+/**
+ * @brief Read a record of an instance (see u8EEPROM_eReadRecord)
+ * @param FpstInst Instance
+ * @param Fu16VirtAddr Virtual address of the record
+ * @param Fpu8Data Buffer to store the data
+ * @param Fu16MaxSize Size of the buffer in bytes
+ * @param Fpu16Size Pointer to store the size of the record
+ * @return Status code indicating the result of the read operation
+ */
+uint8_t u8EEPROM_eInstReadRecord( Tst_EepromInstance * FpstInst,
+                                  uint16_t Fu16VirtAddr,
+                                  uint8_t * Fpu8Data,
+                                  uint16_t Fu16MaxSize,
+                                  uint16_t * Fpu16Size );
+
+/**
+ * @brief Read a variable of an instance (see u8EEPROM_eReadVar)
+ * @param FpstInst Instance
+ * @param Fu16VirtAddr Virtual address of the variable to read
+ * @param Fpu32Value Pointer to store the read value
+ * @return Status code indicating the result of the read operation
+ */
+uint8_t u8EEPROM_eInstReadVar( Tst_EepromInstance * FpstInst,
+                               uint16_t Fu16VirtAddr,
+                               uint32_t * Fpu32Value );
+
+/**
+ * @brief Check the data integrity of an instance (see u8EEPROM_eCheckDataIntegrity)
+ * @param FpstInst Instance
+ * @return Status code indicating the result of the data integrity check
+ */
+uint8_t u8EEPROM_eInstCheckDataIntegrity( Tst_EepromInstance * FpstInst );
+
+/**
+ * @brief Read all variables of an instance (see u8EEPROM_eReadAllVar)
+ * @param FpstInst Instance
+ * @param Fu64arr Pointer to the array to store the read variables
+ * @param u32MaArrSize Maximum size of the array
+ * @param Fu32Size Pointer to a variable to store the actual size of the read variables
+ * @return Status code indicating the result of the read operation
+ */
+uint8_t u8EEPROM_eInstReadAllVar( Tst_EepromInstance * FpstInst,
+                                  Tst_EppromPacket * Fu64arr,
+                                  uint32_t u32MaArrSize,
+                                  uint32_t * Fu32Size );
+
+/**
+ * @brief Visit the stored variables of an instance (see u8EEPROM_eForEachVar)
+ * @param FpstInst Instance
+ * @param FpfVisit Visitor, returns FALSE to stop the walk
+ * @param FpvContext Passed to FpfVisit
+ * @return Status code indicating the result of the walk
+ */
+uint8_t u8EEPROM_eInstForEachVar( Tst_EepromInstance * FpstInst,
+                                  Tpf_EepromVarVisitor FpfVisit,
+                                  void * FpvContext );
+
+/**
+ * @brief Load a range of variables of an instance in a table indexed by virtual address (see u8EEPROM_eReadSnapshot)
+ * @param FpstInst Instance
+ * @param Fu16FirstVirtAddr Virtual address of the first entry of the table
+ * @param Fpst Table of Fu32NbVars entries
+ * @param Fu32NbVars Number of entries
+ * @param Fpu32NbStored Pointer to store the number of entries found in the EEPROM (can be NULL)
+ * @return Status code indicating the result of the read operation
+ */
+uint8_t u8EEPROM_eInstReadSnapshot( Tst_EepromInstance * FpstInst,
+                                    uint16_t Fu16FirstVirtAddr,
+                                    Tst_EppromPacket * Fpst,
+                                    uint32_t Fu32NbVars,
+                                    uint32_t * Fpu32NbStored );
+
+/**
+ * @brief Serialize the variables and records of an instance in an image (see u8EEPROM_eExportImage)
+ * @param FpstInst Instance
+ * @param Fpu8Image Buffer receiving the image
+ * @param Fu32MaxSize Size of the buffer
+ * @param Fpu32Size Pointer to store the size of the image
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eInstExportImage( Tst_EepromInstance * FpstInst,
+                                   uint8_t * Fpu8Image,
+                                   uint32_t Fu32MaxSize,
+                                   uint32_t * Fpu32Size );
+
+/**
+ * @brief Replace the content of an instance with an image (see u8EEPROM_eImportImage)
+ * @param FpstInst Instance
+ * @param Fpu8Image Image
+ * @param Fu32Size Size of the image
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eInstImportImage( Tst_EepromInstance * FpstInst,
+                                   const uint8_t * Fpu8Image,
+                                   uint32_t Fu32Size );
+
+/**
+ * @brief Run a slice of the pending page transfer of an instance (see u8EEPROM_eTransferStep)
+ * @param FpstInst Instance
+ * @param Fu32MaxPackets Maximum number of source packets to process, TRANSFER_STEP_UNLIMITED to finish the transfer
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eInstTransferStep( Tst_EepromInstance * FpstInst,
+                                    uint32_t Fu32MaxPackets );
+
+/**
+ * @brief Check if a page transfer of an instance is pending
+ * @param FpstInst Instance
+ * @return TRUE if u8EEPROM_eInstTransferStep has work to do, FALSE otherwise
+ */
+BOOL bEEPROM_eInstIsTransferPending( Tst_EepromInstance * FpstInst );
+
+/**
+ * @brief Get the write budget of an instance (see u32EEPROM_eGetWriteBudget)
+ * @param FpstInst Instance
+ * @return Number of variables
+ */
+uint32_t u32EEPROM_eInstGetWriteBudget( Tst_EepromInstance * FpstInst );
+
+/**
+ * @brief Check if the pages of an instance are erased
+ * @param FpstInst Instance
+ * @return TRUE if all its pages are erased, FALSE otherwise
+ */
+BOOL bEEPROM_eInstIsEepromErased( Tst_EepromInstance * FpstInst );
+
+#if EEPROM_STATS_ENABLE
+/**
+ * @brief Get the runtime statistics of an instance (see u8EEPROM_eGetStats)
+ * @param FpstInst Instance
+ * @param Fpst Pointer to store the statistics
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eInstGetStats( Tst_EepromInstance * FpstInst,
+                                Tst_EepromStats * Fpst );
+
+/**
+ * @brief Reset the counters of the runtime statistics of an instance
+ * @param FpstInst Instance
+ */
+void vEEPROM_eInstResetStats( Tst_EepromInstance * FpstInst );
+#endif
+
+/**
+ * @brief Get the erase count of a page of an instance
+ * @param FpstInst Instance
+ * @param Fu8PageId ID of the page
+ * @param Fpu32EraseCount Pointer to store the erase count
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eInstGetEraseCount( Tst_EepromInstance * FpstInst,
+                                     uint8_t Fu8PageId,
+                                     uint32_t * Fpu32EraseCount );
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* EEPROM_EMUL_EEP_DRV_H_ */
@@ -0,0 +1,195 @@
+/*
+ * eeprom_drv.hpp
+ * fyras1
+ *
+ * header-only C++ front end of the driver: a partition is a type, its geometry is computed and checked
+ * at compile time and its flash operations come from a class of static functions (no weak symbols)
+ */
+
+#ifndef EEPROM_EMUL_EEP_DRV_HPP_
+#define EEPROM_EMUL_EEP_DRV_HPP_
+
+#include "eeprom_drv.h"
+
+#if ( __cplusplus < 201103L )
+    #error "eeprom_drv.hpp needs C++11"
+#endif
+
+namespace eeprom
+{
+
+/********************layout*************************/
+
+/*geometry of a partition: NB_EEPROM_PAGES consecutive flash sectors of PAGE_SIZE bytes from START_ADDR,
+ * page n is erased as MCU sector FIRST_SECTOR + n. the checks of bEEPROM_iIsGeometryValid, at compile time*/
+template< uint32_t START_ADDR, uint32_t PAGE_SIZE, uint8_t FIRST_SECTOR >
+struct Layout
+{
+    static constexpr uint32_t u32StartAddr = START_ADDR;
+    static constexpr uint32_t u32PageSize = PAGE_SIZE;
+    static constexpr uint8_t u8FirstSector = FIRST_SECTOR;
+    static constexpr uint32_t u32EndAddr = START_ADDR + ( PAGE_SIZE * NB_EEPROM_PAGES );
+    static constexpr uint32_t u32MaxVariables = ( PAGE_SIZE - PAGE_HEADER_SIZE ) / PACKET_SIZE; /*packets in a page body*/
+
+    static_assert( ( START_ADDR % PACKET_SIZE ) == 0U, "the partition must start on a packet boundary" );
+    static_assert( ( PAGE_SIZE % PACKET_SIZE ) == 0U, "the page size must be a multiple of PACKET_SIZE" );
+    static_assert( PAGE_SIZE > PAGE_HEADER_SIZE, "the page must hold its header" );
+    static_assert( PAGE_SIZE <= ( ( 0xFFFFU / NB_EEPROM_PAGES ) * PACKET_SIZE ), "the packet slots are 16 bits" );
+    static_assert( PAGE_SIZE <= EEPROM_TRANSFER_MAX_PAGE_SIZE, "the transfer bitmap is sized by EEPROM_TRANSFER_MAX_PAGE_SIZE" );
+    static_assert( u32MaxVariables > ( RECORD_PAYLOAD_SLOTS( EEPROM_RECORD_MAX_SIZE ) + 1U ), "a page must take the largest record" );
+    static_assert( u32EndAddr > START_ADDR, "the partition wraps around the address space" );
+};
+
+/*the partition of the C API (u8EEPROM_eInit...)*/
+typedef Layout< FLASH_EEPROM_START_ADDR, EEPROM_PAGE_SIZE, MCU_PAGE_0_FLASH_SECTOR > DefaultLayout;
+
+/********************flash backends*************************/
+
+/*a backend is a class of static functions, one per field of Tst_EepromFlashItf. this one is the MCU flash
+ * (eeprom_mcu_itf.h), a partition on another flash (external, simulated) brings its own class*/
+struct McuFlash
+{
+    static uint8_t u8SectorEraseStart( uint8_t Fu8Sector ) { return u8FLASH_ITF_eFlashSectorEraseStart( Fu8Sector ); }
+    static uint8_t u8EraseStatus( void ) { return u8FLASH_ITF_eFlashEraseStatus(); }
+    static void vEraseWaitHook( void ) { vFLASH_ITF_eEraseWaitHook(); }
+    static uint8_t u8Program( uint32_t Fu32Address,
+                              uint64_t Fu64Data,
+                              uint8_t Fu8WriteSizeBytes ) { return u8FLASH_ITF_FlashProgram( Fu32Address, Fu64Data, Fu8WriteSizeBytes ); }
+    static uint8_t u8ProgramBurst( uint32_t Fu32Address,
+                                   const uint64_t * Fpu64Data,
+                                   uint32_t Fu32NbPackets ) { return u8FLASH_ITF_eFlashProgramBurst( Fu32Address, Fpu64Data, Fu32NbPackets ); }
+    static void vSessionBegin( void ) { vFLASH_ITF_eSessionBegin(); }
+    static void vSessionEnd( void ) { vFLASH_ITF_eSessionEnd(); }
+    static void vMutexTake( void ) { vFLASH_ITF_eMutexTake(); }
+    static void vMutexGive( void ) { vFLASH_ITF_eMutexGive(); }
+};
+
+/*flash operations table of a backend, one constant per backend type (read-only memory)*/
+template< class FLASH_BACKEND >
+struct FlashTable
+{
+    static constexpr Tst_EepromFlashItf stItf =
+    {
+        &FLASH_BACKEND::u8SectorEraseStart,
+        &FLASH_BACKEND::u8EraseStatus,
+        &FLASH_BACKEND::vEraseWaitHook,
+        &FLASH_BACKEND::u8Program,
+        &FLASH_BACKEND::u8ProgramBurst,
+        &FLASH_BACKEND::vSessionBegin,
+        &FLASH_BACKEND::vSessionEnd,
+        &FLASH_BACKEND::vMutexTake,
+        &FLASH_BACKEND::vMutexGive,
+    };
+};
+
+template< class FLASH_BACKEND >
+constexpr Tst_EepromFlashItf FlashTable< FLASH_BACKEND >::stItf;
+
+/********************partition*************************/
+
+/*an emulated eeprom on the partition LAYOUT, run by the algorithms of eeprom_drv.c (u8EEPROM_eInst* on its
+ * own instance). e.g. a factory partition on the 128 KB sectors of the stm32f205, next to the default one
+ * (needs EEPROM_TRANSFER_MAX_PAGE_SIZE set to ( 128U * 1024U ), see the checks of Layout):
+ * static eeprom::EmulatedEeprom< eeprom::Layout< 0x08020000U, 128U * 1024U, FLASH_SECTOR_5 > > stFactory;
+ * the methods return the Du8EEPROM_e* codes of the C API*/
+template< class LAYOUT, class FLASH_BACKEND = McuFlash >
+class EmulatedEeprom
+{
+public:
+    typedef LAYOUT Layout;
+    typedef FLASH_BACKEND FlashBackend;
+
+    static constexpr uint32_t u32MaxVariables = LAYOUT::u32MaxVariables;
+
+    EmulatedEeprom( void ) : stInst()
+    {
+        stInst.u32StartAddr = LAYOUT::u32StartAddr;
+        stInst.u32PageSize = LAYOUT::u32PageSize;
+        stInst.u8FirstSector = LAYOUT::u8FirstSector;
+        stInst.pstFlash = &FlashTable< FLASH_BACKEND >::stItf;
+    }
+
+    EmulatedEeprom( const EmulatedEeprom & ) = delete; /*the instance holds the RAM state of the partition*/
+    EmulatedEeprom & operator=( const EmulatedEeprom & ) = delete;
+
+    /**
+     * @brief Set the hook offered the live variables of the pages being compacted (see Tpf_EepromRelocate)
+     * @param FpfRelocate Hook, NULL to copy every live variable
+     */
+    void vSetRelocate( Tpf_EepromRelocate FpfRelocate ) { stInst.pfRelocate = FpfRelocate; }
+
+    uint8_t u8Init( void ) { return u8EEPROM_eInstInit( &stInst ); }
+    uint8_t u8Format( void ) { return u8EEPROM_eInstFormat( &stInst ); }
+
+    uint8_t u8WriteVar( uint16_t Fu16VirtAddr,
+                        uint32_t Fu32Data ) { return u8EEPROM_eInstWriteVar( &stInst, Fu16VirtAddr, Fu32Data ); }
+
+    uint8_t u8WriteVars( const Tst_EppromPacket * Fpst,
+                         uint32_t Fu32NbVars ) { return u8EEPROM_eInstWriteVars( &stInst, Fpst, Fu32NbVars ); }
+
+    uint8_t u8WriteRecord( uint16_t Fu16VirtAddr,
+                           const uint8_t * Fpu8Data,
+                           uint16_t Fu16Size ) { return u8EEPROM_eInstWriteRecord( &stInst, Fu16VirtAddr, Fpu8Data, Fu16Size ); }
+
+    #if EEPROM_COUNTER_ENABLE
+        uint8_t u8IncrementCounter( uint16_t Fu16VirtAddr,
+                                    uint32_t * Fpu32Value ) { return u8EEPROM_eInstIncrementCounter( &stInst, Fu16VirtAddr, Fpu32Value ); }
+    #endif
+
+    uint8_t u8ReadVar( uint16_t Fu16VirtAddr,
+                       uint32_t * Fpu32Value ) { return u8EEPROM_eInstReadVar( &stInst, Fu16VirtAddr, Fpu32Value ); }
+
+    uint8_t u8ReadRecord( uint16_t Fu16VirtAddr,
+                          uint8_t * Fpu8Data,
+                          uint16_t Fu16MaxSize,
+                          uint16_t * Fpu16Size ) { return u8EEPROM_eInstReadRecord( &stInst, Fu16VirtAddr, Fpu8Data, Fu16MaxSize, Fpu16Size ); }
+
+    uint8_t u8ReadAllVar( Tst_EppromPacket * Fpst,
+                          uint32_t Fu32MaxArrSize,
+                          uint32_t * Fpu32Size ) { return u8EEPROM_eInstReadAllVar( &stInst, Fpst, Fu32MaxArrSize, Fpu32Size ); }
+
+    uint8_t u8ForEachVar( Tpf_EepromVarVisitor FpfVisit,
+                          void * FpvContext ) { return u8EEPROM_eInstForEachVar( &stInst, FpfVisit, FpvContext ); }
+
+    uint8_t u8ReadSnapshot( uint16_t Fu16FirstVirtAddr,
+                            Tst_EppromPacket * Fpst,
+                            uint32_t Fu32NbVars,
+                            uint32_t * Fpu32NbStored ) { return u8EEPROM_eInstReadSnapshot( &stInst, Fu16FirstVirtAddr, Fpst, Fu32NbVars, Fpu32NbStored ); }
+
+    uint8_t u8ExportImage( uint8_t * Fpu8Image,
+                           uint32_t Fu32MaxSize,
+                           uint32_t * Fpu32Size ) { return u8EEPROM_eInstExportImage( &stInst, Fpu8Image, Fu32MaxSize, Fpu32Size ); }
+
+    uint8_t u8ImportImage( const uint8_t * Fpu8Image,
+                           uint32_t Fu32Size ) { return u8EEPROM_eInstImportImage( &stInst, Fpu8Image, Fu32Size ); }
+
+    uint8_t u8CheckDataIntegrity( void ) { return u8EEPROM_eInstCheckDataIntegrity( &stInst ); }
+    uint8_t u8TransferStep( uint32_t Fu32MaxPackets ) { return u8EEPROM_eInstTransferStep( &stInst, Fu32MaxPackets ); }
+    BOOL bIsTransferPending( void ) { return bEEPROM_eInstIsTransferPending( &stInst ); }
+    uint32_t u32GetWriteBudget( void ) { return u32EEPROM_eInstGetWriteBudget( &stInst ); }
+    BOOL bIsEepromErased( void ) { return bEEPROM_eInstIsEepromErased( &stInst ); }
+
+    uint8_t u8GetEraseCount( uint8_t Fu8PageId,
+                             uint32_t * Fpu32EraseCount ) { return u8EEPROM_eInstGetEraseCount( &stInst, Fu8PageId, Fpu32EraseCount ); }
+
+    #if EEPROM_STATS_ENABLE
+        uint8_t u8GetStats( Tst_EepromStats * Fpst ) { return u8EEPROM_eInstGetStats( &stInst, Fpst ); }
+        void vResetStats( void ) { vEEPROM_eInstResetStats( &stInst ); }
+    #endif
+
+    /**
+     * @brief Get the C instance of the partition, for the C API (u8EEPROM_eInst*)
+     * @return Instance
+     */
+    Tst_EepromInstance * pstInstance( void ) { return &stInst; }
+
+private:
+    Tst_EepromInstance stInst;
+};
+
+template< class LAYOUT, class FLASH_BACKEND >
+constexpr uint32_t EmulatedEeprom< LAYOUT, FLASH_BACKEND >::u32MaxVariables;
+
+} /* namespace eeprom */
+
+#endif /* EEPROM_EMUL_EEP_DRV_HPP_ */
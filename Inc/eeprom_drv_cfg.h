@@ -8,17 +8,35 @@
 #ifndef EEPROM_EMUL_INC_EEP_DRV_CFG_H_
 #define EEPROM_EMUL_INC_EEP_DRV_CFG_H_
 
+/*every setting below can be overridden from the compiler command line (-DNAME=value)*/
 
+#ifndef IS_FREERTOS_USED
+    #define IS_FREERTOS_USED				( 0U )
+#endif
 
-#define IS_FREERTOS_USED				( 0U )
+/*map to NB_EEPROM_PAGES consecutive flash blocks with identical size,
+ * page n uses the MCU sector MCU_PAGE_0_FLASH_SECTOR + n (see eeprom_mcu_itf.h)*/
+#ifndef PAGE_0_FLASH_SECTOR
+    #define PAGE_0_FLASH_SECTOR            ( 0x08008000U ) /*FLASh_SECTOR_2 for stm32f205*/
+#endif
+#ifndef PAGE_1_FLASH_SECTOR
+    #define PAGE_1_FLASH_SECTOR            ( 0x0800C000U ) /*FLASh_SECTOR_3 for stm32f205*/
+#endif
+#ifndef EEPROM_PAGE_SIZE
+    #define EEPROM_PAGE_SIZE               ( 16U * 1024U )   /*for a 16KB flash block (stm32f205)*/
+#endif
 
-/*map to two flash blocks with identical size*/
-#define PAGE_0_FLASH_SECTOR            ( 0x08008000U ) /*FLASh_SECTOR_2 for stm32f205*/
-#define PAGE_1_FLASH_SECTOR            ( 0x0800C000U ) /*FLASh_SECTOR_3 for stm32f205*/
-#define EEPROM_PAGE_SIZE               ( 16U * 1024U )   /*for a 16KB flash block (stm32f205)*/
+/*pages form a ring: writes spill into the next page and only the oldest page is compacted,
+ * when the last erased page is opened. more pages => erases spread over more sectors and
+ * less live data copied per compaction (minimum 2)*/
+#ifndef NB_EEPROM_PAGES
+    #define NB_EEPROM_PAGES                ( 2U )
+#endif
 
 
-#define FLASH_EEPROM_START_ADDR    ( PAGE_0_FLASH_SECTOR ) /*map to your desired eeprom start block*/
+#ifndef FLASH_EEPROM_START_ADDR
+    #define FLASH_EEPROM_START_ADDR    ( PAGE_0_FLASH_SECTOR ) /*map to your desired eeprom start block*/
+#endif
 
 /*if you want to change STATUS values, make sure the new values can go from state
  * ERASED -> RECEIVING -> ACTIVE by only writing zeros (0) to their binary representations
@@ -28,7 +46,186 @@
 #define PAGE_STATUS_ACTIVE         ( 0x00000000 )
 
 /* reads value after each write and verifies that it write wasn't corrupted, it will try to write it in another adress*/
-#define WRITE_CORRECTION_ENABLE    ( 1U )
+#ifndef WRITE_CORRECTION_ENABLE
+    #define WRITE_CORRECTION_ENABLE    ( 1U )
+#endif
+
+/* number of packets after the first empty packet found by the boot binary search that must be empty too,
+ * a non empty packet in this window means the empty one was a hole (torn/stray write) and the search continues*/
+#ifndef EEPROM_WRITE_POINTER_CHECK_WINDOW
+    #define EEPROM_WRITE_POINTER_CHECK_WINDOW    ( 4U )
+#endif
+
+/* page transfers are split in steps run by u8EEPROM_eTransferStep (e.g. from an idle task) instead of
+ * blocking the write that fills the page. 0 => the whole transfer runs inside that write*/
+#ifndef EEPROM_INCREMENTAL_TRANSFER_ENABLE
+    #define EEPROM_INCREMENTAL_TRANSFER_ENABLE    ( 1U )
+#endif
+/* the switch to the page receiving the transfer is done when this many free packets are left
+ * in the active page, so the copy starts before the page is completely full*/
+#ifndef EEPROM_TRANSFER_START_THRESHOLD
+    #define EEPROM_TRANSFER_START_THRESHOLD       ( 64U )
+#endif
+/* packets copied by the page transfer are gathered in a RAM buffer (8 bytes each, stack)
+ * and programmed as one burst in the native program unit of the flash (MCU_FLASH_PROGRAM_UNIT)*/
+#ifndef EEPROM_TRANSFER_BURST_PACKETS
+    #define EEPROM_TRANSFER_BURST_PACKETS         ( 16U )
+#endif
+/* the page transfer marks the packets to copy in a RAM bitmap of the page (1 bit per packet, in each
+ * instance), sized for the largest page of the instances: an instance with larger pages fails its init
+ * (see EEPROM_INSTANCE_INIT)*/
+#ifndef EEPROM_TRANSFER_MAX_PAGE_SIZE
+    #define EEPROM_TRANSFER_MAX_PAGE_SIZE         ( EEPROM_PAGE_SIZE )
+#endif
+/* a copied burst is read back, when it doesn't match it is freed and the copy of the page starts again,
+ * at most this many times before the transfer reports a write error (the page is kept)*/
+#ifndef EEPROM_TRANSFER_VERIFY_RETRIES
+    #define EEPROM_TRANSFER_VERIFY_RETRIES        ( 2U )
+#endif
+
+/* superseded packets are left in place instead of being programmed to FREED_PACKET on each write,
+ * the newest copy of a variable is resolved by the read path and by the page transfer.
+ * with 0, a free cut by a power loss leaves a random part of the old packet cleared, EEPROM_CRC_ADDITIVE often
+ * takes it for a newer copy of another variable: use a CRC engine (EEPROM_CRC_ENGINE) then*/
+#ifndef EEPROM_LAZY_FREE_ENABLE
+    #define EEPROM_LAZY_FREE_ENABLE    ( 1U )
+#endif
+
+/* keeps a RAM table (virtual address -> flash slot) of the active page so reads don't scan the page*/
+#ifndef EEPROM_RAM_INDEX_ENABLE
+    #define EEPROM_RAM_INDEX_ENABLE    ( 1U )
+#endif
+/* number of distinct virtual addresses the index can hold (power of 2, 4 bytes of RAM each)
+ * if more variables are stored, reads of the missing ones fall back to a page scan*/
+#ifndef EEPROM_RAM_INDEX_SIZE
+    #define EEPROM_RAM_INDEX_SIZE      ( 256U )
+#endif
+
+/* checksum of the packets:
+ *  EEPROM_CRC_ADDITIVE : 16 bits sum of address and data halves (format of the first versions, misses many bit flips)
+ *  EEPROM_CRC_CCITT    : CRC-16/CCITT (poly 0x1021, init 0xFFFF) by tables, EEPROM_CRC_SLICES bytes per lookup step
+ *  EEPROM_CRC_HW       : CRC unit of the MCU (stm32f2: fixed CRC-32, its low 16 bits are stored), see eeprom_mcu_itf.h
+ *  EEPROM_CRC_NONE     : no check, torn and corrupted packets are not detected
+ * the default stays EEPROM_CRC_ADDITIVE, the checksum of the packets already stored by devices in the field.
+ * WARNING: packets written with another engine read as corrupted and the next page transfer drops them, the
+ * stored data is lost. change the engine on new products only, or format the eeprom when changing it*/
+#define EEPROM_CRC_ADDITIVE                  ( 0U )
+#define EEPROM_CRC_CCITT                     ( 1U )
+#define EEPROM_CRC_HW                        ( 2U )
+#define EEPROM_CRC_NONE                      ( 3U )
+#ifndef EEPROM_CRC_ENGINE
+    #define EEPROM_CRC_ENGINE                    ( EEPROM_CRC_ADDITIVE )
+#endif
+/* 1, 2 or 4 tables of 512 bytes (flash), more tables => fewer dependent lookups per packet*/
+#ifndef EEPROM_CRC_SLICES
+    #define EEPROM_CRC_SLICES                    ( 4U )
+#endif
+/* adds u32EEPROM_eCrcBenchmark (packets verified per second) to compare the engines on the target*/
+#ifndef EEPROM_CRC_BENCHMARK_ENABLE
+    #define EEPROM_CRC_BENCHMARK_ENABLE          ( 0U )
+#endif
+
+/* max size in bytes of a record (u8EEPROM_eWriteRecord), a record takes 1 + size / 6 (rounded up) packets.
+ * the virtual address 0xFFFE is reserved for the record payload*/
+#ifndef EEPROM_RECORD_MAX_SIZE
+    #define EEPROM_RECORD_MAX_SIZE     ( 240U )
+#endif
+
+/* counters (u8EEPROM_eIncrementCounter): an increment clears one more bit of a tally packet in place,
+ * needs MCU_FLASH_BIT_REPROGRAM (set to 0 on stm32l4/g4, plain u8EEPROM_eWriteVar there)*/
+#ifndef EEPROM_COUNTER_ENABLE
+    #define EEPROM_COUNTER_ENABLE      ( 1U )
+#endif
+
+/* runtime statistics (u8EEPROM_eGetStats): flash operations, lookup scan lengths, worst write latency,
+ * slot usage of the active page and erase count of each page. 0 => no code and no RAM*/
+#ifndef EEPROM_STATS_ENABLE
+    #define EEPROM_STATS_ENABLE                  ( 0U )
+#endif
+
+/* several tasks using the eeprom: the writers (init, format, writes, transfer steps) are serialized on a mutex
+ * (vFLASH_ITF_eMutexTake/Give, a FreeRTOS recursive mutex with IS_FREERTOS_USED) and u8EEPROM_eReadVar /
+ * u8EEPROM_eReadRecord don't take it: a sequence counter is bumped around the page switches and index updates
+ * and a read that overlaps one is retried. the cache API below is not covered (one task only)*/
+#ifndef EEPROM_THREAD_SAFE_ENABLE
+    #define EEPROM_THREAD_SAFE_ENABLE            ( 0U )
+#endif
+/* lock-free attempts of a read before it waits on the writer mutex (e.g. it preempted a writer in an update)*/
+#ifndef EEPROM_READ_RETRIES
+    #define EEPROM_READ_RETRIES                  ( 4U )
+#endif
+
+/* RAM write-back cache over the write/read APIs (eeprom_cache.h): writes of an unchanged value are dropped,
+ * repeated writes are coalesced and dirty variables reach the flash on commit, interval or threshold*/
+#ifndef EEPROM_CACHE_ENABLE
+    #define EEPROM_CACHE_ENABLE                  ( 0U )
+#endif
+/* number of cached variables (8 bytes of RAM each)*/
+#ifndef EEPROM_CACHE_SIZE
+    #define EEPROM_CACHE_SIZE                    ( 32U )
+#endif
+/* dirty variables that trigger a flush from the write itself*/
+#ifndef EEPROM_CACHE_FLUSH_THRESHOLD
+    #define EEPROM_CACHE_FLUSH_THRESHOLD         ( 24U )
+#endif
+/* max age in ms of the oldest unflushed write, checked by u8EEPROM_eCacheTick. 0 => no periodic flush*/
+#ifndef EEPROM_CACHE_FLUSH_INTERVAL_MS
+    #define EEPROM_CACHE_FLUSH_INTERVAL_MS       ( 1000U )
+#endif
+
+/* hot/cold split over the variable API (eeprom_hotcold.h): the variables written often live in a small hot region
+ * compacted often, the others in the eeprom above (cold region) which is compacted rarely. a variable is hot when
+ * declared so (u8EEPROM_eHotColdDeclare) or when it was written EEPROM_HOTCOLD_HOT_SCORE times recently, the hot
+ * compaction moves the variables that cooled down to the cold region instead of copying them*/
+#ifndef EEPROM_HOTCOLD_ENABLE
+    #define EEPROM_HOTCOLD_ENABLE                ( 0U )
+#endif
+/* hot region: NB_EEPROM_PAGES sectors of EEPROM_HOT_PAGE_SIZE bytes from EEPROM_HOT_START_ADDR, on the MCU flash*/
+#ifndef EEPROM_HOT_START_ADDR
+    #define EEPROM_HOT_START_ADDR                ( FLASH_EEPROM_START_ADDR + ( NB_EEPROM_PAGES * EEPROM_PAGE_SIZE ) )
+#endif
+#ifndef EEPROM_HOT_PAGE_SIZE
+    #define EEPROM_HOT_PAGE_SIZE                 ( EEPROM_PAGE_SIZE )
+#endif
+#ifndef EEPROM_HOT_FIRST_SECTOR
+    #define EEPROM_HOT_FIRST_SECTOR              ( MCU_PAGE_0_FLASH_SECTOR + NB_EEPROM_PAGES )
+#endif
+/* number of variables whose write rate is tracked (6 bytes of RAM each), declared ones included*/
+#ifndef EEPROM_HOTCOLD_TRACK_SIZE
+    #define EEPROM_HOTCOLD_TRACK_SIZE            ( 64U )
+#endif
+/* score (writes, halved every EEPROM_HOTCOLD_DECAY_WRITES writes) from which a variable is hot*/
+#ifndef EEPROM_HOTCOLD_HOT_SCORE
+    #define EEPROM_HOTCOLD_HOT_SCORE             ( 4U )
+#endif
+#ifndef EEPROM_HOTCOLD_DECAY_WRITES
+    #define EEPROM_HOTCOLD_DECAY_WRITES          ( 1024U )
+#endif
+
+/* typed variable registry (eeprom_registry.h) over the variable API: the variables of EEPROM_REGISTRY get typed
+ * accessors, a default value while they were never written and a RAM copy so reads don't touch the flash.
+ * the small fields of a slot share one packet (read-modify-write on write)*/
+#ifndef EEPROM_REGISTRY_ENABLE
+    #define EEPROM_REGISTRY_ENABLE               ( 0U )
+#endif
+/* SLOT( NAME, VIRT_ADDR )               : packet holding the FIELDs declared right after it, packed from bit 0 (32 bits)
+ * FIELD( SLOT, NAME, TYPE, DEFAULT )    : BOOL (1 bit), U8 or U16 field of SLOT
+ * VAR( NAME, TYPE, VIRT_ADDR, DEFAULT ) : U32, I32 or FLOAT variable in its own packet
+ * accessors: u8EEPROM_eRegGet<NAME>( &value ) and u8EEPROM_eRegSet<NAME>( value ). the virtual addresses of the
+ * registry must not be written by the other APIs.
+ * the application defines EEPROM_REGISTRY in its own header, included here by EEPROM_REGISTRY_FILE
+ * (-DEEPROM_REGISTRY_FILE='"app_eeprom_registry.h"'), e.g. :
+ *  #define EEPROM_REGISTRY( SLOT, FIELD, VAR )             \
+ *      SLOT( Settings, 0x0100U )                           \
+ *      FIELD( Settings, LedOn, BOOL, TRUE )                \
+ *      FIELD( Settings, Brightness, U8, 128U )             \
+ *      VAR( BootCount, U32, 0x0101U, 0U )                  \
+ *      VAR( TempOffset, I32, 0x0102U, -5 )                 \
+ *      VAR( SensorGain, FLOAT, 0x0103U, 1.0f )
+ */
+#ifdef EEPROM_REGISTRY_FILE
+    #include EEPROM_REGISTRY_FILE
+#endif
 
 
 typedef uint8_t BOOL;
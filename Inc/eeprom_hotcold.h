@@ -0,0 +1,108 @@
+/*
+ * eeprom_hotcold.h
+ * fyras1
+ *
+ * hot/cold split of the variables: the ones written often go to a small hot region (its own instance)
+ * so the compactions of the cold region (the default instance) stop copying constants over and over
+ */
+
+#ifndef EEPROM_EMUL_EEP_HOTCOLD_H_
+#define EEPROM_EMUL_EEP_HOTCOLD_H_
+
+#include "eeprom_drv.h"
+
+#if EEPROM_HOTCOLD_ENABLE
+
+/********************typedefs*************************/
+typedef enum
+{
+    EEPROM_KEY_AUTO, /*hot or cold from its write rate*/
+    EEPROM_KEY_HOT,
+    EEPROM_KEY_COLD,
+} EEpromKeyClassTypedef;
+
+typedef struct
+{
+    uint16_t u16VirtAddr; /*0 = unused entry*/
+    uint8_t u8Class;      /*EEpromKeyClassTypedef*/
+    uint8_t u8Score;      /*writes, halved every EEPROM_HOTCOLD_DECAY_WRITES writes*/
+    BOOL bMoving;         /*moved to the cold region by the running hot transfer, still written to the hot region*/
+} Tst_EepromKeyTrack;
+
+/*********************Prototypes**************************/
+
+/**
+ * @brief Initialize the cold region (u8EEPROM_eInit) and the hot region, forget the learned write rates
+ * @note declare the variables with a fixed class before, a pending hot transfer may move variables at init
+ * @return Status code indicating the result of the initialization
+ */
+uint8_t u8EEPROM_eHotColdInit( void );
+
+/**
+ * @brief Format the cold and the hot regions, forget the learned write rates
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eHotColdFormat( void );
+
+/**
+ * @brief Set the class of a variable instead of learning it from its write rate
+ * @param Fu16VirtAddr Virtual address of the variable
+ * @param FeClass EEPROM_KEY_HOT, EEPROM_KEY_COLD or EEPROM_KEY_AUTO to learn it again
+ * @return Status code indicating the result of the operation, Du8EEPROM_eERROR if the tracking table is full
+ */
+uint8_t u8EEPROM_eHotColdDeclare( uint16_t Fu16VirtAddr,
+                                  EEpromKeyClassTypedef FeClass );
+
+/**
+ * @brief Write a variable to the region of its class
+ * @note a variable still stored in the hot region is written there until a hot transfer moves it out
+ * @param Fu16VirtAddr Virtual address of the variable to write
+ * @param Fu32Data Data value to write
+ * @return Status code indicating the result of the write operation
+ */
+uint8_t u8EEPROM_eHotColdWriteVar( uint16_t Fu16VirtAddr,
+                                   uint32_t Fu32Data );
+
+/**
+ * @brief Read a variable, from the hot region first
+ * @param Fu16VirtAddr Virtual address of the variable to read
+ * @param Fpu32Value Pointer to store the read value
+ * @return Status code indicating the result of the read operation
+ */
+uint8_t u8EEPROM_eHotColdReadVar( uint16_t Fu16VirtAddr,
+                                  uint32_t * Fpu32Value );
+
+/**
+ * @brief Run a slice of the pending transfers of the hot and the cold regions (see u8EEPROM_eTransferStep)
+ * @param Fu32MaxPackets Maximum number of source packets to process per region, TRANSFER_STEP_UNLIMITED to finish
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eHotColdTransferStep( uint32_t Fu32MaxPackets );
+
+/**
+ * @brief Check if a transfer of the hot or the cold region is pending
+ * @return TRUE if u8EEPROM_eHotColdTransferStep has work to do, FALSE otherwise
+ */
+BOOL bEEPROM_eHotColdIsTransferPending( void );
+
+/**
+ * @brief Check the current class of a variable
+ * @param Fu16VirtAddr Virtual address of the variable
+ * @return TRUE if its writes go to the hot region, FALSE otherwise
+ */
+BOOL bEEPROM_eHotColdIsHot( uint16_t Fu16VirtAddr );
+
+#if EEPROM_STATS_ENABLE
+/**
+ * @brief Get the runtime statistics of both regions (see u8EEPROM_eGetStats)
+ * @param FpstHot Pointer to store the statistics of the hot region
+ * @param FpstCold Pointer to store the statistics of the cold region
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eHotColdGetStats( Tst_EepromStats * FpstHot,
+                                   Tst_EepromStats * FpstCold );
+#endif
+
+#endif /* EEPROM_HOTCOLD_ENABLE */
+
+#endif /* EEPROM_EMUL_EEP_HOTCOLD_H_ */
@@ -5,17 +5,147 @@
 
 #include "stdint.h"
 #include "stm32f2xx_hal.h"
+#include "eeprom_drv_cfg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 #define MCU_PAGE_0_FLASH_SECTOR    (FLASH_SECTOR_2) /*FLASh_SECTOR_2 for stm32f2*/
 #define MCU_PAGE_1_FLASH_SECTOR    (FLASH_SECTOR_3) /*FLASh_SECTOR_3 for stm32f2*/
+/*eeprom page n is erased as sector MCU_PAGE_0_FLASH_SECTOR + n, the NB_EEPROM_PAGES sectors must be consecutive*/
+
+/*bytes per flash program operation : 4 for stm32f2 (2.7V-3.6V), 8 for stm32f2 with external Vpp (x64, with
+ * MCU_FLASH_VOLTAGE_RANGE at FLASH_VOLTAGE_RANGE_4). every field of the page headers takes a whole unit*/
+#ifndef MCU_FLASH_PROGRAM_UNIT
+    #define MCU_FLASH_PROGRAM_UNIT     ( 4U )
+#endif
+#ifndef MCU_FLASH_VOLTAGE_RANGE
+    #define MCU_FLASH_VOLTAGE_RANGE    (FLASH_VOLTAGE_RANGE_3) /*FLASH_VOLTAGE_RANGE_4 with external Vpp on stm32f2 (x64 program and erase)*/
+#endif
+/*1 when a programmed word accepts a second program clearing more of its bits : 1 for stm32f2,
+ * 0 for an ECC flash where a written double word only takes all zeros (stm32l4/g4, with this file ported to
+ * their HAL): needs MCU_FLASH_PROGRAM_UNIT 8 and EEPROM_COUNTER_ENABLE 0, every other program of the driver
+ * writes an erased unit or clears a written one*/
+#ifndef MCU_FLASH_BIT_REPROGRAM
+    #define MCU_FLASH_BIT_REPROGRAM    ( 1U )
+#endif
+
+#if ( MCU_FLASH_PROGRAM_UNIT != 4U ) && ( MCU_FLASH_PROGRAM_UNIT != 8U )
+    #error "MCU_FLASH_PROGRAM_UNIT must be 4 or 8 (a packet is 8 bytes and is programmed alone)"
+#endif
+#if ( MCU_FLASH_BIT_REPROGRAM == 0U ) && ( MCU_FLASH_PROGRAM_UNIT != 8U )
+    #error "an ECC flash programs double words, the page headers need MCU_FLASH_PROGRAM_UNIT 8 to be written once"
+#endif
+
+/*"size of array is negative": FLASH_TYPEPROGRAM_DOUBLEWORD fails on stm32f2 without the external Vpp
+ * (the HAL voltage ranges are casts, #if can't compare them)*/
+typedef uint8_t Tau8FLASH_ITF_iUnitNeedsVpp[ ( ( MCU_FLASH_PROGRAM_UNIT != 8U ) ||
+                                               ( MCU_FLASH_VOLTAGE_RANGE == FLASH_VOLTAGE_RANGE_4 ) ) ? 1 : -1 ];
 
 
 /**
  * @brief Erase a sector of the MCU flash memory
- * @param Page Page number of the sector to erase
+ * @param Fu8Sector MCU sector to erase
  * @return Status code indicating the result of the erase operation
  */
-uint8_t u8FLASH_ITF_eFlashSectorErase( uint8_t Page );
+uint8_t u8FLASH_ITF_eFlashSectorErase( uint8_t Fu8Sector );
+
+
+/*status of the background sector erase*/
+#define FLASH_ITF_ERASE_DONE     ( 0U )
+#define FLASH_ITF_ERASE_BUSY     ( 1U )
+#define FLASH_ITF_ERASE_ERROR    ( 2U )
+
+/**
+ * @brief Start the erase of a sector of the MCU flash memory and return without waiting for it
+ * @note interrupts stay enabled during the erase. on single bank MCUs (stm32f2) any fetch from the flash
+ *       stalls until the erase ends, only code and data in RAM keep running meanwhile
+ * @param Fu8Sector MCU sector to erase
+ * @return Status code indicating the result of the operation : 0 OK ; 1 NOT OK
+ */
+uint8_t u8FLASH_ITF_eFlashSectorEraseStart( uint8_t Fu8Sector );
+
+
+/**
+ * @brief Get the status of the erase started by u8FLASH_ITF_eFlashSectorEraseStart
+ * @note completion is reported by the flash end of operation interrupt (HAL_FLASH_IRQHandler called from
+ *       FLASH_IRQHandler), or by this function itself when the interrupt is not enabled (polling)
+ * @return FLASH_ITF_ERASE_DONE, FLASH_ITF_ERASE_BUSY or FLASH_ITF_ERASE_ERROR
+ */
+uint8_t u8FLASH_ITF_eFlashEraseStatus( void );
+
+
+/**
+ * @brief End the background erase, to be called from the HAL callbacks of the flash interrupt
+ * @note eeprom_mcu_itf.c defines weak HAL_FLASH_EndOfOperationCallback and HAL_FLASH_OperationErrorCallback that
+ *       only call this function: an application with its own callbacks calls it from them. the HAL defines empty
+ *       weak ones as well, define them in the application if the link keeps those
+ * @param Fu32ReturnValue ReturnValue of the HAL callback: sector erased, 0xFFFFFFFF once all the sectors are erased
+ * @param FbError TRUE from HAL_FLASH_OperationErrorCallback, FALSE from HAL_FLASH_EndOfOperationCallback
+ */
+void vFLASH_ITF_eEraseIrqDone( uint32_t Fu32ReturnValue,
+                               BOOL FbError );
+
+
+/**
+ * @brief Called in loop while the driver has to wait for the end of an erase (e.g. yield to other tasks)
+ */
+void vFLASH_ITF_eEraseWaitHook( void );
+
+
+/**
+ * @brief Compute a CRC with the CRC unit of the MCU (EEPROM_CRC_HW)
+ * @note stm32f2: CRC-32 (poly 0x04C11DB7, init 0xFFFFFFFF) on 32 bits words, the unit is reset on each call
+ *       so it must not be shared with an interrupted computation of the application
+ * @param Fpu32Words Words to feed
+ * @param Fu32NbWords Number of words
+ * @return CRC of the words
+ */
+uint32_t u32FLASH_ITF_eHwCrc32( const uint32_t * Fpu32Words,
+                                uint32_t Fu32NbWords );
+
+
+/**
+ * @brief Get a millisecond tick (EEPROM_CRC_BENCHMARK_ENABLE)
+ * @return Current time in ms
+ */
+uint32_t u32FLASH_ITF_eGetTickMs( void );
+
+
+/**
+ * @brief Get a free running timestamp for the latency statistics (EEPROM_STATS_ENABLE)
+ * @note stm32f2: CPU cycles of the DWT cycle counter, enabled by the first call
+ * @return Current timestamp, may wrap around
+ */
+uint32_t u32FLASH_ITF_eGetTimestamp( void );
+
+
+/**
+ * @brief Open a programming session: the flash stays unlocked until the matching vFLASH_ITF_eSessionEnd
+ * @note sessions can be nested, the program and erase functions skip their own unlock/lock inside a session
+ */
+void vFLASH_ITF_eSessionBegin( void );
+
+
+/**
+ * @brief Close a programming session, the flash is locked again when the outermost session ends
+ *        (or at the end of a background erase still running)
+ */
+void vFLASH_ITF_eSessionEnd( void );
+
+
+/**
+ * @brief Take the mutex serializing the writers of the driver (EEPROM_THREAD_SAFE_ENABLE)
+ * @note must be recursive: a writer can call another public function (e.g. u8EEPROM_eInit -> u8EEPROM_eFormat)
+ */
+void vFLASH_ITF_eMutexTake( void );
+
+
+/**
+ * @brief Release the mutex taken by vFLASH_ITF_eMutexTake
+ */
+void vFLASH_ITF_eMutexGive( void );
 
 
 /**
@@ -30,4 +160,20 @@ uint8_t u8FLASH_ITF_FlashProgram( uint32_t Fu32Address,
                                   uint8_t fu8WriteSizeBytes );
 
 
+/**
+ * @brief Program consecutive packets into the MCU flash memory in the native program unit (MCU_FLASH_PROGRAM_UNIT)
+ * @note the flash is unlocked once for the whole burst, each packet is still programmed without interruption
+ * @param Fu32Address Address in the flash memory of the first packet (8 bytes aligned)
+ * @param Fpu64Data Packets to be written
+ * @param Fu32NbPackets Number of packets
+ * @return Status code indicating the result of the program operation : 0 OK ; 1 NOT OK
+ */
+uint8_t u8FLASH_ITF_eFlashProgramBurst( uint32_t Fu32Address,
+                                        const uint64_t * Fpu64Data,
+                                        uint32_t Fu32NbPackets );
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /*EEP_MCU_ITF_H_*/
@@ -0,0 +1,68 @@
+/*
+ * eeprom_registry.h
+ * fyras1
+ *
+ * typed variable registry: the variables declared in EEPROM_REGISTRY (eeprom_drv_cfg.h) are read and written
+ * by name and type instead of virtual address and uint32_t
+ */
+
+#ifndef EEPROM_EMUL_EEP_REGISTRY_H_
+#define EEPROM_EMUL_EEP_REGISTRY_H_
+
+#include "eeprom_drv.h"
+
+#if EEPROM_REGISTRY_ENABLE
+
+/********************types*************************/
+/*C type of the registry types*/
+#define EEPROM_REG_CTYPE_BOOL     BOOL
+#define EEPROM_REG_CTYPE_U8       uint8_t
+#define EEPROM_REG_CTYPE_U16      uint16_t
+#define EEPROM_REG_CTYPE_U32      uint32_t
+#define EEPROM_REG_CTYPE_I32      int32_t
+#define EEPROM_REG_CTYPE_FLOAT    float
+
+/*one packet per SLOT and per VAR, position in the RAM copy of the registry*/
+#define EEPROM_REG_IDX_SLOT( NAME, VIRT_ADDR )                 EEPROM_REG_IDX_##NAME,
+#define EEPROM_REG_IDX_FIELD( SLOT, NAME, TYPE, DEFAULT )
+#define EEPROM_REG_IDX_VAR( NAME, TYPE, VIRT_ADDR, DEFAULT )   EEPROM_REG_IDX_##NAME,
+
+typedef enum
+{
+    EEPROM_REGISTRY( EEPROM_REG_IDX_SLOT, EEPROM_REG_IDX_FIELD, EEPROM_REG_IDX_VAR )
+    EEPROM_REG_NB_PACKETS
+} EEpromRegIdxTypedef;
+
+/*********************Prototypes**************************/
+
+/**
+ * @brief Initialize the EEPROM (u8EEPROM_eInit) and load the registry in RAM, the defaults for the variables never written
+ * @return Status code indicating the result of the initialization, Du8EEPROM_eBAD_PARAM if two entries of
+ *         EEPROM_REGISTRY share a virtual address or one is not valid, Du8EEPROM_eDATA_CORRUPTED if a stored
+ *         packet of the registry is corrupted (its default is used)
+ */
+uint8_t u8EEPROM_eRegistryInit( void );
+
+/**
+ * @brief Format the EEPROM (u8EEPROM_eFormat) and set every variable of the registry back to its default
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eRegistryFormat( void );
+
+/*u8EEPROM_eRegGet<NAME> / u8EEPROM_eRegSet<NAME> of each FIELD and VAR:
+ * get : reads the RAM copy (default value if never written), Du8EEPROM_eERROR before u8EEPROM_eRegistryInit
+ * set : writes the packet of the variable, the other fields of its slot are kept. nothing is written
+ *       if the value is unchanged and already stored*/
+#define EEPROM_REG_PROTO_SLOT( NAME, VIRT_ADDR )
+#define EEPROM_REG_PROTO_FIELD( SLOT, NAME, TYPE, DEFAULT )                   \
+    uint8_t u8EEPROM_eRegGet##NAME( EEPROM_REG_CTYPE_##TYPE * FpValue );      \
+    uint8_t u8EEPROM_eRegSet##NAME( EEPROM_REG_CTYPE_##TYPE FValue );
+#define EEPROM_REG_PROTO_VAR( NAME, TYPE, VIRT_ADDR, DEFAULT )                \
+    uint8_t u8EEPROM_eRegGet##NAME( EEPROM_REG_CTYPE_##TYPE * FpValue );      \
+    uint8_t u8EEPROM_eRegSet##NAME( EEPROM_REG_CTYPE_##TYPE FValue );
+
+EEPROM_REGISTRY( EEPROM_REG_PROTO_SLOT, EEPROM_REG_PROTO_FIELD, EEPROM_REG_PROTO_VAR )
+
+#endif /* EEPROM_REGISTRY_ENABLE */
+
+#endif /* EEPROM_EMUL_EEP_REGISTRY_H_ */
@@ -0,0 +1,816 @@
+/*
+ * eeprom_flash_sim.c
+ * fyras1
+ *
+ * host implementation of the eeprom_mcu_itf.h functions over a simulated NOR flash
+ */
+
+#define _GNU_SOURCE
+
+#include "eeprom_flash_sim.h"
+#include "eeprom_mcu_itf.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#ifndef MAP_FIXED_NOREPLACE
+    #define MAP_FIXED_NOREPLACE    ( 0x100000 )
+#endif
+
+/*sectors simulated from MCU_PAGE_0_FLASH_SECTOR, more than NB_EEPROM_PAGES leaves room for other instances*/
+#ifndef FLASH_SIM_NB_SECTORS
+    #if EEPROM_HOTCOLD_ENABLE
+        #define FLASH_SIM_NB_SECTORS    ( 2U * NB_EEPROM_PAGES ) /*the cold region, then the hot one (EEPROM_HOT_START_ADDR)*/
+    #else
+        #define FLASH_SIM_NB_SECTORS    ( NB_EEPROM_PAGES )
+    #endif
+#endif
+
+#define FLASH_SIM_SIZE    ( ( uint32_t ) FLASH_SIM_NB_SECTORS * EEPROM_PAGE_SIZE )
+
+static uint8_t * pu8FlashSim = NULL;
+static BOOL bLocked = TRUE;
+static uint32_t u32SessionDepth = 0U;
+static uint64_t u64NowUs = 0U;
+static uint8_t u8EraseStatus = FLASH_ITF_ERASE_DONE;
+static uint64_t u64EraseEndUs = 0U; /*end of the background erase*/
+static Tst_FlashSimStats stStats;
+static uint32_t u32Steps = 0U;       /*flash steps (program units and erases) since u8FLASH_SIM_eInit*/
+static uint32_t u32CutStep = 0U;     /*step at which the power is cut, 0 => no cut armed*/
+static Tpf_FlashSimPowerCut pfPowerCut = NULL;
+static uint8_t u8FaultModel = FLASH_SIM_FAULT_CLEAN;
+static uint32_t u32FaultSeed = 0U;
+static uint32_t u32FaultRand = 0U;  /*state of the torn cells draw, seeded at each cut*/
+static pthread_mutex_t stWriterMutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+#if MCU_FLASH_BIT_REPROGRAM == 0U
+static uint8_t au8Written[ FLASH_SIM_SIZE / MCU_FLASH_PROGRAM_UNIT / 8U ]; /*ECC flash: units programmed since their erase*/
+#endif
+
+
+/*Internal -----------*/
+
+
+/** @defgroup FlashSimPrivate_Func Private_Functions
+ * @{
+ */
+
+static void vFLASH_SIM_iUnlock( void );
+static void vFLASH_SIM_iLock( void );
+static void vFLASH_SIM_iBusy( uint64_t Fu64Us );
+static void vFLASH_SIM_iWaitErase( void );
+static void vFLASH_SIM_iErase( uint8_t Fu8Page );
+static uint32_t u32FLASH_SIM_iFaultRand( void );
+static void vFLASH_SIM_iTearErase( uint8_t * Fpu8Cells,
+                                   uint32_t Fu32Size );
+static void vFLASH_SIM_iStep( uint8_t Fu8StepKind,
+                              uint8_t * Fpu8Cells,
+                              const uint8_t * Fpu8New,
+                              uint32_t Fu32Size );
+static uint8_t u8FLASH_SIM_iProgram( uint32_t Fu32Address,
+                                     uint64_t Fu64Data,
+                                     uint8_t Fu8Size );
+static BOOL bFLASH_SIM_iIsWritten( const uint8_t * Fpu8Cell );
+static void vFLASH_SIM_iSetWritten( const uint8_t * Fpu8Cell );
+static void vFLASH_SIM_iSyncWritten( const uint8_t * Fpu8Cells,
+                                     uint32_t Fu32Size );
+/**
+ * @}
+ */
+
+
+/**
+ * @brief Map the eeprom region at FLASH_EEPROM_START_ADDR and erase it, reset the stats and the simulated time
+ * @return Status code indicating the result of the operation : 0 OK ; 1 NOT OK (address range not available)
+ */
+uint8_t u8FLASH_SIM_eInit( void )
+{
+    void * pvMap;
+
+    if( pu8FlashSim == NULL )
+    {
+        pvMap = mmap( ( void * ) ( uintptr_t ) FLASH_EEPROM_START_ADDR, FLASH_SIM_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0 );
+
+        if( pvMap != ( void * ) ( uintptr_t ) FLASH_EEPROM_START_ADDR )
+        {
+            /*older kernels ignore MAP_FIXED_NOREPLACE and return another address*/
+            if( pvMap != MAP_FAILED )
+            {
+                ( void ) munmap( pvMap, FLASH_SIM_SIZE );
+            }
+
+            return 1U;
+        }
+
+        pu8FlashSim = ( uint8_t * ) pvMap;
+    }
+
+    memset( pu8FlashSim, 0xFF, FLASH_SIM_SIZE );
+    vFLASH_SIM_iSyncWritten( pu8FlashSim, FLASH_SIM_SIZE );
+
+    bLocked = TRUE;
+    u32SessionDepth = 0U;
+    u64NowUs = 0U;
+    u8EraseStatus = FLASH_ITF_ERASE_DONE;
+    u32Steps = 0U;
+    u32CutStep = 0U;
+    vFLASH_SIM_eResetStats();
+
+    return 0U;
+}
+
+
+/**
+ * @brief Load a flash image into the eeprom region
+ * @param Fpcz8Path Path of the image, FLASH_SIM_NB_SECTORS * EEPROM_PAGE_SIZE bytes
+ * @return Status code indicating the result of the operation : 0 OK ; 1 NOT OK
+ */
+uint8_t u8FLASH_SIM_eLoadImage( const char * Fpcz8Path )
+{
+    FILE * pFile;
+    size_t u32Read;
+
+    if( pu8FlashSim == NULL )
+    {
+        return 1U;
+    }
+
+    pFile = fopen( Fpcz8Path, "rb" );
+
+    if( pFile == NULL )
+    {
+        return 1U;
+    }
+
+    u32Read = fread( pu8FlashSim, 1U, FLASH_SIM_SIZE, pFile );
+    ( void ) fclose( pFile );
+    vFLASH_SIM_iSyncWritten( pu8FlashSim, FLASH_SIM_SIZE );
+
+    return( ( u32Read == FLASH_SIM_SIZE ) ? 0U : 1U );
+}
+
+
+/**
+ * @brief Save the eeprom region to a file
+ * @param Fpcz8Path Path of the image
+ * @return Status code indicating the result of the operation : 0 OK ; 1 NOT OK
+ */
+uint8_t u8FLASH_SIM_eSaveImage( const char * Fpcz8Path )
+{
+    FILE * pFile;
+    size_t u32Written;
+
+    if( pu8FlashSim == NULL )
+    {
+        return 1U;
+    }
+
+    pFile = fopen( Fpcz8Path, "wb" );
+
+    if( pFile == NULL )
+    {
+        return 1U;
+    }
+
+    u32Written = fwrite( pu8FlashSim, 1U, FLASH_SIM_SIZE, pFile );
+    ( void ) fclose( pFile );
+
+    return( ( u32Written == FLASH_SIM_SIZE ) ? 0U : 1U );
+}
+
+
+/**
+ * @brief Get the counters of the simulated flash
+ * @param Fpst Pointer to store the counters
+ */
+void vFLASH_SIM_eGetStats( Tst_FlashSimStats * Fpst )
+{
+    if( Fpst != NULL )
+    {
+        *Fpst = stStats;
+    }
+}
+
+
+/**
+ * @brief Reset the counters of the simulated flash (the simulated time keeps running)
+ */
+void vFLASH_SIM_eResetStats( void )
+{
+    memset( &stStats, 0, sizeof( stStats ) );
+}
+
+
+/**
+ * @brief Get the simulated time
+ * @return Simulated time in us since u8FLASH_SIM_eInit
+ */
+uint64_t u64FLASH_SIM_eNowUs( void )
+{
+    return u64NowUs;
+}
+
+
+/**
+ * @brief Let simulated time pass
+ * @param Fu64Us Time in us
+ */
+void vFLASH_SIM_eAdvanceUs( uint64_t Fu64Us )
+{
+    u64NowUs += Fu64Us;
+}
+
+
+/**
+ * @brief Select what a power cut leaves in the cells of the interrupted step (see vFLASH_SIM_iStep)
+ * @param Fu8Model FLASH_SIM_FAULT_CLEAN or FLASH_SIM_FAULT_TORN
+ * @param Fu32Seed Seed of the torn cells, mixed with the step number so a replayed cut tears the same way
+ */
+void vFLASH_SIM_eSetFaultModel( uint8_t Fu8Model,
+                                uint32_t Fu32Seed )
+{
+    u8FaultModel = Fu8Model;
+    u32FaultSeed = Fu32Seed;
+}
+
+
+/**
+ * @brief Cut the power before a flash step: the step is not completed (see vFLASH_SIM_eSetFaultModel)
+ *        and FpfHandler is called instead
+ * @param Fu32Step Number of the step counted from now (1 => the next program unit or erase), 0 => disarm
+ * @param FpfHandler Power cut handler, must not return (e.g. longjmp) or the step is done anyway
+ */
+void vFLASH_SIM_eArmPowerCut( uint32_t Fu32Step,
+                              Tpf_FlashSimPowerCut FpfHandler )
+{
+    u32CutStep = ( Fu32Step != 0U ) ? ( u32Steps + Fu32Step ) : 0U;
+    pfPowerCut = FpfHandler;
+}
+
+
+/**
+ * @brief Get the number of flash steps done
+ * @return Program units and erases since u8FLASH_SIM_eInit
+ */
+uint32_t u32FLASH_SIM_eGetSteps( void )
+{
+    return u32Steps;
+}
+
+
+/**
+ * @brief Power cycle of the MCU: the flash content is kept, the lock, the sessions and an erase in progress are lost
+ */
+void vFLASH_SIM_ePowerCycle( void )
+{
+    bLocked = TRUE;
+    u32SessionDepth = 0U;
+    u8EraseStatus = FLASH_ITF_ERASE_DONE;
+    u32CutStep = 0U;
+    stWriterMutex = ( pthread_mutex_t ) PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP; /*the cut writer held it*/
+}
+
+
+/*eeprom_mcu_itf.h -----------*/
+
+
+/**
+ * @brief Erase a sector of the simulated flash
+ * @param Fu8Sector MCU sector to erase
+ * @return Status code indicating the result of the erase operation
+ */
+uint8_t u8FLASH_ITF_eFlashSectorErase( uint8_t Fu8Sector )
+{
+    if( ( Fu8Sector < MCU_PAGE_0_FLASH_SECTOR ) || ( Fu8Sector >= ( MCU_PAGE_0_FLASH_SECTOR + FLASH_SIM_NB_SECTORS ) ) )
+    {
+        return 1U;
+    }
+
+    vFLASH_SIM_iWaitErase();
+    vFLASH_SIM_iErase( Fu8Sector - MCU_PAGE_0_FLASH_SECTOR );
+    vFLASH_SIM_iBusy( ( uint64_t ) FLASH_SIM_ERASE_MS * 1000U );
+
+    return 0U;
+}
+
+
+/**
+ * @brief Start the erase of a sector of the simulated flash, it ends FLASH_SIM_ERASE_MS later (simulated time)
+ * @param Fu8Sector MCU sector to erase
+ * @return Status code indicating the result of the operation : 0 OK ; 1 NOT OK
+ */
+uint8_t u8FLASH_ITF_eFlashSectorEraseStart( uint8_t Fu8Sector )
+{
+    if( ( Fu8Sector < MCU_PAGE_0_FLASH_SECTOR ) || ( Fu8Sector >= ( MCU_PAGE_0_FLASH_SECTOR + FLASH_SIM_NB_SECTORS ) ) )
+    {
+        return 1U;
+    }
+
+    vFLASH_SIM_iWaitErase();
+
+    /*the page is left by the driver before its erase, its content can change at once*/
+    vFLASH_SIM_iErase( Fu8Sector - MCU_PAGE_0_FLASH_SECTOR );
+    u8EraseStatus = FLASH_ITF_ERASE_BUSY;
+    u64EraseEndUs = u64NowUs + ( ( uint64_t ) FLASH_SIM_ERASE_MS * 1000U );
+
+    return 0U;
+}
+
+
+/**
+ * @brief Get the status of the erase started by u8FLASH_ITF_eFlashSectorEraseStart
+ * @return FLASH_ITF_ERASE_DONE, FLASH_ITF_ERASE_BUSY or FLASH_ITF_ERASE_ERROR
+ */
+uint8_t u8FLASH_ITF_eFlashEraseStatus( void )
+{
+    if( ( u8EraseStatus == FLASH_ITF_ERASE_BUSY ) && ( u64NowUs >= u64EraseEndUs ) )
+    {
+        u8EraseStatus = FLASH_ITF_ERASE_DONE;
+    }
+
+    return u8EraseStatus;
+}
+
+
+/**
+ * @brief Called in loop while the driver waits for the end of an erase: the wait is counted as flash busy time
+ */
+void vFLASH_ITF_eEraseWaitHook( void )
+{
+    vFLASH_SIM_iWaitErase();
+}
+
+
+/**
+ * @brief Software CRC-32 (poly 0x04C11DB7, init 0xFFFFFFFF) on 32 bits words, same result as the stm32f2 CRC unit
+ * @param Fpu32Words Words to feed
+ * @param Fu32NbWords Number of words
+ * @return CRC of the words
+ */
+uint32_t u32FLASH_ITF_eHwCrc32( const uint32_t * Fpu32Words,
+                                uint32_t Fu32NbWords )
+{
+    uint32_t u32Crc = 0xFFFFFFFFU;
+    uint32_t u32Pos;
+    uint8_t u8Bit;
+
+    for( u32Pos = 0U; u32Pos < Fu32NbWords; u32Pos++ )
+    {
+        u32Crc ^= Fpu32Words[ u32Pos ];
+
+        for( u8Bit = 0U; u8Bit < 32U; u8Bit++ )
+        {
+            u32Crc = ( ( u32Crc & 0x80000000U ) != 0U ) ? ( ( u32Crc << 1 ) ^ 0x04C11DB7U ) : ( u32Crc << 1 );
+        }
+    }
+
+    return u32Crc;
+}
+
+
+/**
+ * @brief Get a millisecond tick
+ * @return Simulated time in ms
+ */
+uint32_t u32FLASH_ITF_eGetTickMs( void )
+{
+    return ( uint32_t ) ( u64NowUs / 1000U );
+}
+
+
+/**
+ * @brief Get a free running timestamp
+ * @return Simulated time in us
+ */
+uint32_t u32FLASH_ITF_eGetTimestamp( void )
+{
+    return ( uint32_t ) u64NowUs;
+}
+
+
+/**
+ * @brief Open a programming session
+ */
+void vFLASH_ITF_eSessionBegin( void )
+{
+    if( u32SessionDepth == 0U )
+    {
+        vFLASH_SIM_iUnlock();
+        stStats.u32Sessions++;
+    }
+
+    u32SessionDepth++;
+}
+
+
+/**
+ * @brief Close a programming session
+ */
+void vFLASH_ITF_eSessionEnd( void )
+{
+    if( u32SessionDepth > 0U )
+    {
+        u32SessionDepth--;
+    }
+
+    vFLASH_SIM_iLock();
+}
+
+
+/**
+ * @brief Take the mutex serializing the writers of the driver (EEPROM_THREAD_SAFE_ENABLE)
+ */
+void vFLASH_ITF_eMutexTake( void )
+{
+    ( void ) pthread_mutex_lock( &stWriterMutex );
+}
+
+
+/**
+ * @brief Release the mutex serializing the writers of the driver
+ */
+void vFLASH_ITF_eMutexGive( void )
+{
+    ( void ) pthread_mutex_unlock( &stWriterMutex );
+}
+
+
+/**
+ * @brief Program data into the simulated flash
+ * @param Fu32Address Address in the flash memory to write the data
+ * @param Fu64Data Data to be written
+ * @param fu8WriteSizeBytes Size of the data to be written in bytes (1, 2, 4 or 8)
+ * @return Status code indicating the result of the program operation : 0 OK ; 1 NOT OK
+ */
+uint8_t u8FLASH_ITF_FlashProgram( uint32_t Fu32Address,
+                                  uint64_t Fu64Data,
+                                  uint8_t fu8WriteSizeBytes )
+{
+    uint8_t u8FnRet;
+
+    vFLASH_SIM_iUnlock();
+    u8FnRet = u8FLASH_SIM_iProgram( Fu32Address, Fu64Data, fu8WriteSizeBytes );
+    vFLASH_SIM_iLock();
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Program consecutive packets into the simulated flash
+ * @param Fu32Address Address in the flash memory of the first packet (8 bytes aligned)
+ * @param Fpu64Data Packets to be written
+ * @param Fu32NbPackets Number of packets
+ * @return Status code indicating the result of the program operation : 0 OK ; 1 NOT OK
+ */
+uint8_t u8FLASH_ITF_eFlashProgramBurst( uint32_t Fu32Address,
+                                        const uint64_t * Fpu64Data,
+                                        uint32_t Fu32NbPackets )
+{
+    uint8_t u8FnRet = 0U;
+    uint32_t u32Pos;
+
+    vFLASH_SIM_iUnlock();
+
+    for( u32Pos = 0U; ( u32Pos < Fu32NbPackets ) && ( u8FnRet == 0U ); u32Pos++ )
+    {
+        u8FnRet = u8FLASH_SIM_iProgram( Fu32Address + ( u32Pos * 8U ), Fpu64Data[ u32Pos ], 8U );
+    }
+
+    vFLASH_SIM_iLock();
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Unlock the flash for one operation, nothing to do inside a session
+ */
+static void vFLASH_SIM_iUnlock( void )
+{
+    if( u32SessionDepth == 0U )
+    {
+        bLocked = FALSE;
+        stStats.u32Unlocks++;
+    }
+}
+
+
+/**
+ * @brief Lock the flash after an operation, unless a session is open
+ */
+static void vFLASH_SIM_iLock( void )
+{
+    if( u32SessionDepth == 0U )
+    {
+        bLocked = TRUE;
+    }
+}
+
+
+/**
+ * @brief Account for a flash operation in the simulated time
+ * @param Fu64Us Duration of the operation in us
+ */
+static void vFLASH_SIM_iBusy( uint64_t Fu64Us )
+{
+    #if FLASH_SIM_REAL_DELAY
+        struct timespec stDelay;
+
+        stDelay.tv_sec = ( time_t ) ( Fu64Us / 1000000U );
+        stDelay.tv_nsec = ( long ) ( ( Fu64Us % 1000000U ) * 1000U );
+        ( void ) nanosleep( &stDelay, NULL );
+    #endif
+
+    u64NowUs += Fu64Us;
+    stStats.u64FlashBusyUs += Fu64Us;
+}
+
+
+/**
+ * @brief Wait for the end of the background erase (single bank flash: nothing else can run on it meanwhile)
+ */
+static void vFLASH_SIM_iWaitErase( void )
+{
+    if( ( u8EraseStatus == FLASH_ITF_ERASE_BUSY ) && ( u64NowUs < u64EraseEndUs ) )
+    {
+        stStats.u32EraseWaits++;
+        vFLASH_SIM_iBusy( u64EraseEndUs - u64NowUs );
+    }
+
+    ( void ) u8FLASH_ITF_eFlashEraseStatus();
+}
+
+
+/**
+ * @brief Set a page of the simulated flash to 0xFF
+ * @param Fu8Page Page number
+ */
+static void vFLASH_SIM_iErase( uint8_t Fu8Page )
+{
+    vFLASH_SIM_iStep( FLASH_SIM_STEP_ERASE, pu8FlashSim + ( ( uint32_t ) Fu8Page * EEPROM_PAGE_SIZE ), NULL, EEPROM_PAGE_SIZE );
+    memset( pu8FlashSim + ( ( uint32_t ) Fu8Page * EEPROM_PAGE_SIZE ), 0xFF, EEPROM_PAGE_SIZE );
+    vFLASH_SIM_iSyncWritten( pu8FlashSim + ( ( uint32_t ) Fu8Page * EEPROM_PAGE_SIZE ), EEPROM_PAGE_SIZE );
+    stStats.u32Erases++;
+}
+
+
+/**
+ * @brief Program the simulated flash: bits can only go from 1 to 0, one operation per MCU_FLASH_PROGRAM_UNIT bytes,
+ *        nothing smaller. without MCU_FLASH_BIT_REPROGRAM a programmed unit only takes all zeros until its erase
+ * @param Fu32Address Address in the flash memory to write the data
+ * @param Fu64Data Data to be written (little endian)
+ * @param Fu8Size Size of the data in bytes (1, 2, 4 or 8)
+ * @return Status code indicating the result of the program operation : 0 OK ; 1 NOT OK
+ */
+static uint8_t u8FLASH_SIM_iProgram( uint32_t Fu32Address,
+                                     uint64_t Fu64Data,
+                                     uint8_t Fu8Size )
+{
+    uint8_t * pu8Cell;
+    uint8_t au8New[ 8 ];
+    uint8_t u8Pos;
+    uint64_t u64UnitData;
+    uint8_t u8Unit = MCU_FLASH_PROGRAM_UNIT;
+    uint8_t u8FnRet = 0U;
+
+    if( ( pu8FlashSim == NULL ) || ( bLocked == TRUE ) ||
+        ( ( Fu8Size != 1U ) && ( Fu8Size != 2U ) && ( Fu8Size != 4U ) && ( Fu8Size != 8U ) ) ||
+        ( Fu8Size < MCU_FLASH_PROGRAM_UNIT ) ||
+        ( ( Fu32Address % Fu8Size ) != 0U ) ||
+        ( Fu32Address < FLASH_EEPROM_START_ADDR ) || ( ( Fu32Address + Fu8Size ) > ( FLASH_EEPROM_START_ADDR + FLASH_SIM_SIZE ) ) )
+    {
+        stStats.u32ProgramErrors++;
+        return 1U;
+    }
+
+    vFLASH_SIM_iWaitErase();
+
+    pu8Cell = ( uint8_t * ) ( uintptr_t ) Fu32Address;
+
+    for( u8Pos = 0U; u8Pos < Fu8Size; u8Pos++ )
+    {
+        au8New[ u8Pos ] = ( uint8_t ) ( Fu64Data >> ( 8U * u8Pos ) );
+    }
+
+    for( u8Pos = 0U; u8Pos < Fu8Size; u8Pos++ )
+    {
+        if( ( u8Pos % u8Unit ) == 0U )
+        {
+            /*ECC flash: the code of a written unit is only rewritten right by all zeros*/
+            u64UnitData = ( u8Unit == 8U ) ? Fu64Data : ( ( Fu64Data >> ( 8U * u8Pos ) ) & 0xFFFFFFFFU );
+
+            if( ( TRUE == bFLASH_SIM_iIsWritten( &pu8Cell[ u8Pos ] ) ) && ( u64UnitData != 0U ) )
+            {
+                u8FnRet = 1U;
+            }
+
+            /*a double word with a 4 bytes unit is 2 steps: the power can be cut between them*/
+            vFLASH_SIM_iStep( FLASH_SIM_STEP_PROGRAM, &pu8Cell[ u8Pos ], &au8New[ u8Pos ], u8Unit );
+            vFLASH_SIM_iSetWritten( &pu8Cell[ u8Pos ] );
+        }
+
+        if( ( pu8Cell[ u8Pos ] & au8New[ u8Pos ] ) != au8New[ u8Pos ] )
+        {
+            /*a programmed 0 can't go back to 1 without an erase*/
+            u8FnRet = 1U;
+        }
+
+        pu8Cell[ u8Pos ] &= au8New[ u8Pos ];
+    }
+
+    if( u8FnRet != 0U )
+    {
+        stStats.u32ProgramErrors++;
+    }
+
+    stStats.u32Programs += Fu8Size / u8Unit;
+    stStats.u32ProgrammedBytes += Fu8Size;
+    vFLASH_SIM_iBusy( ( uint64_t ) FLASH_SIM_PROGRAM_US * ( Fu8Size / u8Unit ) );
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Draw of the torn cells (xorshift32)
+ * @return Next number
+ */
+static uint32_t u32FLASH_SIM_iFaultRand( void )
+{
+    u32FaultRand ^= u32FaultRand << 13;
+    u32FaultRand ^= u32FaultRand >> 17;
+    u32FaultRand ^= u32FaultRand << 5;
+
+    return u32FaultRand;
+}
+
+
+/**
+ * @brief Leave a page as an erase cut at an arbitrary point: nothing erased, a random start (the header) or end
+ *        of the page erased, bits set all over the page, or the whole page erased but a few scattered bytes
+ * @param Fpu8Cells Cells of the page
+ * @param Fu32Size Size of the page
+ */
+static void vFLASH_SIM_iTearErase( uint8_t * Fpu8Cells,
+                                   uint32_t Fu32Size )
+{
+    uint32_t u32Len = u32FLASH_SIM_iFaultRand() % ( Fu32Size + 1U );
+    uint32_t u32Pos;
+
+    switch( u32FLASH_SIM_iFaultRand() % 5U )
+    {
+        case 0U:
+            break;
+
+        case 1U:
+            memset( Fpu8Cells, 0xFF, u32Len );
+            break;
+
+        case 2U:
+            memset( Fpu8Cells + ( Fu32Size - u32Len ), 0xFF, u32Len );
+            break;
+
+        case 3U:
+            for( u32Pos = 0U; u32Pos < Fu32Size; u32Pos++ )
+            {
+                Fpu8Cells[ u32Pos ] |= ( uint8_t ) u32FLASH_SIM_iFaultRand();
+            }
+            break;
+
+        default:
+            for( u32Pos = 0U; u32Pos < Fu32Size; u32Pos++ )
+            {
+                if( ( u32FLASH_SIM_iFaultRand() % 256U ) != 0U )
+                {
+                    Fpu8Cells[ u32Pos ] = 0xFFU;
+                }
+            }
+            break;
+    }
+}
+
+
+/**
+ * @brief Count a flash step and cut the power if it is the armed one.
+ *        FLASH_SIM_FAULT_CLEAN: a cut program leaves its cells unchanged, a cut erase erases the end of the page,
+ *        its start (page header) keeps the old content.
+ *        FLASH_SIM_FAULT_TORN: a cut program clears a random part of the bits it had to clear, a cut erase is
+ *        torn anywhere (vFLASH_SIM_iTearErase)
+ * @param Fu8StepKind FLASH_SIM_STEP_PROGRAM or FLASH_SIM_STEP_ERASE
+ * @param Fpu8Cells Cells of the step
+ * @param Fpu8New Data of a program step, NULL for an erase
+ * @param Fu32Size Number of cells
+ */
+static void vFLASH_SIM_iStep( uint8_t Fu8StepKind,
+                              uint8_t * Fpu8Cells,
+                              const uint8_t * Fpu8New,
+                              uint32_t Fu32Size )
+{
+    uint32_t u32Pos;
+
+    u32Steps++;
+
+    if( ( u32CutStep == 0U ) || ( u32Steps != u32CutStep ) || ( pfPowerCut == NULL ) )
+    {
+        return;
+    }
+
+    u32CutStep = 0U;
+    u32FaultRand = ( u32FaultSeed ^ ( u32Steps * 0x9E3779B9U ) ) | 1U;
+
+    if( u8FaultModel == FLASH_SIM_FAULT_TORN )
+    {
+        if( Fu8StepKind == FLASH_SIM_STEP_ERASE )
+        {
+            vFLASH_SIM_iTearErase( Fpu8Cells, Fu32Size );
+        }
+        else
+        {
+            for( u32Pos = 0U; u32Pos < Fu32Size; u32Pos++ )
+            {
+                Fpu8Cells[ u32Pos ] &= ( uint8_t ) ( Fpu8New[ u32Pos ] | ( uint8_t ) u32FLASH_SIM_iFaultRand() );
+            }
+        }
+    }
+    else if( Fu8StepKind == FLASH_SIM_STEP_ERASE )
+    {
+        memset( Fpu8Cells + ( Fu32Size / 2U ), 0xFF, Fu32Size / 2U );
+    }
+
+    /*the cells the cut left blank can be programmed again*/
+    vFLASH_SIM_iSyncWritten( Fpu8Cells, Fu32Size );
+    pfPowerCut( Fu8StepKind );
+}
+
+
+/**
+ * @brief Check if a unit was programmed since its erase (always FALSE with MCU_FLASH_BIT_REPROGRAM)
+ * @param Fpu8Cell First cell of the unit
+ * @return TRUE if the unit only takes all zeros, FALSE otherwise
+ */
+static BOOL bFLASH_SIM_iIsWritten( const uint8_t * Fpu8Cell )
+{
+    #if MCU_FLASH_BIT_REPROGRAM == 0U
+        uint32_t u32Unit = ( uint32_t ) ( Fpu8Cell - pu8FlashSim ) / MCU_FLASH_PROGRAM_UNIT;
+
+        return( ( ( au8Written[ u32Unit / 8U ] >> ( u32Unit % 8U ) ) & 1U ) != 0U ) ? TRUE : FALSE;
+    #else
+        ( void ) Fpu8Cell;
+
+        return FALSE;
+    #endif
+}
+
+
+/**
+ * @brief Record the program of a unit
+ * @param Fpu8Cell First cell of the unit
+ */
+static void vFLASH_SIM_iSetWritten( const uint8_t * Fpu8Cell )
+{
+    #if MCU_FLASH_BIT_REPROGRAM == 0U
+        uint32_t u32Unit = ( uint32_t ) ( Fpu8Cell - pu8FlashSim ) / MCU_FLASH_PROGRAM_UNIT;
+
+        au8Written[ u32Unit / 8U ] |= ( uint8_t ) ( 1U << ( u32Unit % 8U ) );
+    #else
+        ( void ) Fpu8Cell;
+    #endif
+}
+
+
+/**
+ * @brief Set the units of a range as written from their cells, after an erase, a power cut or an image load:
+ *        a unit left all 0xFF counts as erased
+ * @param Fpu8Cells First cell of the range (unit aligned)
+ * @param Fu32Size Size of the range (units)
+ */
+static void vFLASH_SIM_iSyncWritten( const uint8_t * Fpu8Cells,
+                                     uint32_t Fu32Size )
+{
+    #if MCU_FLASH_BIT_REPROGRAM == 0U
+        uint32_t u32Pos;
+        uint32_t u32Unit;
+        uint8_t u8Cell;
+
+        for( u32Pos = 0U; u32Pos < Fu32Size; u32Pos += MCU_FLASH_PROGRAM_UNIT )
+        {
+            u32Unit = ( uint32_t ) ( &Fpu8Cells[ u32Pos ] - pu8FlashSim ) / MCU_FLASH_PROGRAM_UNIT;
+            au8Written[ u32Unit / 8U ] &= ( uint8_t ) ~( 1U << ( u32Unit % 8U ) );
+
+            for( u8Cell = 0U; u8Cell < MCU_FLASH_PROGRAM_UNIT; u8Cell++ )
+            {
+                if( Fpu8Cells[ u32Pos + u8Cell ] != 0xFFU )
+                {
+                    vFLASH_SIM_iSetWritten( &Fpu8Cells[ u32Pos ] );
+                }
+            }
+        }
+    #else
+        ( void ) Fpu8Cells;
+        ( void ) Fu32Size;
+    #endif
+}
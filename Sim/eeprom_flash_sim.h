@@ -0,0 +1,134 @@
+/*
+ * eeprom_flash_sim.h
+ * fyras1
+ *
+ * host (linux) simulation of the flash behind eeprom_mcu_itf.h: FLASH_SIM_NB_SECTORS sectors of EEPROM_PAGE_SIZE
+ * from FLASH_EEPROM_START_ADDR (sector MCU_PAGE_0_FLASH_SECTOR) are mapped at their MCU address and behave as
+ * NOR flash (programming only clears bits, an erase sets a whole sector back to 0xFF).
+ * eeprom_flash_sim.c replaces eeprom_mcu_itf.c in the host build (Sim/Makefile)
+ */
+
+#ifndef EEPROM_EMUL_FLASH_SIM_H_
+#define EEPROM_EMUL_FLASH_SIM_H_
+
+#include "eeprom_drv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*timing model, typical values of the stm32f205 datasheet. the time is simulated (see u64FLASH_SIM_eNowUs)*/
+#ifndef FLASH_SIM_PROGRAM_US
+    #define FLASH_SIM_PROGRAM_US    ( 16U )  /*us per program operation of MCU_FLASH_PROGRAM_UNIT bytes*/
+#endif
+#ifndef FLASH_SIM_ERASE_MS
+    #define FLASH_SIM_ERASE_MS      ( 400U ) /*ms per page (sector) erase*/
+#endif
+/*1 => the simulator also sleeps for the modeled time of each operation*/
+#ifndef FLASH_SIM_REAL_DELAY
+    #define FLASH_SIM_REAL_DELAY    ( 0U )
+#endif
+
+/*kind of the flash step interrupted by a power cut (vFLASH_SIM_eArmPowerCut)*/
+#define FLASH_SIM_STEP_PROGRAM    ( 0U )     /*program of MCU_FLASH_PROGRAM_UNIT bytes or less*/
+#define FLASH_SIM_STEP_ERASE      ( 1U )     /*page (sector) erase*/
+
+/*content left by a power cut in the cells of the interrupted step (vFLASH_SIM_eSetFaultModel)*/
+#define FLASH_SIM_FAULT_CLEAN     ( 0U )     /*program not started, erase of the end of the page only*/
+#define FLASH_SIM_FAULT_TORN      ( 1U )     /*program with a random part of its bits, erase torn anywhere (header included)*/
+
+/********************typedefs*************************/
+typedef void ( * Tpf_FlashSimPowerCut )( uint8_t Fu8StepKind );
+
+typedef struct
+{
+    uint32_t u32Programs;        /*program operations (MCU_FLASH_PROGRAM_UNIT bytes or less)*/
+    uint32_t u32ProgrammedBytes;
+    uint32_t u32Erases;
+    uint32_t u32Unlocks;
+    uint32_t u32Sessions;
+    uint32_t u32EraseWaits;      /*operations that had to wait for the end of a background erase*/
+    uint32_t u32ProgramErrors;   /*programs refused: flash locked, bad alignment/address, bit set from 0 to 1*/
+    uint64_t u64FlashBusyUs;     /*simulated time spent programming and erasing*/
+} Tst_FlashSimStats;
+
+/*********************Prototypes**************************/
+
+/**
+ * @brief Map the eeprom region at FLASH_EEPROM_START_ADDR and erase it, reset the stats and the simulated time
+ * @return Status code indicating the result of the operation : 0 OK ; 1 NOT OK (address range not available)
+ */
+uint8_t u8FLASH_SIM_eInit( void );
+
+/**
+ * @brief Load a flash image (e.g. saved by u8FLASH_SIM_eSaveImage) into the eeprom region
+ * @param Fpcz8Path Path of the image, FLASH_SIM_NB_SECTORS * EEPROM_PAGE_SIZE bytes
+ * @return Status code indicating the result of the operation : 0 OK ; 1 NOT OK
+ */
+uint8_t u8FLASH_SIM_eLoadImage( const char * Fpcz8Path );
+
+/**
+ * @brief Save the eeprom region to a file
+ * @param Fpcz8Path Path of the image
+ * @return Status code indicating the result of the operation : 0 OK ; 1 NOT OK
+ */
+uint8_t u8FLASH_SIM_eSaveImage( const char * Fpcz8Path );
+
+/**
+ * @brief Get the counters of the simulated flash
+ * @param Fpst Pointer to store the counters
+ */
+void vFLASH_SIM_eGetStats( Tst_FlashSimStats * Fpst );
+
+/**
+ * @brief Reset the counters of the simulated flash (the simulated time keeps running)
+ */
+void vFLASH_SIM_eResetStats( void );
+
+/**
+ * @brief Get the simulated time: flash operations, waits for the background erase and vFLASH_SIM_eAdvanceUs
+ * @note CPU time of the driver is not included, measure it on the host clock
+ * @return Simulated time in us since u8FLASH_SIM_eInit
+ */
+uint64_t u64FLASH_SIM_eNowUs( void );
+
+/**
+ * @brief Let simulated time pass (application work between eeprom calls, a background erase progresses)
+ * @param Fu64Us Time in us
+ */
+void vFLASH_SIM_eAdvanceUs( uint64_t Fu64Us );
+
+/**
+ * @brief Select what a power cut leaves in the cells of the interrupted step, FLASH_SIM_FAULT_CLEAN by default
+ * @param Fu8Model FLASH_SIM_FAULT_CLEAN or FLASH_SIM_FAULT_TORN
+ * @param Fu32Seed Seed of the torn cells, mixed with the step number so a replayed cut tears the same way
+ */
+void vFLASH_SIM_eSetFaultModel( uint8_t Fu8Model,
+                                uint32_t Fu32Seed );
+
+/**
+ * @brief Cut the power before a flash step: the step is not completed, its cells are left as selected by
+ *        vFLASH_SIM_eSetFaultModel, and FpfHandler is called instead
+ * @param Fu32Step Number of the step counted from now (1 => the next program unit or erase), 0 => disarm
+ * @param FpfHandler Power cut handler, must not return (e.g. longjmp) or the step is done anyway
+ */
+void vFLASH_SIM_eArmPowerCut( uint32_t Fu32Step,
+                              Tpf_FlashSimPowerCut FpfHandler );
+
+/**
+ * @brief Get the number of flash steps done, a step is a program of MCU_FLASH_PROGRAM_UNIT bytes or an erase
+ * @return Program units and erases since u8FLASH_SIM_eInit
+ */
+uint32_t u32FLASH_SIM_eGetSteps( void );
+
+/**
+ * @brief Power cycle of the MCU: the flash content is kept, the lock, the sessions and an erase in progress are lost
+ * @note call it before rebooting the driver (u8EEPROM_eInit) after a power cut
+ */
+void vFLASH_SIM_ePowerCycle( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EEPROM_EMUL_FLASH_SIM_H_ */
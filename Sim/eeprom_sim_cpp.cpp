@@ -0,0 +1,117 @@
+/*
+ * eeprom_sim_cpp.cpp
+ * fyras1
+ *
+ * host check of the C++ front end (eeprom_drv.hpp) over the simulated flash: the default partition is run
+ * through eeprom::EmulatedEeprom, written, rebooted and read back
+ * usage : eeprom_sim_cpp [nb_writes] [nb_variables]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "eeprom_drv.hpp"
+#include "eeprom_flash_sim.h"
+
+/*the geometry of the C API, computed at compile time*/
+static_assert( eeprom::DefaultLayout::u32MaxVariables == MAX_EEPROM_VARIABLES, "layout of the default partition" );
+static_assert( eeprom::DefaultLayout::u32EndAddr == ( FLASH_EEPROM_START_ADDR + ( NB_EEPROM_PAGES * EEPROM_PAGE_SIZE ) ),
+               "end of the default partition" );
+
+static uint8_t u8SIM_iCheck( eeprom::EmulatedEeprom< eeprom::DefaultLayout > & FstEeprom,
+                             uint32_t Fu32NbWrites,
+                             uint32_t Fu32NbVars );
+
+
+int main( int argc,
+          char ** argv )
+{
+    static eeprom::EmulatedEeprom< eeprom::DefaultLayout > stEeprom;
+    uint32_t u32NbWrites = ( argc > 1 ) ? ( uint32_t ) strtoul( argv[ 1 ], NULL, 0 ) : 20000U;
+    uint32_t u32NbVars = ( argc > 2 ) ? ( uint32_t ) strtoul( argv[ 2 ], NULL, 0 ) : 64U;
+    uint32_t u32Pos;
+
+    if( ( u32NbVars == 0U ) || ( u32NbVars > eeprom::DefaultLayout::u32MaxVariables / 2U ) )
+    {
+        std::printf( "nb_variables must be in [1, %u]\n", eeprom::DefaultLayout::u32MaxVariables / 2U );
+        return 1;
+    }
+
+    if( 0U != u8FLASH_SIM_eInit() )
+    {
+        std::printf( "can't map the eeprom region at 0x%08X\n", ( unsigned int ) FLASH_EEPROM_START_ADDR );
+        return 1;
+    }
+
+    if( Du8EEPROM_eSUCCESS != stEeprom.u8Init() )
+    {
+        std::printf( "init failed\n" );
+        return 1;
+    }
+
+    /*write n goes to variable 1 + n % nb_variables, its value is that variable + n / nb_variables*/
+    for( u32Pos = 0U; u32Pos < u32NbWrites; u32Pos++ )
+    {
+        if( Du8EEPROM_eSUCCESS != stEeprom.u8WriteVar( ( uint16_t ) ( 1U + ( u32Pos % u32NbVars ) ), 1U + ( u32Pos % u32NbVars ) + ( u32Pos / u32NbVars ) ) )
+        {
+            std::printf( "write %u failed\n", u32Pos );
+            return 1;
+        }
+
+        vFLASH_SIM_eAdvanceUs( 100U );
+        ( void ) stEeprom.u8TransferStep( 16U );
+    }
+
+    if( Du8EEPROM_eSUCCESS != u8SIM_iCheck( stEeprom, u32NbWrites, u32NbVars ) )
+    {
+        return 1;
+    }
+
+    /*reboot on the same flash*/
+    vFLASH_SIM_ePowerCycle();
+
+    if( ( Du8EEPROM_eSUCCESS != stEeprom.u8Init() ) ||
+        ( Du8EEPROM_eSUCCESS != u8SIM_iCheck( stEeprom, u32NbWrites, u32NbVars ) ) )
+    {
+        std::printf( "check after reboot failed\n" );
+        return 1;
+    }
+
+    std::printf( "c++ front end  %u writes on %u variables, %u pages of %u bytes: ok\n",
+                 u32NbWrites, u32NbVars, NB_EEPROM_PAGES, eeprom::DefaultLayout::u32PageSize );
+
+    return 0;
+}
+
+
+/**
+ * @brief Read the variables back, each one holds the value of its last write
+ * @param FstEeprom Partition
+ * @param Fu32NbWrites Number of writes done
+ * @param Fu32NbVars Number of variables
+ * @return Du8EEPROM_eSUCCESS or the failing status
+ */
+static uint8_t u8SIM_iCheck( eeprom::EmulatedEeprom< eeprom::DefaultLayout > & FstEeprom,
+                             uint32_t Fu32NbWrites,
+                             uint32_t Fu32NbVars )
+{
+    uint32_t u32Var;
+    uint32_t u32LastWrite;
+    uint32_t u32Value = 0U;
+    uint8_t u8FnRet;
+
+    for( u32Var = 0U; ( u32Var < Fu32NbVars ) && ( u32Var < Fu32NbWrites ); u32Var++ )
+    {
+        u32LastWrite = ( ( ( Fu32NbWrites - 1U - u32Var ) / Fu32NbVars ) * Fu32NbVars ) + u32Var;
+        u8FnRet = FstEeprom.u8ReadVar( ( uint16_t ) ( 1U + u32Var ), &u32Value );
+
+        if( ( u8FnRet != Du8EEPROM_eSUCCESS ) || ( u32Value != ( 1U + u32Var + ( u32LastWrite / Fu32NbVars ) ) ) )
+        {
+            std::printf( "variable %u: status %u value %u, expected %u\n", 1U + u32Var, u8FnRet, u32Value,
+                         1U + u32Var + ( u32LastWrite / Fu32NbVars ) );
+            return ( u8FnRet != Du8EEPROM_eSUCCESS ) ? u8FnRet : Du8EEPROM_eDATA_CORRUPTED;
+        }
+    }
+
+    return Du8EEPROM_eSUCCESS;
+}
@@ -0,0 +1,234 @@
+/*
+ * eeprom_sim_main.c
+ * fyras1
+ *
+ * host measurement of the driver over the simulated flash: write rate, compaction cost and boot time
+ * usage : eeprom_sim [nb_writes] [nb_variables] [image_file]
+ *         with image_file, the boot is measured on that image and the flash is saved into it at the end
+ */
+
+#define _POSIX_C_SOURCE    ( 199309L )
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "eeprom_drv.h"
+#include "eeprom_flash_sim.h"
+
+/*simulated application time between two writes (lets a background erase progress)*/
+#define SIM_APP_TIME_BETWEEN_WRITES_US    ( 100U )
+
+static uint64_t u64SIM_iHostUs( void );
+static void vSIM_iPrintPhase( const char * Fpcz8Name,
+                              uint32_t Fu32NbOps,
+                              uint64_t Fu64SimUs,
+                              uint64_t Fu64HostUs );
+static void vSIM_iPrintCounters( void );
+#if EEPROM_STATS_ENABLE
+static void vSIM_iPrintDriverStats( void );
+#endif
+
+
+int main( int argc,
+          char ** argv )
+{
+    uint32_t u32NbWrites = ( argc > 1 ) ? ( uint32_t ) strtoul( argv[ 1 ], NULL, 0 ) : 100000U;
+    uint32_t u32NbVars = ( argc > 2 ) ? ( uint32_t ) strtoul( argv[ 2 ], NULL, 0 ) : 64U;
+    const char * pcz8Image = ( argc > 3 ) ? argv[ 3 ] : NULL;
+    uint64_t u64SimStartUs;
+    uint64_t u64HostStartUs;
+    uint64_t u64TransferSimUs = 0U;
+    uint64_t u64TransferHostUs = 0U;
+    uint64_t u64StepUs;
+    uint32_t u32NbTransfers = 0U;
+    uint32_t u32Erases;
+    uint32_t u32Pos;
+    uint32_t u32Value;
+    Tst_FlashSimStats stStats;
+
+    if( ( u32NbVars == 0U ) || ( u32NbVars >= RECORD_SLOT_MARKER ) )
+    {
+        printf( "nb_variables must be in [1, %u]\n", RECORD_SLOT_MARKER - 1U );
+        return 1;
+    }
+
+    if( 0U != u8FLASH_SIM_eInit() )
+    {
+        printf( "can't map the eeprom region at 0x%08X\n", ( unsigned int ) FLASH_EEPROM_START_ADDR );
+        return 1;
+    }
+
+    /*boot*/
+    if( ( pcz8Image != NULL ) && ( 0U != u8FLASH_SIM_eLoadImage( pcz8Image ) ) )
+    {
+        printf( "no image loaded from %s, boot on an erased flash\n", pcz8Image );
+    }
+
+    u64SimStartUs = u64FLASH_SIM_eNowUs();
+    u64HostStartUs = u64SIM_iHostUs();
+
+    if( Du8EEPROM_eSUCCESS != u8EEPROM_eInit() )
+    {
+        printf( "init failed\n" );
+        return 1;
+    }
+
+    vSIM_iPrintPhase( "boot", 1U, u64FLASH_SIM_eNowUs() - u64SimStartUs, u64SIM_iHostUs() - u64HostStartUs );
+    vSIM_iPrintCounters();
+
+    /*writes, the pending transfers run between them as they would from an idle task*/
+    vFLASH_SIM_eResetStats();
+    u64SimStartUs = u64FLASH_SIM_eNowUs();
+    u64HostStartUs = u64SIM_iHostUs();
+
+    for( u32Pos = 0U; u32Pos < u32NbWrites; u32Pos++ )
+    {
+        if( Du8EEPROM_eSUCCESS != u8EEPROM_eWriteVar( ( uint16_t ) ( 1U + ( u32Pos % u32NbVars ) ), u32Pos ) )
+        {
+            printf( "write %u failed\n", u32Pos );
+            return 1;
+        }
+
+        vFLASH_SIM_eAdvanceUs( SIM_APP_TIME_BETWEEN_WRITES_US );
+
+        vFLASH_SIM_eGetStats( &stStats );
+        u32Erases = stStats.u32Erases;
+        u64StepUs = u64FLASH_SIM_eNowUs();
+        u64TransferHostUs -= u64SIM_iHostUs();
+
+        ( void ) u8EEPROM_eTransferStep( TRANSFER_STEP_UNLIMITED );
+
+        u64TransferHostUs += u64SIM_iHostUs();
+        u64TransferSimUs += u64FLASH_SIM_eNowUs() - u64StepUs;
+        vFLASH_SIM_eGetStats( &stStats );
+        u32NbTransfers += stStats.u32Erases - u32Erases;
+    }
+
+    /*the writes include the transfers they had to run themselves (e.g. RAM index overflow) and the waits for
+     * the background erase, "idle steps" counts the transfers completed by u8EEPROM_eTransferStep*/
+    vSIM_iPrintPhase( "writes", u32NbWrites,
+                      u64FLASH_SIM_eNowUs() - u64SimStartUs - ( ( uint64_t ) u32NbWrites * SIM_APP_TIME_BETWEEN_WRITES_US ),
+                      u64SIM_iHostUs() - u64HostStartUs );
+    vSIM_iPrintPhase( "idle steps", u32NbTransfers, u64TransferSimUs, u64TransferHostUs );
+    vSIM_iPrintCounters();
+
+    /*check*/
+    for( u32Pos = 0U; ( u32Pos < u32NbVars ) && ( u32Pos < u32NbWrites ); u32Pos++ )
+    {
+        if( ( Du8EEPROM_eSUCCESS != u8EEPROM_eReadVar( ( uint16_t ) ( 1U + u32Pos ), &u32Value ) ) ||
+            ( ( u32Value % u32NbVars ) != u32Pos ) )
+        {
+            printf( "variable %u : bad value\n", 1U + u32Pos );
+            return 1;
+        }
+    }
+
+    /*boot on the written flash*/
+    vFLASH_SIM_eResetStats();
+    u64SimStartUs = u64FLASH_SIM_eNowUs();
+    u64HostStartUs = u64SIM_iHostUs();
+
+    if( Du8EEPROM_eSUCCESS != u8EEPROM_eInit() )
+    {
+        printf( "reboot failed\n" );
+        return 1;
+    }
+
+    vSIM_iPrintPhase( "reboot", 1U, u64FLASH_SIM_eNowUs() - u64SimStartUs, u64SIM_iHostUs() - u64HostStartUs );
+    vSIM_iPrintCounters();
+
+    #if EEPROM_STATS_ENABLE
+        vSIM_iPrintDriverStats();
+    #endif
+
+    if( ( pcz8Image != NULL ) && ( 0U != u8FLASH_SIM_eSaveImage( pcz8Image ) ) )
+    {
+        printf( "can't save the image to %s\n", pcz8Image );
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief Get the host monotonic time
+ * @return Time in us
+ */
+static uint64_t u64SIM_iHostUs( void )
+{
+    struct timespec stNow;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &stNow );
+
+    return( ( ( uint64_t ) stNow.tv_sec * 1000000U ) + ( ( uint64_t ) stNow.tv_nsec / 1000U ) );
+}
+
+
+/**
+ * @brief Print the cost of a phase
+ * @param Fpcz8Name Name of the phase
+ * @param Fu32NbOps Number of operations of the phase (writes, transfers)
+ * @param Fu64SimUs Simulated flash time of the phase
+ * @param Fu64HostUs Host CPU time of the phase
+ */
+static void vSIM_iPrintPhase( const char * Fpcz8Name,
+                              uint32_t Fu32NbOps,
+                              uint64_t Fu64SimUs,
+                              uint64_t Fu64HostUs )
+{
+    printf( "%-10s ops %8u  flash %11.3f ms (%9.2f us/op)  host %9.3f ms\n",
+            Fpcz8Name, Fu32NbOps,
+            ( double ) Fu64SimUs / 1000.0, ( Fu32NbOps != 0U ) ? ( ( double ) Fu64SimUs / Fu32NbOps ) : 0.0,
+            ( double ) Fu64HostUs / 1000.0 );
+}
+
+
+/**
+ * @brief Print the flash counters since the last vFLASH_SIM_eResetStats
+ */
+static void vSIM_iPrintCounters( void )
+{
+    Tst_FlashSimStats stStats;
+
+    vFLASH_SIM_eGetStats( &stStats );
+
+    printf( "           programs %u (%u bytes)  erases %u  unlocks %u  sessions %u  erase waits %u  errors %u  flash busy %.3f ms\n",
+            stStats.u32Programs, stStats.u32ProgrammedBytes, stStats.u32Erases, stStats.u32Unlocks,
+            stStats.u32Sessions, stStats.u32EraseWaits, stStats.u32ProgramErrors,
+            ( double ) stStats.u64FlashBusyUs / 1000.0 );
+}
+
+
+#if EEPROM_STATS_ENABLE
+/**
+ * @brief Print the runtime statistics of the driver (u8EEPROM_eGetStats)
+ */
+static void vSIM_iPrintDriverStats( void )
+{
+    Tst_EepromStats stStats;
+    uint8_t u8PageId;
+
+    if( Du8EEPROM_eSUCCESS != u8EEPROM_eGetStats( &stStats ) )
+    {
+        return;
+    }
+
+    printf( "driver     programs %u  erases %u  transfers %u  write retries %u  writes %u (max %u us)\n",
+            stStats.u32Programs, stStats.u32Erases, stStats.u32Transfers, stStats.u32WriteRetries,
+            stStats.u32Writes, stStats.u32MaxWriteLatency );
+    printf( "           reads %u (%u packets scanned, max %u)  frees %u (%u packets scanned, max %u)\n",
+            stStats.u32Reads, stStats.u32ReadScannedPackets, stStats.u32MaxReadScan,
+            stStats.u32Frees, stStats.u32FreeScannedPackets, stStats.u32MaxFreeScan );
+    printf( "           active page slots: live %u stale %u free %u  erase counts:",
+            stStats.u32ActiveLiveSlots, stStats.u32ActiveStaleSlots, stStats.u32ActiveFreeSlots );
+
+    for( u8PageId = 0U; u8PageId < NB_EEPROM_PAGES; u8PageId++ )
+    {
+        printf( " %u", stStats.au32PageEraseCount[ u8PageId ] );
+    }
+
+    printf( "\n" );
+}
+#endif
@@ -0,0 +1,902 @@
+/*
+ * eeprom_sim_powerfail.c
+ * fyras1
+ *
+ * power-fail sweep of the driver over the simulated flash: a workload (single writes, batches, records,
+ * counter increments and transfer steps) is replayed once per crash point, the power is cut before the n-th flash step (program unit
+ * or erase, see vFLASH_SIM_eArmPowerCut), the driver reboots through u8EEPROM_eInit and the variables are
+ * checked against a reference model of the acknowledged writes. the recovered eeprom is then written again,
+ * rebooted and checked a second time. the cut step is left torn (PF_FAULT_MODEL, see vFLASH_SIM_eSetFaultModel),
+ * an erase cut is replayed with PF_ERASE_TEARS draws of its torn cells. the driver must not program a cell
+ * that is not erased after the reboot (e.g. a torn page taken for an erased one).
+ * built with EEPROM_HOTCOLD_ENABLE, the variables go through the hot/cold split (eeprom_hotcold.h): the written
+ * variables change over time, those that cool down are moved to the cold region by the hot transfers, and
+ * the cuts land in these moves.
+ * the image import (u8EEPROM_eImportImage) is swept the same way, from an eeprom spread over several pages:
+ * after the reboot the eeprom holds its old content, the image or nothing, never a mix of them (not built
+ * with EEPROM_HOTCOLD_ENABLE, the image is the cold region only).
+ * usage : eeprom_powerfail [nb_writes] [nb_variables] [jobs] [csv_file]
+ *         nb_writes defaults to PF_RING_CYCLES times the packets of the ring,
+ *         the crash points are shared by jobs forked processes (default: host cores),
+ *         csv_file gets one line per crash point (result and recovery time)
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "eeprom_drv.h"
+#include "eeprom_flash_sim.h"
+#include "eeprom_hotcold.h"
+
+/*simulated application time between two operations of the workload*/
+#define PF_APP_TIME_BETWEEN_OPS_US    ( 100U )
+#define PF_BATCH_SIZE                 ( 4U )
+#define PF_RECORD_MAX_SIZE            ( 48U )
+#define PF_SEED                       ( 0x2545F491U )
+#define PF_MAX_PRINTED_FAILURES       ( 20U )
+/*the default workload fills the ring of pages this many times, every page is erased and reused*/
+#define PF_RING_CYCLES                ( 4U )
+#ifndef PF_FAULT_MODEL
+    #define PF_FAULT_MODEL            ( FLASH_SIM_FAULT_TORN )
+#endif
+#define PF_ERASE_TEARS                ( 16U )
+/*hot/cold split: most writes go to a window of variables, moved to the next ones every PF_HOT_WINDOW_OPS*/
+#define PF_HOT_WINDOW                 ( 8U )
+#define PF_HOT_WINDOW_OPS             ( 512U )
+/*image import: writes before the export, then writes of the content the image replaces*/
+#define PF_IMPORT_WRITES              ( MAX_EEPROM_VARIABLES )
+
+/*variable API of the workload*/
+#if EEPROM_HOTCOLD_ENABLE
+    #define PF_INIT()                            u8EEPROM_eHotColdInit()
+    #define PF_WRITE_VAR( VIRT_ADDR, DATA )      u8EEPROM_eHotColdWriteVar( VIRT_ADDR, DATA )
+    #define PF_READ_VAR( VIRT_ADDR, VALUE )      u8EEPROM_eHotColdReadVar( VIRT_ADDR, VALUE )
+    #define PF_TRANSFER_STEP( MAX_PACKETS )      u8EEPROM_eHotColdTransferStep( MAX_PACKETS )
+#else
+    #define PF_INIT()                            u8EEPROM_eInit()
+    #define PF_WRITE_VAR( VIRT_ADDR, DATA )      u8EEPROM_eWriteVar( VIRT_ADDR, DATA )
+    #define PF_READ_VAR( VIRT_ADDR, VALUE )      u8EEPROM_eReadVar( VIRT_ADDR, VALUE )
+    #define PF_TRANSFER_STEP( MAX_PACKETS )      u8EEPROM_eTransferStep( MAX_PACKETS )
+#endif
+
+/*result of a crash point*/
+#define PF_RESULT_NOT_RUN             ( 0U )
+#define PF_RESULT_OK                  ( 1U )
+#define PF_RESULT_INIT_FAILED         ( 2U )  /*u8EEPROM_eInit failed after the cut*/
+#define PF_RESULT_LOST                ( 3U )  /*an acknowledged variable or record is missing (e.g. format at boot)*/
+#define PF_RESULT_CORRUPTED           ( 4U )  /*a variable or record has a value that was never written*/
+#define PF_RESULT_POST_FAILED         ( 5U )  /*write, reboot or check failed on the recovered eeprom*/
+#define PF_RESULT_NO_CUT              ( 6U )  /*the workload ended before the cut: replay not deterministic*/
+#define PF_RESULT_OVERWRITE           ( 7U )  /*a cell that was not erased was programmed after the reboot*/
+#define PF_NB_RESULTS                 ( 8U )
+
+/********************typedefs*************************/
+typedef struct
+{
+    uint8_t u8Result;
+    uint8_t u8StepKind;
+    uint16_t u16BadVirtAddr;
+    uint32_t u32Op;              /*workload operation interrupted by the cut*/
+    uint64_t u64RecoverySimUs;   /*u8EEPROM_eInit after the cut, simulated flash time*/
+    uint64_t u64RecoveryHostUs;  /*u8EEPROM_eInit after the cut, host time*/
+} Tst_CrashPoint;
+
+/*reference model: acknowledged content of the eeprom and the operation in progress*/
+typedef struct
+{
+    uint32_t au32Value[ RECORD_SLOT_MARKER ];
+    BOOL abStored[ RECORD_SLOT_MARKER ];
+    uint8_t au8Record[ PF_RECORD_MAX_SIZE ];
+    uint16_t u16RecordSize;
+    BOOL bRecordStored;
+    Tst_EppromPacket astPending[ PF_BATCH_SIZE ];
+    uint32_t u32NbPending;
+    uint8_t au8PendingRecord[ PF_RECORD_MAX_SIZE ];
+    uint16_t u16PendingRecordSize;
+    BOOL bRecordPending;
+} Tst_PfModel;
+
+static const char * const apcz8Results[ PF_NB_RESULTS ] =
+{
+    "not run", "ok", "init failed", "lost", "corrupted", "post-check failed", "no cut", "overwrite"
+};
+
+static uint32_t u32NbVars;
+static uint16_t u16CounterVirtAddr;
+static uint16_t u16RecordVirtAddr;
+static Tst_PfModel stModel;
+static uint32_t u32Rand;
+static uint32_t u32CurrentOp;
+static uint8_t u8CutStepKind;
+static jmp_buf stCutJmp;
+static Tst_PfModel stImportModel;
+static const Tst_PfModel stEmptyModel;
+static uint8_t au8Image[ EEPROM_IMAGE_SIZE( MAX_EEPROM_VARIABLES ) ];
+static uint32_t u32ImageSize;
+
+
+static uint64_t u64PF_iHostUs( void );
+static uint32_t u32PF_iRand( void );
+static uint16_t u16PF_iPickVar( uint32_t Fu32Draw );
+static void vPF_iPowerCut( uint8_t Fu8StepKind );
+static uint8_t u8PF_iBoot( void );
+static uint8_t u8PF_iRunWorkload( uint32_t Fu32NbWrites );
+static uint8_t u8PF_iCheck( uint16_t * Fpu16BadVirtAddr );
+static uint8_t u8PF_iPostCheck( uint16_t * Fpu16BadVirtAddr );
+static uint8_t u8PF_iPrepareImport( void );
+static uint16_t u16PF_iFirstMismatch( const Tst_PfModel * Fpst );
+static uint8_t u8PF_iCheckImport( uint16_t * Fpu16BadVirtAddr );
+static uint8_t u8PF_iRunImport( void );
+static BOOL bPF_iSweepImport( void );
+static void vPF_iRunCut( uint32_t Fu32Cut,
+                         uint32_t Fu32NbWrites,
+                         BOOL FbImport,
+                         Tst_CrashPoint * Fpst );
+static void vPF_iRunCrashPoint( uint32_t Fu32Cut,
+                                uint32_t Fu32NbWrites,
+                                BOOL FbImport,
+                                Tst_CrashPoint * Fpst );
+
+
+int main( int argc,
+          char ** argv )
+{
+    uint32_t u32NbWrites = ( argc > 1 ) ? ( uint32_t ) strtoul( argv[ 1 ], NULL, 0 ) :
+                           ( PF_RING_CYCLES * NB_EEPROM_PAGES * MAX_EEPROM_VARIABLES );
+    uint32_t u32NbJobs = ( argc > 3 ) ? ( uint32_t ) strtoul( argv[ 3 ], NULL, 0 ) : ( uint32_t ) sysconf( _SC_NPROCESSORS_ONLN );
+    const char * pcz8Csv = ( argc > 4 ) ? argv[ 4 ] : NULL;
+    uint32_t au32NbResults[ PF_NB_RESULTS ] = { 0U };
+    uint32_t au32NbSteps[ 2 ] = { 0U };
+    uint32_t u32NbCuts;
+    uint32_t u32Cut;
+    uint32_t u32Job;
+    uint32_t u32NbPrinted = 0U;
+    uint32_t u32WorstCut = 0U;
+    uint64_t u64SumSimUs = 0U;
+    uint64_t u64SumHostUs = 0U;
+    uint64_t u64MaxHostUs = 0U;
+    uint64_t u64HostStartUs;
+    Tst_CrashPoint * pstCuts;
+    Tst_CrashPoint * pst;
+    FILE * pFile;
+    pid_t iPid;
+    int iStatus;
+
+    u32NbVars = ( argc > 2 ) ? ( uint32_t ) strtoul( argv[ 2 ], NULL, 0 ) : 48U;
+
+    if( ( u32NbVars < PF_BATCH_SIZE ) || ( u32NbVars >= ( COUNTER_TALLY_MARKER - 2U ) ) )
+    {
+        printf( "nb_variables must be in [%u, %u]\n", PF_BATCH_SIZE, COUNTER_TALLY_MARKER - 3U );
+        return 1;
+    }
+
+    /*the counter is checked with the variables, it is only written by its increments*/
+    u16CounterVirtAddr = ( uint16_t ) ( u32NbVars + 1U );
+    u16RecordVirtAddr = ( uint16_t ) ( u32NbVars + 2U );
+
+    if( u32NbJobs == 0U )
+    {
+        u32NbJobs = 1U;
+    }
+
+    if( 0U != u8FLASH_SIM_eInit() )
+    {
+        printf( "can't map the eeprom region at 0x%08X\n", ( unsigned int ) FLASH_EEPROM_START_ADDR );
+        return 1;
+    }
+
+    /*reference run: number of flash steps of the workload = number of crash points*/
+    if( Du8EEPROM_eSUCCESS != u8PF_iBoot() )
+    {
+        printf( "init failed\n" );
+        return 1;
+    }
+
+    u32NbCuts = u32FLASH_SIM_eGetSteps();
+
+    if( Du8EEPROM_eSUCCESS != u8PF_iRunWorkload( u32NbWrites ) )
+    {
+        printf( "workload failed without power cut (op %u)\n", u32CurrentOp );
+        return 1;
+    }
+
+    u32NbCuts = u32FLASH_SIM_eGetSteps() - u32NbCuts;
+    printf( "workload  %u writes on %u variables + 1 counter + 1 record, %u pages of %u bytes, %u flash steps, %s cuts, %u jobs\n",
+            u32NbWrites, u32NbVars, NB_EEPROM_PAGES, EEPROM_PAGE_SIZE, u32NbCuts,
+            ( PF_FAULT_MODEL == FLASH_SIM_FAULT_TORN ) ? "torn" : "clean", u32NbJobs );
+
+    pstCuts = ( Tst_CrashPoint * ) mmap( NULL, ( ( size_t ) u32NbCuts + 1U ) * sizeof( Tst_CrashPoint ), PROT_READ | PROT_WRITE,
+                                         MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+
+    if( pstCuts == MAP_FAILED )
+    {
+        printf( "can't allocate the results\n" );
+        return 1;
+    }
+
+    memset( pstCuts, 0, ( ( size_t ) u32NbCuts + 1U ) * sizeof( Tst_CrashPoint ) );
+
+    /*crash point n runs in job n % jobs, the driver state of the job is reset by each boot*/
+    u64HostStartUs = u64PF_iHostUs();
+
+    for( u32Job = 0U; u32Job < u32NbJobs; u32Job++ )
+    {
+        iPid = fork();
+
+        if( iPid < 0 )
+        {
+            printf( "fork failed\n" );
+            return 1;
+        }
+
+        if( iPid == 0 )
+        {
+            for( u32Cut = 1U + u32Job; u32Cut <= u32NbCuts; u32Cut += u32NbJobs )
+            {
+                vPF_iRunCrashPoint( u32Cut, u32NbWrites, FALSE, &pstCuts[ u32Cut ] );
+            }
+
+            _exit( 0 );
+        }
+    }
+
+    while( wait( &iStatus ) > 0 )
+    {
+    }
+
+    /*report*/
+    pFile = ( pcz8Csv != NULL ) ? fopen( pcz8Csv, "w" ) : NULL;
+
+    if( pFile != NULL )
+    {
+        fprintf( pFile, "cut,step,op,result,virt_addr,recovery_flash_us,recovery_host_us\n" );
+    }
+
+    for( u32Cut = 1U; u32Cut <= u32NbCuts; u32Cut++ )
+    {
+        pst = &pstCuts[ u32Cut ];
+        au32NbResults[ pst->u8Result ]++;
+        au32NbSteps[ pst->u8StepKind ]++;
+        u64SumSimUs += pst->u64RecoverySimUs;
+        u64SumHostUs += pst->u64RecoveryHostUs;
+
+        if( pst->u64RecoverySimUs > pstCuts[ u32WorstCut ].u64RecoverySimUs )
+        {
+            u32WorstCut = u32Cut;
+        }
+
+        if( pst->u64RecoveryHostUs > u64MaxHostUs )
+        {
+            u64MaxHostUs = pst->u64RecoveryHostUs;
+        }
+
+        if( ( pst->u8Result != PF_RESULT_OK ) && ( u32NbPrinted < PF_MAX_PRINTED_FAILURES ) )
+        {
+            printf( "cut %u (%s, op %u) : %s, virtual address %u\n", u32Cut,
+                    ( pst->u8StepKind == FLASH_SIM_STEP_ERASE ) ? "erase" : "program", pst->u32Op,
+                    apcz8Results[ pst->u8Result ], pst->u16BadVirtAddr );
+            u32NbPrinted++;
+        }
+
+        if( pFile != NULL )
+        {
+            fprintf( pFile, "%u,%s,%u,%s,%u,%llu,%llu\n", u32Cut,
+                     ( pst->u8StepKind == FLASH_SIM_STEP_ERASE ) ? "erase" : "program", pst->u32Op,
+                     apcz8Results[ pst->u8Result ], pst->u16BadVirtAddr,
+                     ( unsigned long long ) pst->u64RecoverySimUs, ( unsigned long long ) pst->u64RecoveryHostUs );
+        }
+    }
+
+    if( pFile != NULL )
+    {
+        ( void ) fclose( pFile );
+    }
+    else if( pcz8Csv != NULL )
+    {
+        printf( "can't write %s\n", pcz8Csv );
+    }
+
+    printf( "crash     %u points (%u programs, %u erases) in %.3f s\n", u32NbCuts,
+            au32NbSteps[ FLASH_SIM_STEP_PROGRAM ], au32NbSteps[ FLASH_SIM_STEP_ERASE ],
+            ( double ) ( u64PF_iHostUs() - u64HostStartUs ) / 1000000.0 );
+    printf( "results   ok %u  init failed %u  lost %u  corrupted %u  post-check failed %u  overwrite %u  no cut %u  not run %u\n",
+            au32NbResults[ PF_RESULT_OK ], au32NbResults[ PF_RESULT_INIT_FAILED ], au32NbResults[ PF_RESULT_LOST ],
+            au32NbResults[ PF_RESULT_CORRUPTED ], au32NbResults[ PF_RESULT_POST_FAILED ], au32NbResults[ PF_RESULT_OVERWRITE ],
+            au32NbResults[ PF_RESULT_NO_CUT ], au32NbResults[ PF_RESULT_NOT_RUN ] );
+    printf( "recovery  flash avg %.3f ms max %.3f ms (cut %u)  host avg %.1f us max %llu us\n",
+            ( double ) u64SumSimUs / ( 1000.0 * u32NbCuts ),
+            ( double ) pstCuts[ u32WorstCut ].u64RecoverySimUs / 1000.0, u32WorstCut,
+            ( double ) u64SumHostUs / u32NbCuts, ( unsigned long long ) u64MaxHostUs );
+
+    if( ( FALSE == bPF_iSweepImport() ) || ( au32NbResults[ PF_RESULT_OK ] != u32NbCuts ) )
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief Get the host monotonic time
+ * @return Time in us
+ */
+static uint64_t u64PF_iHostUs( void )
+{
+    struct timespec stNow;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &stNow );
+
+    return( ( ( uint64_t ) stNow.tv_sec * 1000000U ) + ( ( uint64_t ) stNow.tv_nsec / 1000U ) );
+}
+
+
+/**
+ * @brief Pseudo random numbers of the workload (xorshift32), the same sequence for every crash point
+ * @return Next number
+ */
+static uint32_t u32PF_iRand( void )
+{
+    u32Rand ^= u32Rand << 13;
+    u32Rand ^= u32Rand >> 17;
+    u32Rand ^= u32Rand << 5;
+
+    return u32Rand;
+}
+
+
+/**
+ * @brief Choose the variable of a single write
+ * @param Fu32Draw Random draw of the operation
+ * @return Virtual address of the variable
+ */
+static uint16_t u16PF_iPickVar( uint32_t Fu32Draw )
+{
+    #if EEPROM_HOTCOLD_ENABLE
+        if( ( ( Fu32Draw >> 24 ) % 4U ) != 0U )
+        {
+            /*hot for a while, then cools down and is moved out of the hot region*/
+            return( ( uint16_t ) ( 1U + ( ( ( ( u32CurrentOp / PF_HOT_WINDOW_OPS ) * PF_HOT_WINDOW ) +
+                                            ( ( Fu32Draw >> 8 ) % PF_HOT_WINDOW ) ) % u32NbVars ) ) );
+        }
+    #endif
+
+    return( ( uint16_t ) ( 1U + ( ( Fu32Draw >> 8 ) % u32NbVars ) ) );
+}
+
+
+/**
+ * @brief Power cut handler of the simulated flash: leaves the driver where it was interrupted
+ * @param Fu8StepKind FLASH_SIM_STEP_PROGRAM or FLASH_SIM_STEP_ERASE
+ */
+static void vPF_iPowerCut( uint8_t Fu8StepKind )
+{
+    u8CutStepKind = Fu8StepKind;
+    longjmp( stCutJmp, 1 );
+}
+
+
+/**
+ * @brief Erase the simulated flash, boot the driver on it and reset the reference model and the workload
+ * @return Status code indicating the result of u8EEPROM_eInit (u8EEPROM_eHotColdInit)
+ */
+static uint8_t u8PF_iBoot( void )
+{
+    ( void ) u8FLASH_SIM_eInit();
+    memset( &stModel, 0, sizeof( stModel ) );
+    u32Rand = PF_SEED;
+    u32CurrentOp = 0U;
+
+    return PF_INIT();
+}
+
+
+/**
+ * @brief Run the workload, the reference model is updated when the driver acknowledges an operation
+ * @param Fu32NbWrites Number of write operations
+ * @return Status code indicating the result of the operation : Du8EEPROM_eSUCCESS or the failing driver status
+ */
+static uint8_t u8PF_iRunWorkload( uint32_t Fu32NbWrites )
+{
+    uint32_t u32Draw;
+    uint32_t u32Pos;
+    uint8_t u8FnRet;
+
+    for( u32CurrentOp = 0U; u32CurrentOp < Fu32NbWrites; u32CurrentOp++ )
+    {
+        u32Draw = u32PF_iRand();
+
+        if( ( EEPROM_HOTCOLD_ENABLE == 0U ) && ( ( u32Draw % 16U ) == 0U ) )
+        {
+            /*batch of consecutive variables (no batch in the hot/cold split)*/
+            for( u32Pos = 0U; u32Pos < PF_BATCH_SIZE; u32Pos++ )
+            {
+                stModel.astPending[ u32Pos ].u16VirtAddr = ( uint16_t ) ( 1U + ( ( ( u32Draw >> 8 ) + u32Pos ) % u32NbVars ) );
+                stModel.astPending[ u32Pos ].u32DataVal = u32PF_iRand();
+            }
+
+            stModel.u32NbPending = PF_BATCH_SIZE;
+            u8FnRet = u8EEPROM_eWriteVars( stModel.astPending, PF_BATCH_SIZE );
+        }
+        else if( ( u32Draw % 32U ) == 1U )
+        {
+            stModel.u16PendingRecordSize = ( uint16_t ) ( 1U + ( ( u32Draw >> 8 ) % PF_RECORD_MAX_SIZE ) );
+
+            for( u32Pos = 0U; u32Pos < stModel.u16PendingRecordSize; u32Pos++ )
+            {
+                stModel.au8PendingRecord[ u32Pos ] = ( uint8_t ) u32PF_iRand();
+            }
+
+            stModel.bRecordPending = TRUE;
+            u8FnRet = u8EEPROM_eWriteRecord( u16RecordVirtAddr, stModel.au8PendingRecord, stModel.u16PendingRecordSize );
+        }
+    #if EEPROM_COUNTER_ENABLE
+        else if( ( u32Draw % 4U ) == 3U )
+        {
+            /*in place in the tally, or a new tally then its base: the old or the new value after a cut*/
+            stModel.astPending[ 0 ].u16VirtAddr = u16CounterVirtAddr;
+            stModel.astPending[ 0 ].u32DataVal = stModel.au32Value[ u16CounterVirtAddr ] + 1U;
+            stModel.u32NbPending = 1U;
+            u8FnRet = u8EEPROM_eIncrementCounter( u16CounterVirtAddr, NULL );
+        }
+    #endif
+        else
+        {
+            stModel.astPending[ 0 ].u16VirtAddr = u16PF_iPickVar( u32Draw );
+            stModel.astPending[ 0 ].u32DataVal = u32PF_iRand();
+            stModel.u32NbPending = 1U;
+            u8FnRet = PF_WRITE_VAR( stModel.astPending[ 0 ].u16VirtAddr, stModel.astPending[ 0 ].u32DataVal );
+        }
+
+        if( u8FnRet != Du8EEPROM_eSUCCESS )
+        {
+            return u8FnRet;
+        }
+
+        /*acknowledged*/
+        for( u32Pos = 0U; u32Pos < stModel.u32NbPending; u32Pos++ )
+        {
+            stModel.au32Value[ stModel.astPending[ u32Pos ].u16VirtAddr ] = stModel.astPending[ u32Pos ].u32DataVal;
+            stModel.abStored[ stModel.astPending[ u32Pos ].u16VirtAddr ] = TRUE;
+        }
+
+        if( stModel.bRecordPending == TRUE )
+        {
+            memcpy( stModel.au8Record, stModel.au8PendingRecord, stModel.u16PendingRecordSize );
+            stModel.u16RecordSize = stModel.u16PendingRecordSize;
+            stModel.bRecordStored = TRUE;
+        }
+
+        stModel.u32NbPending = 0U;
+        stModel.bRecordPending = FALSE;
+
+        vFLASH_SIM_eAdvanceUs( PF_APP_TIME_BETWEEN_OPS_US );
+
+        if( ( u32Draw % 4U ) == 2U )
+        {
+            ( void ) PF_TRANSFER_STEP( 1U + ( ( u32Draw >> 16 ) % 64U ) );
+        }
+    }
+
+    return Du8EEPROM_eSUCCESS;
+}
+
+
+/**
+ * @brief Check the eeprom against the reference model: each variable and the record hold the acknowledged
+ *        value, or the value of the operation interrupted by the cut. the model is updated to what was read
+ * @param Fpu16BadVirtAddr Pointer to store the virtual address of the first mismatch
+ * @return PF_RESULT_OK, PF_RESULT_LOST or PF_RESULT_CORRUPTED
+ */
+static uint8_t u8PF_iCheck( uint16_t * Fpu16BadVirtAddr )
+{
+    uint8_t au8Record[ EEPROM_RECORD_MAX_SIZE ];
+    uint16_t u16Size = 0U;
+    uint16_t u16VirtAddr;
+    uint32_t u32Value;
+    uint32_t u32Pos;
+    BOOL bFound;
+    BOOL bPending;
+
+    for( u16VirtAddr = 1U; u16VirtAddr <= u16CounterVirtAddr; u16VirtAddr++ )
+    {
+        bFound = ( Du8EEPROM_eSUCCESS == PF_READ_VAR( u16VirtAddr, &u32Value ) ) ? TRUE : FALSE;
+        bPending = FALSE;
+
+        for( u32Pos = 0U; u32Pos < stModel.u32NbPending; u32Pos++ )
+        {
+            if( ( stModel.astPending[ u32Pos ].u16VirtAddr == u16VirtAddr ) &&
+                ( bFound == TRUE ) && ( stModel.astPending[ u32Pos ].u32DataVal == u32Value ) )
+            {
+                bPending = TRUE;
+            }
+        }
+
+        if( bPending == TRUE )
+        {
+            stModel.au32Value[ u16VirtAddr ] = u32Value;
+            stModel.abStored[ u16VirtAddr ] = TRUE;
+        }
+        else if( ( bFound == FALSE ) && ( stModel.abStored[ u16VirtAddr ] == TRUE ) )
+        {
+            *Fpu16BadVirtAddr = u16VirtAddr;
+            return PF_RESULT_LOST;
+        }
+        else if( ( bFound == TRUE ) && ( ( stModel.abStored[ u16VirtAddr ] == FALSE ) || ( stModel.au32Value[ u16VirtAddr ] != u32Value ) ) )
+        {
+            *Fpu16BadVirtAddr = u16VirtAddr;
+            return PF_RESULT_CORRUPTED;
+        }
+    }
+
+    bFound = ( Du8EEPROM_eSUCCESS == u8EEPROM_eReadRecord( u16RecordVirtAddr, au8Record, sizeof( au8Record ), &u16Size ) ) ? TRUE : FALSE;
+    *Fpu16BadVirtAddr = u16RecordVirtAddr;
+
+    if( ( bFound == TRUE ) && ( stModel.bRecordPending == TRUE ) &&
+        ( u16Size == stModel.u16PendingRecordSize ) && ( 0 == memcmp( au8Record, stModel.au8PendingRecord, u16Size ) ) )
+    {
+        memcpy( stModel.au8Record, au8Record, u16Size );
+        stModel.u16RecordSize = u16Size;
+        stModel.bRecordStored = TRUE;
+    }
+    else if( ( bFound == FALSE ) && ( stModel.bRecordStored == TRUE ) )
+    {
+        return PF_RESULT_LOST;
+    }
+    else if( ( bFound == TRUE ) &&
+             ( ( stModel.bRecordStored == FALSE ) || ( u16Size != stModel.u16RecordSize ) ||
+               ( 0 != memcmp( au8Record, stModel.au8Record, u16Size ) ) ) )
+    {
+        return PF_RESULT_CORRUPTED;
+    }
+
+    *Fpu16BadVirtAddr = 0U;
+    stModel.u32NbPending = 0U;
+    stModel.bRecordPending = FALSE;
+
+    return PF_RESULT_OK;
+}
+
+
+/**
+ * @brief Use the recovered eeprom: write the variables until every page of the ring was reused (a page left
+ *        torn by the cut is prepared again), increment the counter, reboot and check again
+ * @param Fpu16BadVirtAddr Pointer to store the virtual address of the first mismatch
+ * @return PF_RESULT_OK or PF_RESULT_POST_FAILED
+ */
+static uint8_t u8PF_iPostCheck( uint16_t * Fpu16BadVirtAddr )
+{
+    uint32_t u32NbPostWrites = NB_EEPROM_PAGES * MAX_EEPROM_VARIABLES;
+    uint32_t u32Pos;
+    uint16_t u16VirtAddr;
+
+    for( u32Pos = 0U; ( u32Pos < u32NbPostWrites ) || ( u32Pos < u32NbVars ); u32Pos++ )
+    {
+        u16VirtAddr = ( uint16_t ) ( 1U + ( u32Pos % u32NbVars ) );
+
+        if( Du8EEPROM_eSUCCESS != PF_WRITE_VAR( u16VirtAddr, ~stModel.au32Value[ u16VirtAddr ] ) )
+        {
+            *Fpu16BadVirtAddr = u16VirtAddr;
+            return PF_RESULT_POST_FAILED;
+        }
+
+        stModel.au32Value[ u16VirtAddr ] = ~stModel.au32Value[ u16VirtAddr ];
+        stModel.abStored[ u16VirtAddr ] = TRUE;
+    }
+
+    #if EEPROM_COUNTER_ENABLE
+        /*the recovered counter counts on from its value*/
+        if( Du8EEPROM_eSUCCESS != u8EEPROM_eIncrementCounter( u16CounterVirtAddr, NULL ) )
+        {
+            *Fpu16BadVirtAddr = u16CounterVirtAddr;
+            return PF_RESULT_POST_FAILED;
+        }
+
+        stModel.au32Value[ u16CounterVirtAddr ]++;
+        stModel.abStored[ u16CounterVirtAddr ] = TRUE;
+    #endif
+
+    vFLASH_SIM_ePowerCycle();
+
+    if( ( Du8EEPROM_eSUCCESS != PF_INIT() ) || ( PF_RESULT_OK != u8PF_iCheck( Fpu16BadVirtAddr ) ) )
+    {
+        return PF_RESULT_POST_FAILED;
+    }
+
+    return PF_RESULT_OK;
+}
+
+
+/**
+ * @brief Boot on an erased flash, write, export the image (content of stImportModel), then write again until
+ *        a page transfer is pending: the import replaces an eeprom spread over several pages
+ * @return Status code indicating the result of the operation : Du8EEPROM_eSUCCESS or the failing driver status
+ */
+static uint8_t u8PF_iPrepareImport( void )
+{
+    uint32_t u32Pos;
+    uint8_t u8FnRet;
+
+    u8FnRet = u8PF_iBoot();
+
+    if( u8FnRet == Du8EEPROM_eSUCCESS )
+    {
+        u8FnRet = u8PF_iRunWorkload( PF_IMPORT_WRITES );
+    }
+
+    if( u8FnRet == Du8EEPROM_eSUCCESS )
+    {
+        u8FnRet = u8EEPROM_eExportImage( au8Image, sizeof( au8Image ), &u32ImageSize );
+        stImportModel = stModel;
+    }
+
+    if( u8FnRet == Du8EEPROM_eSUCCESS )
+    {
+        u8FnRet = u8PF_iRunWorkload( PF_IMPORT_WRITES );
+    }
+
+    for( u32Pos = 0U; ( u32Pos < PF_IMPORT_WRITES ) && ( u8FnRet == Du8EEPROM_eSUCCESS ) &&
+         ( FALSE == bEEPROM_eIsTransferPending() ); u32Pos++ )
+    {
+        u8FnRet = u8PF_iRunWorkload( 1U );
+    }
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Import the image of u8PF_iPrepareImport
+ * @return Status code indicating the result of u8EEPROM_eImportImage
+ */
+static uint8_t u8PF_iRunImport( void )
+{
+    u32CurrentOp = 0U;
+
+    return u8EEPROM_eImportImage( au8Image, u32ImageSize );
+}
+
+
+/**
+ * @brief Sweep the image import: a crash point per flash step of u8EEPROM_eImportImage, its mount included
+ * @return TRUE if every crash point is ok
+ */
+static BOOL bPF_iSweepImport( void )
+{
+    uint32_t au32NbResults[ PF_NB_RESULTS ] = { 0U };
+    uint32_t au32NbSteps[ 2 ] = { 0U };
+    uint32_t u32NbCuts;
+    uint32_t u32Cut;
+    uint32_t u32NbPrinted = 0U;
+    uint64_t u64HostStartUs;
+    Tst_CrashPoint stCut;
+
+    if( EEPROM_HOTCOLD_ENABLE != 0U )
+    {
+        printf( "import    not swept, the image is the cold region of the hot/cold split\n" );
+        return TRUE;
+    }
+
+    /*reference run*/
+    vFLASH_SIM_eSetFaultModel( PF_FAULT_MODEL, PF_SEED );
+
+    if( Du8EEPROM_eSUCCESS != u8PF_iPrepareImport() )
+    {
+        printf( "import    export failed without power cut\n" );
+        return FALSE;
+    }
+
+    u32NbCuts = u32FLASH_SIM_eGetSteps();
+
+    if( ( Du8EEPROM_eSUCCESS != u8PF_iRunImport() ) || ( 0U != u16PF_iFirstMismatch( &stImportModel ) ) )
+    {
+        printf( "import    failed without power cut\n" );
+        return FALSE;
+    }
+
+    u32NbCuts = u32FLASH_SIM_eGetSteps() - u32NbCuts;
+    u64HostStartUs = u64PF_iHostUs();
+
+    for( u32Cut = 1U; u32Cut <= u32NbCuts; u32Cut++ )
+    {
+        memset( &stCut, 0, sizeof( stCut ) );
+        vPF_iRunCrashPoint( u32Cut, PF_IMPORT_WRITES, TRUE, &stCut );
+        au32NbResults[ stCut.u8Result ]++;
+        au32NbSteps[ stCut.u8StepKind ]++;
+
+        if( ( stCut.u8Result != PF_RESULT_OK ) && ( u32NbPrinted < PF_MAX_PRINTED_FAILURES ) )
+        {
+            printf( "import cut %u (%s) : %s, virtual address %u\n", u32Cut,
+                    ( stCut.u8StepKind == FLASH_SIM_STEP_ERASE ) ? "erase" : "program",
+                    apcz8Results[ stCut.u8Result ], stCut.u16BadVirtAddr );
+            u32NbPrinted++;
+        }
+    }
+
+    printf( "import    %u points (%u programs, %u erases) in %.3f s\n", u32NbCuts,
+            au32NbSteps[ FLASH_SIM_STEP_PROGRAM ], au32NbSteps[ FLASH_SIM_STEP_ERASE ],
+            ( double ) ( u64PF_iHostUs() - u64HostStartUs ) / 1000000.0 );
+    printf( "results   ok %u  init failed %u  lost %u  corrupted %u  post-check failed %u  overwrite %u  no cut %u\n",
+            au32NbResults[ PF_RESULT_OK ], au32NbResults[ PF_RESULT_INIT_FAILED ], au32NbResults[ PF_RESULT_LOST ],
+            au32NbResults[ PF_RESULT_CORRUPTED ], au32NbResults[ PF_RESULT_POST_FAILED ], au32NbResults[ PF_RESULT_OVERWRITE ],
+            au32NbResults[ PF_RESULT_NO_CUT ] );
+
+    return( ( au32NbResults[ PF_RESULT_OK ] == u32NbCuts ) ? TRUE : FALSE );
+}
+
+
+/**
+ * @brief Compare the eeprom with a content, variable by variable then the record
+ * @param Fpst Content
+ * @return Virtual address of the first mismatch, 0 if the eeprom holds exactly the content
+ */
+static uint16_t u16PF_iFirstMismatch( const Tst_PfModel * Fpst )
+{
+    uint8_t au8Record[ EEPROM_RECORD_MAX_SIZE ];
+    uint16_t u16Size = 0U;
+    uint16_t u16VirtAddr;
+    uint32_t u32Value;
+    BOOL bFound;
+
+    for( u16VirtAddr = 1U; u16VirtAddr <= u16CounterVirtAddr; u16VirtAddr++ )
+    {
+        bFound = ( Du8EEPROM_eSUCCESS == u8EEPROM_eReadVar( u16VirtAddr, &u32Value ) ) ? TRUE : FALSE;
+
+        if( ( bFound != Fpst->abStored[ u16VirtAddr ] ) || ( ( bFound == TRUE ) && ( u32Value != Fpst->au32Value[ u16VirtAddr ] ) ) )
+        {
+            return u16VirtAddr;
+        }
+    }
+
+    bFound = ( Du8EEPROM_eSUCCESS == u8EEPROM_eReadRecord( u16RecordVirtAddr, au8Record, sizeof( au8Record ), &u16Size ) ) ? TRUE : FALSE;
+
+    if( ( bFound != Fpst->bRecordStored ) ||
+        ( ( bFound == TRUE ) && ( ( u16Size != Fpst->u16RecordSize ) || ( 0 != memcmp( au8Record, Fpst->au8Record, u16Size ) ) ) ) )
+    {
+        return u16RecordVirtAddr;
+    }
+
+    return 0U;
+}
+
+
+/**
+ * @brief Check the eeprom after an import cut: it holds the content replaced by the import, the image or
+ *        nothing (formatted), the model is set to it
+ * @param Fpu16BadVirtAddr Pointer to store the first mismatch with the image
+ * @return PF_RESULT_OK or PF_RESULT_CORRUPTED (a mix of them)
+ */
+static uint8_t u8PF_iCheckImport( uint16_t * Fpu16BadVirtAddr )
+{
+    *Fpu16BadVirtAddr = u16PF_iFirstMismatch( &stImportModel );
+
+    if( *Fpu16BadVirtAddr == 0U )
+    {
+        stModel = stImportModel;
+    }
+    else if( 0U == u16PF_iFirstMismatch( &stEmptyModel ) )
+    {
+        stModel = stEmptyModel;
+    }
+    else if( 0U != u16PF_iFirstMismatch( &stModel ) )
+    {
+        return PF_RESULT_CORRUPTED;
+    }
+
+    *Fpu16BadVirtAddr = 0U;
+
+    return PF_RESULT_OK;
+}
+
+
+/**
+ * @brief Run a crash point, an erase cut again with other torn cells, and keep the first failure
+ * @param Fu32Cut Flash step of the cut, counted from the end of the first boot (of the import)
+ * @param Fu32NbWrites Number of write operations of the workload
+ * @param FbImport TRUE to cut the image import (u8PF_iRunImport), FALSE the workload
+ * @param Fpst Pointer to store the result
+ */
+static void vPF_iRunCrashPoint( uint32_t Fu32Cut,
+                                uint32_t Fu32NbWrites,
+                                BOOL FbImport,
+                                Tst_CrashPoint * Fpst )
+{
+    Tst_CrashPoint stTear;
+    uint32_t u32Tear;
+
+    vFLASH_SIM_eSetFaultModel( PF_FAULT_MODEL, PF_SEED );
+    vPF_iRunCut( Fu32Cut, Fu32NbWrites, FbImport, Fpst );
+
+    for( u32Tear = 1U; ( PF_FAULT_MODEL == FLASH_SIM_FAULT_TORN ) && ( u32Tear < PF_ERASE_TEARS ) &&
+         ( Fpst->u8StepKind == FLASH_SIM_STEP_ERASE ) && ( Fpst->u8Result == PF_RESULT_OK ); u32Tear++ )
+    {
+        memset( &stTear, 0, sizeof( stTear ) );
+        vFLASH_SIM_eSetFaultModel( PF_FAULT_MODEL, PF_SEED + u32Tear );
+        vPF_iRunCut( Fu32Cut, Fu32NbWrites, FbImport, &stTear );
+
+        if( stTear.u8Result != PF_RESULT_OK )
+        {
+            *Fpst = stTear;
+        }
+    }
+}
+
+
+/**
+ * @brief Replay the workload (the image import) with the power cut before a flash step, reboot and check the eeprom
+ * @param Fu32Cut Flash step of the cut, counted from the end of the first boot (of the import)
+ * @param Fu32NbWrites Number of write operations of the workload
+ * @param FbImport TRUE to cut the image import (u8PF_iRunImport), FALSE the workload
+ * @param Fpst Pointer to store the result
+ */
+static void vPF_iRunCut( uint32_t Fu32Cut,
+                         uint32_t Fu32NbWrites,
+                         BOOL FbImport,
+                         Tst_CrashPoint * Fpst )
+{
+    Tst_FlashSimStats stStats;
+    uint64_t u64SimStartUs;
+    uint64_t u64HostStartUs;
+    uint16_t u16BadVirtAddr = 0U;
+    uint8_t u8InitRet;
+
+    if( Du8EEPROM_eSUCCESS != ( ( FbImport == TRUE ) ? u8PF_iPrepareImport() : u8PF_iBoot() ) )
+    {
+        Fpst->u8Result = PF_RESULT_INIT_FAILED;
+        return;
+    }
+
+    vFLASH_SIM_eArmPowerCut( Fu32Cut, vPF_iPowerCut );
+
+    if( 0 == setjmp( stCutJmp ) )
+    {
+        ( void ) ( ( FbImport == TRUE ) ? u8PF_iRunImport() : u8PF_iRunWorkload( Fu32NbWrites ) );
+        vFLASH_SIM_eArmPowerCut( 0U, NULL );
+        Fpst->u8Result = PF_RESULT_NO_CUT;
+        return;
+    }
+
+    Fpst->u8StepKind = u8CutStepKind;
+    Fpst->u32Op = u32CurrentOp;
+
+    /*reboot*/
+    vFLASH_SIM_ePowerCycle();
+    vFLASH_SIM_eResetStats();
+    u64SimStartUs = u64FLASH_SIM_eNowUs();
+    u64HostStartUs = u64PF_iHostUs();
+
+    u8InitRet = PF_INIT();
+
+    Fpst->u64RecoveryHostUs = u64PF_iHostUs() - u64HostStartUs;
+    Fpst->u64RecoverySimUs = u64FLASH_SIM_eNowUs() - u64SimStartUs;
+
+    if( u8InitRet != Du8EEPROM_eSUCCESS )
+    {
+        Fpst->u8Result = PF_RESULT_INIT_FAILED;
+        return;
+    }
+
+    Fpst->u8Result = ( FbImport == TRUE ) ? u8PF_iCheckImport( &u16BadVirtAddr ) : u8PF_iCheck( &u16BadVirtAddr );
+
+    if( Fpst->u8Result == PF_RESULT_OK )
+    {
+        Fpst->u8Result = u8PF_iPostCheck( &u16BadVirtAddr );
+    }
+
+    vFLASH_SIM_eGetStats( &stStats );
+
+    if( ( Fpst->u8Result == PF_RESULT_OK ) && ( stStats.u32ProgramErrors != 0U ) )
+    {
+        Fpst->u8Result = PF_RESULT_OVERWRITE;
+    }
+
+    Fpst->u16BadVirtAddr = u16BadVirtAddr;
+}
@@ -0,0 +1,34 @@
+/*
+ * stm32f2xx_hal.h
+ * fyras1
+ *
+ * host stand-in of the HAL header for the flash simulator build (Sim/Makefile):
+ * only the definitions used by eeprom_mcu_itf.h, the flash itself is eeprom_flash_sim.c
+ */
+
+#ifndef EEPROM_EMUL_SIM_HAL_H_
+#define EEPROM_EMUL_SIM_HAL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FLASH_SECTOR_0                  ( 0U )
+#define FLASH_SECTOR_1                  ( 1U )
+#define FLASH_SECTOR_2                  ( 2U )
+#define FLASH_SECTOR_3                  ( 3U )
+#define FLASH_SECTOR_4                  ( 4U )
+#define FLASH_SECTOR_5                  ( 5U )
+#define FLASH_SECTOR_6                  ( 6U )
+#define FLASH_SECTOR_7                  ( 7U )
+
+#define FLASH_VOLTAGE_RANGE_1           ( 0U )
+#define FLASH_VOLTAGE_RANGE_2           ( 1U )
+#define FLASH_VOLTAGE_RANGE_3           ( 2U )
+#define FLASH_VOLTAGE_RANGE_4           ( 3U )
+
+#define FLASH_TYPEPROGRAM_BYTE          ( 0U )
+#define FLASH_TYPEPROGRAM_HALFWORD      ( 1U )
+#define FLASH_TYPEPROGRAM_WORD          ( 2U )
+#define FLASH_TYPEPROGRAM_DOUBLEWORD    ( 3U )
+
+#endif /* EEPROM_EMUL_SIM_HAL_H_ */
@@ -0,0 +1,496 @@
+/*
+ * eeprom_cache.c
+ * fyras1
+ *
+ */
+
+#include "eeprom_cache.h"
+
+#if EEPROM_CACHE_ENABLE
+
+#if ( EEPROM_CACHE_FLUSH_THRESHOLD > EEPROM_CACHE_SIZE ) || ( EEPROM_CACHE_FLUSH_THRESHOLD == 0U )
+    #error "EEPROM_CACHE_FLUSH_THRESHOLD must be in [1, EEPROM_CACHE_SIZE]"
+#endif
+
+static Tst_EepromCacheEntry astEEPROM_iCache[ EEPROM_CACHE_SIZE ];
+static uint32_t u32DirtyCount = 0U;
+static uint32_t u32EvictCursor = 0U;   /*next entry checked for eviction (round robin)*/
+static BOOL bDirtyTimerStarted = FALSE; /*u32DirtySinceMs is valid*/
+static uint32_t u32DirtySinceMs = 0U;  /*first tick that saw dirty variables*/
+static BOOL bCacheWriting = FALSE;     /*the cache writes its own variables, no invalidation*/
+
+/*the writer mutex of the default EEPROM (recursive: the driver takes it again), the cache is shared by its writers*/
+#if EEPROM_THREAD_SAFE_ENABLE
+    #define EEPROM_CACHE_LOCK()      vFLASH_ITF_eMutexTake()
+    #define EEPROM_CACHE_UNLOCK()    vFLASH_ITF_eMutexGive()
+#else
+    #define EEPROM_CACHE_LOCK()
+    #define EEPROM_CACHE_UNLOCK()
+#endif
+
+
+/*Internal -----------*/
+
+
+/** @defgroup EEPROMCachePrivate_Func Private_Functions
+ * @{
+ */
+
+static Tst_EepromCacheEntry * pstEEPROM_iCacheFind( uint16_t Fu16VirtAddr );
+static Tst_EepromCacheEntry * pstEEPROM_iCacheAlloc( BOOL FbAllowCommit );
+static uint8_t u8EEPROM_iCacheWriteVar( uint16_t Fu16VirtAddr,
+                                        uint32_t Fu32Data );
+static uint8_t u8EEPROM_iCacheReadVar( uint16_t Fu16VirtAddr,
+                                       uint32_t * Fpu32Value );
+static uint8_t u8EEPROM_iCacheCommit( void );
+static uint8_t u8EEPROM_iCacheEmergencyFlush( uint32_t Fu32MaxPrograms );
+/**
+ * @}
+ */
+
+
+/**
+ * @brief Initialize the EEPROM (u8EEPROM_eInit) and empty the cache
+ * @return Status code indicating the result of the initialization
+ */
+uint8_t u8EEPROM_eCacheInit( void )
+{
+    vEEPROM_eCacheClear();
+
+    return u8EEPROM_eInit();
+}
+
+
+/**
+ * @brief Drop all the cached variables, dirty ones included
+ */
+void vEEPROM_eCacheClear( void )
+{
+    uint32_t u32Pos;
+
+    EEPROM_CACHE_LOCK();
+
+    for( u32Pos = 0U; u32Pos < EEPROM_CACHE_SIZE; u32Pos++ )
+    {
+        astEEPROM_iCache[ u32Pos ].u16VirtAddr = 0U;
+        astEEPROM_iCache[ u32Pos ].bDirty = FALSE;
+    }
+
+    u32DirtyCount = 0U;
+    u32EvictCursor = 0U;
+    bDirtyTimerStarted = FALSE;
+
+    EEPROM_CACHE_UNLOCK();
+}
+
+
+/**
+ * @brief Drop the cached value of a variable, dirty or not
+ * @param Fu16VirtAddr Virtual address of the variable
+ */
+void vEEPROM_eCacheInvalidate( uint16_t Fu16VirtAddr )
+{
+    Tst_EepromCacheEntry * pstEntry;
+
+    EEPROM_CACHE_LOCK();
+
+    pstEntry = ( bCacheWriting == FALSE ) ? pstEEPROM_iCacheFind( Fu16VirtAddr ) : NULL;
+
+    if( pstEntry != NULL )
+    {
+        if( pstEntry->bDirty == TRUE )
+        {
+            u32DirtyCount--;
+        }
+
+        pstEntry->u16VirtAddr = 0U;
+        pstEntry->bDirty = FALSE;
+    }
+
+    EEPROM_CACHE_UNLOCK();
+}
+
+
+/**
+ * @brief Write a variable through the cache
+ * @param Fu16VirtAddr Virtual address of the variable to write
+ * @param Fu32Data Data value to write
+ * @return Status code indicating the result of the write operation
+ */
+uint8_t u8EEPROM_eCacheWriteVar( uint16_t Fu16VirtAddr,
+                                 uint32_t Fu32Data )
+{
+    uint8_t u8FnRet;
+
+    EEPROM_CACHE_LOCK();
+    u8FnRet = u8EEPROM_iCacheWriteVar( Fu16VirtAddr, Fu32Data );
+    EEPROM_CACHE_UNLOCK();
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Read a variable through the cache
+ * @param Fu16VirtAddr Virtual address of the variable to read
+ * @param Fpu32Value Pointer to store the read value
+ * @return Status code indicating the result of the read operation
+ */
+uint8_t u8EEPROM_eCacheReadVar( uint16_t Fu16VirtAddr,
+                                uint32_t * Fpu32Value )
+{
+    uint8_t u8FnRet;
+
+    /*a read fills the cache*/
+    EEPROM_CACHE_LOCK();
+    u8FnRet = u8EEPROM_iCacheReadVar( Fu16VirtAddr, Fpu32Value );
+    EEPROM_CACHE_UNLOCK();
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Write all the dirty variables to the flash (one batch write)
+ * @return Status code indicating the result of the write operation
+ */
+uint8_t u8EEPROM_eCacheCommit( void )
+{
+    uint8_t u8FnRet;
+
+    EEPROM_CACHE_LOCK();
+    u8FnRet = u8EEPROM_iCacheCommit();
+    EEPROM_CACHE_UNLOCK();
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Commit the cache once the oldest unflushed write is EEPROM_CACHE_FLUSH_INTERVAL_MS old
+ * @note the age is counted from the first tick that saw the dirty variables, call it often enough
+ * @param Fu32NowMs Current time in ms (e.g. HAL_GetTick()), may wrap around
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eCacheTick( uint32_t Fu32NowMs )
+{
+    uint8_t u8FnRet = Du8EEPROM_eSUCCESS;
+
+    #if ( EEPROM_CACHE_FLUSH_INTERVAL_MS > 0U )
+        EEPROM_CACHE_LOCK();
+
+        if( u32DirtyCount == 0U )
+        {
+            bDirtyTimerStarted = FALSE;
+        }
+        else if( bDirtyTimerStarted == FALSE )
+        {
+            bDirtyTimerStarted = TRUE;
+            u32DirtySinceMs = Fu32NowMs;
+        }
+
+        if( ( bDirtyTimerStarted == TRUE ) && ( ( Fu32NowMs - u32DirtySinceMs ) >= EEPROM_CACHE_FLUSH_INTERVAL_MS ) )
+        {
+            u8FnRet = u8EEPROM_iCacheCommit();
+        }
+
+        EEPROM_CACHE_UNLOCK();
+    #else
+        ( void ) Fu32NowMs;
+    #endif
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Write dirty variables in bounded time (brown-out handler)
+ * @param Fu32MaxPrograms Maximum number of packet programs (energy left)
+ * @return Du8EEPROM_eSUCCESS if no dirty variable is left, Du8EEPROM_eBUSY if some are left,
+ *         error code otherwise
+ */
+uint8_t u8EEPROM_eCacheEmergencyFlush( uint32_t Fu32MaxPrograms )
+{
+    uint8_t u8FnRet;
+
+    EEPROM_CACHE_LOCK();
+    u8FnRet = u8EEPROM_iCacheEmergencyFlush( Fu32MaxPrograms );
+    EEPROM_CACHE_UNLOCK();
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Get the number of dirty variables in the cache
+ * @return Number of variables not written to the flash yet
+ */
+uint32_t u32EEPROM_eCacheDirtyCount( void )
+{
+    return u32DirtyCount;
+}
+
+
+/**
+ * @brief Write a variable through the cache, the cache is locked
+ * @param Fu16VirtAddr Virtual address of the variable to write
+ * @param Fu32Data Data value to write
+ * @return Status code indicating the result of the write operation
+ */
+static uint8_t u8EEPROM_iCacheWriteVar( uint16_t Fu16VirtAddr,
+                                        uint32_t Fu32Data )
+{
+    Tst_EepromCacheEntry * pstEntry;
+    uint32_t u32StoredValue;
+
+    /*forbidden adresses*/
+    if( FALSE == IS_VIRTUAL_ADDRESS_VALID( Fu16VirtAddr ) )
+    {
+        return Du8EEPROM_eWRITE_ERROR;
+    }
+
+    pstEntry = pstEEPROM_iCacheFind( Fu16VirtAddr );
+
+    if( pstEntry == NULL )
+    {
+        pstEntry = pstEEPROM_iCacheAlloc( TRUE );
+
+        if( pstEntry == NULL )
+        {
+            /*cache full of dirty variables that could not be flushed*/
+            return u8EEPROM_eWriteVar( Fu16VirtAddr, Fu32Data );
+        }
+
+        pstEntry->u16VirtAddr = Fu16VirtAddr;
+        pstEntry->bDirty = FALSE;
+        pstEntry->u32DataVal = Fu32Data;
+
+        if( ( Du8EEPROM_eSUCCESS == u8EEPROM_eReadVar( Fu16VirtAddr, &u32StoredValue ) ) && ( u32StoredValue == Fu32Data ) )
+        {
+            /*same value already in flash*/
+            return Du8EEPROM_eSUCCESS;
+        }
+    }
+    else if( pstEntry->u32DataVal == Fu32Data )
+    {
+        /*unchanged, or already waiting for the flush*/
+        return Du8EEPROM_eSUCCESS;
+    }
+
+    pstEntry->u32DataVal = Fu32Data;
+
+    if( pstEntry->bDirty == FALSE )
+    {
+        pstEntry->bDirty = TRUE;
+        u32DirtyCount++;
+    }
+
+    if( u32DirtyCount >= EEPROM_CACHE_FLUSH_THRESHOLD )
+    {
+        return u8EEPROM_iCacheCommit();
+    }
+
+    return Du8EEPROM_eSUCCESS;
+}
+
+
+/**
+ * @brief Read a variable through the cache, the cache is locked
+ * @param Fu16VirtAddr Virtual address of the variable to read
+ * @param Fpu32Value Pointer to store the read value
+ * @return Status code indicating the result of the read operation
+ */
+static uint8_t u8EEPROM_iCacheReadVar( uint16_t Fu16VirtAddr,
+                                       uint32_t * Fpu32Value )
+{
+    Tst_EepromCacheEntry * pstEntry;
+    uint8_t u8FnRet;
+
+    if( Fpu32Value == NULL )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    pstEntry = pstEEPROM_iCacheFind( Fu16VirtAddr );
+
+    if( pstEntry != NULL )
+    {
+        *Fpu32Value = pstEntry->u32DataVal;
+        return Du8EEPROM_eSUCCESS;
+    }
+
+    u8FnRet = u8EEPROM_eReadVar( Fu16VirtAddr, Fpu32Value );
+
+    if( u8FnRet == Du8EEPROM_eSUCCESS )
+    {
+        /*a read never flushes the cache to make room*/
+        pstEntry = pstEEPROM_iCacheAlloc( FALSE );
+
+        if( pstEntry != NULL )
+        {
+            pstEntry->u16VirtAddr = Fu16VirtAddr;
+            pstEntry->bDirty = FALSE;
+            pstEntry->u32DataVal = *Fpu32Value;
+        }
+    }
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Write all the dirty variables to the flash (one batch write), the cache is locked
+ * @return Status code indicating the result of the write operation
+ */
+static uint8_t u8EEPROM_iCacheCommit( void )
+{
+    Tst_EppromPacket astBatch[ EEPROM_CACHE_SIZE ];
+    uint32_t u32NbVars = 0U;
+    uint32_t u32Pos;
+    uint8_t u8FnRet;
+
+    if( u32DirtyCount == 0U )
+    {
+        return Du8EEPROM_eSUCCESS;
+    }
+
+    for( u32Pos = 0U; u32Pos < EEPROM_CACHE_SIZE; u32Pos++ )
+    {
+        if( astEEPROM_iCache[ u32Pos ].bDirty == TRUE )
+        {
+            astBatch[ u32NbVars ].u16VirtAddr = astEEPROM_iCache[ u32Pos ].u16VirtAddr;
+            astBatch[ u32NbVars ].u16CRC = 0U;
+            astBatch[ u32NbVars ].u32DataVal = astEEPROM_iCache[ u32Pos ].u32DataVal;
+            u32NbVars++;
+        }
+    }
+
+    bCacheWriting = TRUE;
+    u8FnRet = u8EEPROM_eWriteVars( astBatch, u32NbVars );
+    bCacheWriting = FALSE;
+
+    if( u8FnRet != Du8EEPROM_eSUCCESS )
+    {
+        /*dirty flags are kept, the next commit writes them again*/
+        return u8FnRet;
+    }
+
+    for( u32Pos = 0U; u32Pos < EEPROM_CACHE_SIZE; u32Pos++ )
+    {
+        astEEPROM_iCache[ u32Pos ].bDirty = FALSE;
+    }
+
+    u32DirtyCount = 0U;
+    bDirtyTimerStarted = FALSE;
+
+    return Du8EEPROM_eSUCCESS;
+}
+
+
+/**
+ * @brief Write dirty variables in bounded time, the cache is locked
+ * @param Fu32MaxPrograms Maximum number of packet programs (energy left)
+ * @return Du8EEPROM_eSUCCESS if no dirty variable is left, Du8EEPROM_eBUSY if some are left,
+ *         error code otherwise
+ */
+static uint8_t u8EEPROM_iCacheEmergencyFlush( uint32_t Fu32MaxPrograms )
+{
+    uint32_t u32Budget = u32EEPROM_eGetWriteBudget();
+    uint32_t u32Pos;
+    uint8_t u8FnRet = Du8EEPROM_eSUCCESS;
+
+    /*a write frees the older copy of its variable as well unless EEPROM_LAZY_FREE_ENABLE*/
+    if( ( Fu32MaxPrograms / EEPROM_WRITE_PROGRAMS ) < u32Budget )
+    {
+        u32Budget = Fu32MaxPrograms / EEPROM_WRITE_PROGRAMS;
+    }
+
+    bCacheWriting = TRUE;
+
+    for( u32Pos = 0U; ( u32Pos < EEPROM_CACHE_SIZE ) && ( u32Budget > 0U ) && ( u32DirtyCount > 0U ) &&
+         ( u8FnRet == Du8EEPROM_eSUCCESS ); u32Pos++ )
+    {
+        if( astEEPROM_iCache[ u32Pos ].bDirty == TRUE )
+        {
+            u8FnRet = u8EEPROM_eWriteVar( astEEPROM_iCache[ u32Pos ].u16VirtAddr, astEEPROM_iCache[ u32Pos ].u32DataVal );
+
+            if( u8FnRet == Du8EEPROM_eSUCCESS )
+            {
+                astEEPROM_iCache[ u32Pos ].bDirty = FALSE;
+                u32DirtyCount--;
+                u32Budget--;
+            }
+        }
+    }
+
+    bCacheWriting = FALSE;
+
+    if( u8FnRet != Du8EEPROM_eSUCCESS )
+    {
+        return u8FnRet;
+    }
+
+    return( ( u32DirtyCount == 0U ) ? Du8EEPROM_eSUCCESS : Du8EEPROM_eBUSY );
+}
+
+
+/**
+ * @brief Find the cache entry of a variable
+ * @param Fu16VirtAddr Virtual address of the variable
+ * @return Pointer to the entry, NULL if the variable is not cached
+ */
+static Tst_EepromCacheEntry * pstEEPROM_iCacheFind( uint16_t Fu16VirtAddr )
+{
+    uint32_t u32Pos;
+
+    for( u32Pos = 0U; u32Pos < EEPROM_CACHE_SIZE; u32Pos++ )
+    {
+        if( astEEPROM_iCache[ u32Pos ].u16VirtAddr == Fu16VirtAddr )
+        {
+            return &astEEPROM_iCache[ u32Pos ];
+        }
+    }
+
+    return NULL;
+}
+
+
+/**
+ * @brief Get a cache entry for a new variable: an unused one, else a clean one (round robin)
+ * @param FbAllowCommit TRUE to commit the cache when all the entries are dirty
+ * @return Pointer to the entry, NULL if none could be freed
+ */
+static Tst_EepromCacheEntry * pstEEPROM_iCacheAlloc( BOOL FbAllowCommit )
+{
+    uint32_t u32Pos;
+
+    for( u32Pos = 0U; u32Pos < EEPROM_CACHE_SIZE; u32Pos++ )
+    {
+        if( astEEPROM_iCache[ u32Pos ].u16VirtAddr == 0U )
+        {
+            return &astEEPROM_iCache[ u32Pos ];
+        }
+    }
+
+    if( u32DirtyCount == EEPROM_CACHE_SIZE )
+    {
+        if( ( FbAllowCommit == FALSE ) || ( Du8EEPROM_eSUCCESS != u8EEPROM_iCacheCommit() ) )
+        {
+            return NULL;
+        }
+    }
+
+    for( u32Pos = 0U; u32Pos < EEPROM_CACHE_SIZE; u32Pos++ )
+    {
+        u32EvictCursor = ( u32EvictCursor + 1U ) % EEPROM_CACHE_SIZE;
+
+        if( astEEPROM_iCache[ u32EvictCursor ].bDirty == FALSE )
+        {
+            return &astEEPROM_iCache[ u32EvictCursor ];
+        }
+    }
+
+    return NULL;
+}
+
+#endif /* EEPROM_CACHE_ENABLE */
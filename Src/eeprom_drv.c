@@ -6,16 +6,80 @@
 
 #include "eeprom_mcu_itf.h"
 #include "eeprom_drv.h"
+#include "eeprom_crc.h"
+#include "eeprom_cache.h"
 
 
 
 
-static uint8_t u8ActivePage = 0xFF;
-static uint32_t u32NextWriteAddress = NO_EMPTY_WRITE_SPACE_FOUND;
-#if EEPROM_DEBUG_MODE
-    static uint32_t u32EraseCounter = 0U;
+/*flash operations of the MCU (eeprom_mcu_itf.c)*/
+const Tst_EepromFlashItf stEEPROM_eMcuFlash =
+{
+    u8FLASH_ITF_eFlashSectorEraseStart,
+    u8FLASH_ITF_eFlashEraseStatus,
+    vFLASH_ITF_eEraseWaitHook,
+    u8FLASH_ITF_FlashProgram,
+    u8FLASH_ITF_eFlashProgramBurst,
+    vFLASH_ITF_eSessionBegin,
+    vFLASH_ITF_eSessionEnd,
+    vFLASH_ITF_eMutexTake,
+    vFLASH_ITF_eMutexGive,
+};
+
+/*instance of the single instance APIs (u8EEPROM_eInit, u8EEPROM_eWriteVar...)*/
+static Tst_EepromInstance stEEPROM_iDefault = EEPROM_INSTANCE_INIT( FLASH_EEPROM_START_ADDR, EEPROM_PAGE_SIZE,
+                                                                    MCU_PAGE_0_FLASH_SECTOR, &stEEPROM_eMcuFlash );
+
+#if EEPROM_STATS_ENABLE
+    #define EEPROM_STATS_ADD( INST, FIELD, N )       ( ( INST )->stStats.FIELD += ( uint32_t ) ( N ) )
+    #define EEPROM_STATS_COUNT( VAR )                ( ( VAR )++ )
+    #define EEPROM_STATS_SCAN( INST, FIELD, MAX, N ) vEEPROM_iStatsScan( &( INST )->stStats.FIELD, &( INST )->stStats.MAX, ( N ) )
+    #define EEPROM_STATS_WRITE_BEGIN()               uint32_t u32StatsWriteStart = u32FLASH_ITF_eGetTimestamp()
+    #define EEPROM_STATS_WRITE_END( INST )           vEEPROM_iStatsWriteDone( ( INST ), u32StatsWriteStart )
+#else
+    #define EEPROM_STATS_ADD( INST, FIELD, N )
+    #define EEPROM_STATS_COUNT( VAR )
+    #define EEPROM_STATS_SCAN( INST, FIELD, MAX, N )
+    #define EEPROM_STATS_WRITE_BEGIN()
+    #define EEPROM_STATS_WRITE_END( INST )
+#endif
+#if EEPROM_THREAD_SAFE_ENABLE
+    #define EEPROM_WRITER_LOCK( INST )               ( INST )->pstFlash->pfMutexTake()
+    #define EEPROM_WRITER_UNLOCK( INST )             ( INST )->pstFlash->pfMutexGive()
+    #define EEPROM_UPDATE_BEGIN( INST )              vEEPROM_iUpdateBegin( INST )
+    #define EEPROM_UPDATE_END( INST )                vEEPROM_iUpdateEnd( INST )
+#else
+    #define EEPROM_WRITER_LOCK( INST )
+    #define EEPROM_WRITER_UNLOCK( INST )
+    #define EEPROM_UPDATE_BEGIN( INST )
+    #define EEPROM_UPDATE_END( INST )
 #endif
-static BOOL bEEPROM_iInitDone = FALSE;
+/*a direct write of the default instance is newer than the value the write-back cache holds (eeprom_cache.c)*/
+#if EEPROM_CACHE_ENABLE
+    #define EEPROM_CACHE_INVALIDATE( VIRT_ADDR )     vEEPROM_eCacheInvalidate( VIRT_ADDR )
+    #define EEPROM_CACHE_CLEAR()                     vEEPROM_eCacheClear()
+#else
+    #define EEPROM_CACHE_INVALIDATE( VIRT_ADDR )
+    #define EEPROM_CACHE_CLEAR()
+#endif
+
+/*array filled by u8EEPROM_iReadAllVar*/
+typedef struct
+{
+    Tst_EppromPacket * pstArr;
+    uint32_t u32MaxSize;
+    uint32_t u32Size;
+    BOOL bOverflow;                        /*a variable did not fit*/
+} Tst_EepromArrayFill;
+
+/*table filled by u8EEPROM_iReadSnapshot, entry n is the variable u16FirstVirtAddr + n*/
+typedef struct
+{
+    Tst_EppromPacket * pstTable;
+    uint16_t u16FirstVirtAddr;
+    uint32_t u32NbVars;
+    uint32_t u32NbStored;
+} Tst_EepromSnapshotFill;
 
 
 
@@ -26,27 +90,188 @@ static BOOL bEEPROM_iInitDone = FALSE;
  * @{
  */
 
-static uint8_t u8EEPROM_iGetPageStatus( uint8_t Fu8PageId,
+static BOOL bEEPROM_iIsGeometryValid( const Tst_EepromInstance * FpstInst );
+static void vEEPROM_iSetState( Tst_EepromInstance * FpstInst );
+static uint8_t u8EEPROM_iInit( Tst_EepromInstance * FpstInst );
+static uint8_t u8EEPROM_iFormat( Tst_EepromInstance * FpstInst );
+static uint8_t u8EEPROM_iWriteVar( Tst_EepromInstance * FpstInst,
+                                   uint16_t Fu16VirtAddr,
+                                   uint32_t Fu32Data );
+static uint8_t u8EEPROM_iWriteVars( Tst_EepromInstance * FpstInst,
+                                    const Tst_EppromPacket * Fpst,
+                                    uint32_t Fu32NbVars );
+static uint8_t u8EEPROM_iWriteRecord( Tst_EepromInstance * FpstInst,
+                                      uint16_t Fu16VirtAddr,
+                                      const uint8_t * Fpu8Data,
+                                      uint16_t Fu16Size );
+#if EEPROM_COUNTER_ENABLE
+static uint8_t u8EEPROM_iIncrementCounter( Tst_EepromInstance * FpstInst,
+                                           uint16_t Fu16VirtAddr,
+                                           uint32_t * Fpu32Value );
+#endif
+static uint8_t u8EEPROM_iReadVar( Tst_EepromInstance * FpstInst,
+                                  uint16_t Fu16VirtAddr,
+                                  uint32_t * Fpu32Value );
+static uint8_t u8EEPROM_iReadRecord( Tst_EepromInstance * FpstInst,
+                                     uint16_t Fu16VirtAddr,
+                                     uint8_t * Fpu8Data,
+                                     uint16_t Fu16MaxSize,
+                                     uint16_t * Fpu16Size );
+static uint8_t u8EEPROM_iReadAllVar( Tst_EepromInstance * FpstInst,
+                                     Tst_EppromPacket * Fu64arr,
+                                     uint32_t u32MaArrSize,
+                                     uint32_t * Fu32Size );
+static uint8_t u8EEPROM_iForEachVar( Tst_EepromInstance * FpstInst,
+                                     Tpf_EepromVarVisitor FpfVisit,
+                                     void * FpvContext );
+static uint8_t u8EEPROM_iReadSnapshot( Tst_EepromInstance * FpstInst,
+                                       uint16_t Fu16FirstVirtAddr,
+                                       Tst_EppromPacket * Fpst,
+                                       uint32_t Fu32NbVars,
+                                       uint32_t * Fpu32NbStored );
+static BOOL bEEPROM_iArrayFillVisit( uint16_t Fu16VirtAddr,
+                                     uint32_t Fu32Data,
+                                     void * FpvContext );
+static BOOL bEEPROM_iSnapshotVisit( uint16_t Fu16VirtAddr,
+                                    uint32_t Fu32Data,
+                                    void * FpvContext );
+static uint8_t u8EEPROM_iExportImage( Tst_EepromInstance * FpstInst,
+                                      uint8_t * Fpu8Image,
+                                      uint32_t Fu32MaxSize,
+                                      uint32_t * Fpu32Size );
+static uint8_t u8EEPROM_iImportImage( Tst_EepromInstance * FpstInst,
+                                      const uint8_t * Fpu8Image,
+                                      uint32_t Fu32Size );
+static BOOL bEEPROM_iIsPageBlank( Tst_EepromInstance * FpstInst,
+                                  uint8_t Fu8PageId );
+static void vEEPROM_iImagePut( uint8_t * Fpu8Dest,
+                               uint64_t Fu64Value,
+                               uint32_t Fu32NbBytes );
+static uint64_t u64EEPROM_iImageGet( const uint8_t * Fpu8Src,
+                                     uint32_t Fu32NbBytes );
+static uint16_t u16EEPROM_iImageChecksum( const uint8_t * Fpu8Image,
+                                          uint32_t Fu32NbPackets );
+static uint8_t u8EEPROM_iGetPageStatus( Tst_EepromInstance * FpstInst,
+                                        uint8_t Fu8PageId,
                                         uint32_t * Fpu32RetStatus );
-static uint8_t u8EEPROM_iSetPageStatus( uint8_t Fu8PageId,
+static uint8_t u8EEPROM_iSetPageStatus( Tst_EepromInstance * FpstInst,
+                                        uint8_t Fu8PageId,
                                         uint32_t Fu32NewPageStatus );
-static uint8_t u8EEPROM_iErasePage( uint8_t Fu8Page );
-static uint8_t u8EEPROM_iWrite( uint32_t Fu32Address,
+static uint8_t u8EEPROM_iErasePage( Tst_EepromInstance * FpstInst,
+                                    uint8_t Fu8Page );
+static uint8_t u8EEPROM_iEraseStart( Tst_EepromInstance * FpstInst,
+                                     uint8_t Fu8Page );
+static uint8_t u8EEPROM_iEraseComplete( Tst_EepromInstance * FpstInst,
+                                        BOOL FbWait );
+static void vEEPROM_iWaitFlashIdle( Tst_EepromInstance * FpstInst );
+static uint8_t u8EEPROM_iWrite( Tst_EepromInstance * FpstInst,
+                                uint32_t Fu32Address,
                                 uint64_t Fu64Data,
                                 uint8_t fu8WriteSizeBytes );
-static uint8_t u8EEPROM_freeVar( uint64_t Fu16VirtAddr,
+static uint8_t u8EEPROM_iWriteBurst( Tst_EepromInstance * FpstInst,
+                                     uint32_t Fu32Address,
+                                     const uint64_t * Fpu64Packets,
+                                     uint32_t Fu32NbPackets );
+static uint8_t u8EEPROM_iFlushTransferBurst( Tst_EepromInstance * FpstInst,
+                                             const uint64_t * Fpu64Packets,
+                                             uint32_t * Fpu32NbPackets );
+#if ( EEPROM_LAZY_FREE_ENABLE == 0U )
+static uint8_t u8EEPROM_freeVar( Tst_EepromInstance * FpstInst,
+                                 uint64_t Fu16VirtAddr,
                                  uint32_t Fu32StartSearchAddr );
+#endif
+static BOOL bEEPROM_iIsNewestCopy( Tst_EepromInstance * FpstInst,
+                                   uint32_t Fu32PacketAddress );
+static uint32_t u32EEPROM_iPrevPacketAddress( Tst_EepromInstance * FpstInst,
+                                              uint32_t Fu32PacketAddress );
+static uint32_t u32EEPROM_iNextPacketAddress( Tst_EepromInstance * FpstInst,
+                                              uint32_t Fu32PacketAddress );
+static uint32_t u32EEPROM_iLastPacketAddress( Tst_EepromInstance * FpstInst );
 static uint16_t u16EEPROM_iCalculateCRC( uint16_t Fu16VirtAddr,
                                          uint32_t Fu32Data );
 static uint32_t u32EEPROM_iRead( uint32_t Fu32Address );
-static BOOL bEEPROM_isPageErased( const uint8_t Fu8PageId );
-static uint8_t u8EEPROM_iPageTransfer( uint8_t Fu8PageIdSource,
+static BOOL bEEPROM_iIsRecordHead( uint64_t Fu64Packet );
+static BOOL bEEPROM_iIsPacketValid( uint64_t Fu64Packet );
+static uint32_t u32EEPROM_iPacketSlots( uint64_t Fu64Packet );
+static uint32_t u32EEPROM_iCounterTally( Tst_EepromInstance * FpstInst,
+                                         uint32_t Fu32PacketAddress );
+static uint32_t u32EEPROM_iTallyCount( uint32_t Fu32Tally );
+static uint32_t u32EEPROM_iVarValue( Tst_EepromInstance * FpstInst,
+                                     uint32_t Fu32PacketAddress );
+static uint64_t u64EEPROM_iMakePacket( uint16_t Fu16VirtAddr,
+                                       uint32_t Fu32Data );
+static uint16_t u16EEPROM_iSlotCRC( uint16_t Fu16CRC,
+                                    uint64_t Fu64Slot );
+static BOOL bEEPROM_iIsRecordValid( Tst_EepromInstance * FpstInst,
+                                    uint32_t Fu32HeadAddress );
+static uint32_t u32EEPROM_iFindVar( Tst_EepromInstance * FpstInst,
+                                    uint16_t Fu16VirtAddr );
+static uint8_t u8EEPROM_iReserve( Tst_EepromInstance * FpstInst,
+                                  uint32_t Fu32NbPackets );
+static BOOL bEEPROM_isPageErased( Tst_EepromInstance * FpstInst,
+                                  const uint8_t Fu8PageId );
+static uint8_t u8EEPROM_iPreparePage( Tst_EepromInstance * FpstInst,
+                                      uint8_t Fu8PageId );
+static uint8_t u8EEPROM_iOpenNextPage( Tst_EepromInstance * FpstInst );
+static uint8_t u8EEPROM_iPageTransfer( Tst_EepromInstance * FpstInst,
+                                       uint8_t Fu8PageIdSource,
                                        uint8_t Fu8PageIdDestination );
-static uint8_t u8EEPROM_iRestarPagetTransfer( uint8_t Fu8PageIdSource,
-                                              uint8_t Fu8PageIdDestination );
-static EEpromHeaderTypedef eEEPROM_GetHeader( uint8_t eeprom_Page );
-static uint32_t u32EEPROM_iFindNextWriteAddress( uint8_t u8pageId,
-                                                 uint32_t * Fpu32NextWriteAddress );
+static uint8_t u8EEPROM_iRestarPagetTransfer( Tst_EepromInstance * FpstInst );
+static uint8_t u8EEPROM_iTransferStep( Tst_EepromInstance * FpstInst,
+                                       uint32_t Fu32MaxPackets );
+static uint8_t u8EEPROM_iTransferRun( Tst_EepromInstance * FpstInst,
+                                      uint32_t Fu32MaxPackets );
+static void vEEPROM_iTransferMarkLive( Tst_EepromInstance * FpstInst );
+static BOOL bEEPROM_iIsTransferMarked( Tst_EepromInstance * FpstInst,
+                                       uint32_t Fu32PacketAddress );
+static BOOL bEEPROM_iIsTransferLive( Tst_EepromInstance * FpstInst,
+                                     uint32_t Fu32PacketAddress );
+static BOOL bEEPROM_iRelocate( Tst_EepromInstance * FpstInst,
+                               uint64_t Fu64Packet );
+static void vEEPROM_iFreeOlderCopies( Tst_EepromInstance * FpstInst,
+                                      uint32_t Fu32PacketAddress );
+static uint32_t u32EEPROM_iFreePackets( Tst_EepromInstance * FpstInst );
+static uint8_t u8EEPROM_iProgramVar( Tst_EepromInstance * FpstInst,
+                                     uint16_t Fu16VirtAddr,
+                                     uint32_t Fu32Data );
+static void vEEPROM_iCheckPageSwitch( Tst_EepromInstance * FpstInst );
+static BOOL bEEPROM_iIsLastInBatch( const Tst_EppromPacket * Fpst,
+                                    uint32_t Fu32NbVars,
+                                    uint32_t Fu32Index );
+static EEpromHeaderTypedef eEEPROM_GetHeader( Tst_EepromInstance * FpstInst,
+                                              uint8_t eeprom_Page );
+static uint32_t u32EEPROM_iFindNextWriteAddress( Tst_EepromInstance * FpstInst,
+                                                 uint8_t Fu8PageId );
+static uint8_t u8EEPROM_iMountPages( Tst_EepromInstance * FpstInst,
+                                     uint8_t Fu8OldestPage,
+                                     uint8_t Fu8ActivePage );
+static uint8_t u8EEPROM_iScanPages( Tst_EepromInstance * FpstInst,
+                                    BOOL FbMount );
+static void vEEPROM_iFreeTornPacket( Tst_EepromInstance * FpstInst );
+#if EEPROM_RAM_INDEX_ENABLE
+static void vEEPROM_iIndexClear( Tst_EepromInstance * FpstInst );
+static void vEEPROM_iIndexUpdate( Tst_EepromInstance * FpstInst,
+                                  uint16_t Fu16VirtAddr,
+                                  uint32_t Fu32PacketAddress );
+static void vEEPROM_iIndexDropPage( Tst_EepromInstance * FpstInst,
+                                    uint8_t Fu8PageId );
+static uint32_t u32EEPROM_iIndexLookup( Tst_EepromInstance * FpstInst,
+                                        uint16_t Fu16VirtAddr );
+#endif
+#if EEPROM_THREAD_SAFE_ENABLE
+static void vEEPROM_iUpdateBegin( Tst_EepromInstance * FpstInst );
+static void vEEPROM_iUpdateEnd( Tst_EepromInstance * FpstInst );
+static uint32_t u32EEPROM_iReadBegin( Tst_EepromInstance * FpstInst );
+static BOOL bEEPROM_iReadRetry( Tst_EepromInstance * FpstInst,
+                                uint32_t Fu32Sequence );
+#endif
+#if EEPROM_STATS_ENABLE
+static void vEEPROM_iStatsScan( uint32_t * Fpu32Total,
+                                uint32_t * Fpu32Max,
+                                uint32_t Fu32NbScanned );
+static void vEEPROM_iStatsWriteDone( Tst_EepromInstance * FpstInst,
+                                     uint32_t Fu32StartTime );
+#endif
 /**
  * @}
  */
@@ -57,21 +282,64 @@ static uint32_t u32EEPROM_iFindNextWriteAddress( uint8_t u8pageId,
 #endif
 
 /**
- * @brief Format the EEPROM by erasing both pages and setting the active page
+ * @brief Format an instance by erasing all pages and setting the active page
+ * @param FpstInst Instance
  * @return Status code indicating the result of the formatting operation
  */
-uint8_t u8EEPROM_eFormat( void )
+uint8_t u8EEPROM_eInstFormat( Tst_EepromInstance * FpstInst )
+{
+    uint8_t u8FnRet;
+
+    if( FALSE == bEEPROM_iIsGeometryValid( FpstInst ) )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    EEPROM_WRITER_LOCK( FpstInst );
+    vEEPROM_iSetState( FpstInst );
+    EEPROM_UPDATE_BEGIN( FpstInst );
+    u8FnRet = u8EEPROM_iFormat( FpstInst );
+    EEPROM_UPDATE_END( FpstInst );
+    EEPROM_WRITER_UNLOCK( FpstInst );
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Erase all pages and set the active page
+ * @param FpstInst Instance
+ * @return Status code indicating the result of the formatting operation
+ */
+static uint8_t u8EEPROM_iFormat( Tst_EepromInstance * FpstInst )
 {
     uint8_t u8FnRet = Du8EEPROM_eSUCCESS;
+    uint8_t u8PageId;
+
+    FpstInst->pstFlash->pfSessionBegin();
+
+    for( u8PageId = 0U; u8PageId < NB_EEPROM_PAGES; u8PageId++ )
+    {
+        u8FnRet |= u8EEPROM_iErasePage( FpstInst, u8PageId );
+    }
+
+    u8FnRet |= u8EEPROM_iSetPageStatus( FpstInst, PAGE_0, PAGE_STATUS_ACTIVE );
+
+    for( u8PageId = PAGE_1; u8PageId < NB_EEPROM_PAGES; u8PageId++ )
+    {
+        u8FnRet |= u8EEPROM_iSetPageStatus( FpstInst, u8PageId, PAGE_STATUS_ERASED );
+    }
 
-    u8FnRet = u8EEPROM_iErasePage( PAGE_0 );
-    u8FnRet |= u8EEPROM_iErasePage( PAGE_1 );
+    FpstInst->pstFlash->pfSessionEnd();
 
-    u8FnRet |= u8EEPROM_iSetPageStatus( PAGE_0, PAGE_STATUS_ACTIVE );
-    u8FnRet |= u8EEPROM_iSetPageStatus( PAGE_1, PAGE_STATUS_ERASED );
+    FpstInst->u8ActivePage = PAGE_0;
+    FpstInst->u8OldestPage = PAGE_0;
+    FpstInst->u32NextWriteAddress = PAGE_HEADER_ADDRESS( FpstInst, PAGE_0 ) + PAGE_HEADER_SIZE;
+    FpstInst->eTransferState = EEPROM_TRANSFER_IDLE;
 
-    u8ActivePage = PAGE_0;
-    u32NextWriteAddress = PAGE_HEADER_ADDRESS( PAGE_0 ) + PAGE_HEADER_SIZE;
+    #if EEPROM_RAM_INDEX_ENABLE
+        vEEPROM_iIndexClear( FpstInst );
+    #endif
 
     if( u8FnRet != Du8EEPROM_eSUCCESS )
     {
@@ -84,11 +352,13 @@ uint8_t u8EEPROM_eFormat( void )
 
 /**
  * @brief Set the status of a page in the EEPROM
+ * @param FpstInst Instance
  * @param Fu8PageId: Page ID of the EEPROM page
  * @param Fu32NewPageStatus: New status to be set for the page
  * @return Status code indicating the result of the operation
  */
-static uint8_t u8EEPROM_iSetPageStatus( uint8_t Fu8PageId,
+static uint8_t u8EEPROM_iSetPageStatus( Tst_EepromInstance * FpstInst,
+                                        uint8_t Fu8PageId,
                                         uint32_t Fu32NewPageStatus )
 {
     if( ( Fu8PageId > MAX_PAGE_ID ) ||
@@ -101,14 +371,19 @@ static uint8_t u8EEPROM_iSetPageStatus( uint8_t Fu8PageId,
 
     uint32_t u32CurrentPageStatus;
 
-    if( Du8EEPROM_eSUCCESS != u8EEPROM_iGetPageStatus( Fu8PageId, &u32CurrentPageStatus ) )
+    if( Du8EEPROM_eSUCCESS != u8EEPROM_iGetPageStatus( FpstInst, Fu8PageId, &u32CurrentPageStatus ) )
     {
         return Du8EEPROM_eERROR;
     }
 
+    if( u32CurrentPageStatus == Fu32NewPageStatus )
+    {
+        return Du8EEPROM_eSUCCESS; /*no program: a written unit of an ECC flash only takes all zeros*/
+    }
+
     if( ( u32CurrentPageStatus & Fu32NewPageStatus ) == Fu32NewPageStatus ) /*check that transition is possible (1 -> 0 ) (firas)*/
     {
-        return u8EEPROM_iWrite( PAGE_HEADER_ADDRESS( Fu8PageId ), Fu32NewPageStatus, 4 );
+        return u8EEPROM_iWrite( FpstInst, PAGE_HEADER_ADDRESS( FpstInst, Fu8PageId ), Fu32NewPageStatus, PAGE_STATUS_SIZE );
     }
     else
     {
@@ -118,11 +393,13 @@ static uint8_t u8EEPROM_iSetPageStatus( uint8_t Fu8PageId,
 
 /**
  * @brief Get the status of a page in the EEPROM
+ * @param FpstInst Instance
  * @param Fu8PageId: Page ID of the EEPROM page
  * @param Fpu32RetStatus: Pointer to store the retrieved status
  * @return Status code indicating the result of the operation
  */
-static uint8_t u8EEPROM_iGetPageStatus( uint8_t Fu8PageId,
+static uint8_t u8EEPROM_iGetPageStatus( Tst_EepromInstance * FpstInst,
+                                        uint8_t Fu8PageId,
                                         uint32_t * Fpu32RetStatus )
 {
     uint32_t u32PageHeaderAddress;
@@ -132,7 +409,7 @@ static uint8_t u8EEPROM_iGetPageStatus( uint8_t Fu8PageId,
         return Du8EEPROM_eBAD_PARAM;
     }
 
-    u32PageHeaderAddress = PAGE_HEADER_ADDRESS( Fu8PageId );
+    u32PageHeaderAddress = PAGE_HEADER_ADDRESS( FpstInst, Fu8PageId );
     *Fpu32RetStatus = *( ( uint32_t * ) u32PageHeaderAddress );
 
     return Du8EEPROM_eSUCCESS;
@@ -142,28 +419,52 @@ static uint8_t u8EEPROM_iGetPageStatus( uint8_t Fu8PageId,
 
 /**
  * @brief Erase a page in the EEPROM
+ * @param FpstInst Instance
  * @param Fu8Page: Page ID of the EEPROM page to be erased
  * @return Du8EEPROM_eSUCCESS if the page is erased,Du8EEPROM_eBAD_PARAM if the page is erased, FALSE otherwise
  */
-uint8_t u8EEPROM_iErasePage( uint8_t Fu8Page )
+uint8_t u8EEPROM_iErasePage( Tst_EepromInstance * FpstInst,
+                             uint8_t Fu8Page )
 {
-    uint32_t u32PageEraseCount = 0U;
+    uint8_t u8FnRet = u8EEPROM_iEraseStart( FpstInst, Fu8Page );
+
+    if( u8FnRet != Du8EEPROM_eSUCCESS )
+    {
+        return u8FnRet;
+    }
+
+    return u8EEPROM_iEraseComplete( FpstInst, TRUE );
+}
 
 
+/**
+ * @brief Start the erase of a page in background
+ * @note the page must not be read or written until u8EEPROM_iEraseComplete reports the end of the erase
+ * @param FpstInst Instance
+ * @param Fu8Page: Page ID of the EEPROM page to be erased
+ * @return Status code indicating the result of the operation
+ */
+static uint8_t u8EEPROM_iEraseStart( Tst_EepromInstance * FpstInst,
+                                     uint8_t Fu8Page )
+{
+    uint32_t u32PageEraseCount = 0U;
 
     if( Fu8Page > MAX_PAGE_ID )
     {
         return Du8EEPROM_eBAD_PARAM;
     }
 
+    /*one erase at a time*/
+    vEEPROM_iWaitFlashIdle( FpstInst );
+
     /*NOTE: ErasePage automatically sets page state to ERASED(0xffffffff) (fismail)*/
 
     #if EEPROM_DEBUG_MODE
-        u32EraseCounter++;
+        FpstInst->u32EraseCounter++;
     #endif
 
 
-    ( void ) u8EEPROM_iGetEraseCount( Fu8Page, &u32PageEraseCount );
+    ( void ) u8EEPROM_eInstGetEraseCount( FpstInst, Fu8Page, &u32PageEraseCount );
 
     if( 0xFFFFFFFFU == u32PageEraseCount )
     {
@@ -171,802 +472,3882 @@ uint8_t u8EEPROM_iErasePage( uint8_t Fu8Page )
     }
 
     /*Erase Dedicated Sector*/
-    if( u8FLASH_ITF_eFlashSectorErase( Fu8Page ) != 0 )
+    if( FpstInst->pstFlash->pfSectorEraseStart( FpstInst->u8FirstSector + Fu8Page ) != 0 )
     {
         return Du8EEPROM_eERASE_ERROR;
     }
 
-    /*write erase count*/
-    ( void ) u8EEPROM_iWrite( ( PAGE_HEADER_ADDRESS( Fu8Page ) + PAGE_STATUS_SIZE ), u32PageEraseCount + 1U, 4U );
-
+    EEPROM_STATS_ADD( FpstInst, u32Erases, 1U );
 
+    FpstInst->u8ErasingPage = Fu8Page;
+    FpstInst->u32ErasingPageCount = u32PageEraseCount + 1U;
 
     return Du8EEPROM_eSUCCESS;
 }
 
 
-
 /**
- * @brief Get the erase count of a specific EEPROM page
- * @param Fu8PageId ID of the EEPROM page
- * @param Fpu32EraseCount Pointer to store the erase count
- * @return Status code indicating the result of the operation
+ * @brief End the background erase: check its status and write the erase count of the page
+ * @param FpstInst Instance
+ * @param FbWait TRUE to wait for the end of the erase, FALSE to return Du8EEPROM_eBUSY while it runs
+ * @return Status code indicating the result of the erase, Du8EEPROM_eSUCCESS if no erase is running
  */
-uint8_t u8EEPROM_iGetEraseCount( uint8_t Fu8PageId,
-                                 uint32_t * Fpu32EraseCount )
+static uint8_t u8EEPROM_iEraseComplete( Tst_EepromInstance * FpstInst,
+                                        BOOL FbWait )
 {
-    if( Fpu32EraseCount == NULL )
+    uint8_t u8PageId = FpstInst->u8ErasingPage;
+    uint8_t u8EraseStatus;
+
+    if( u8PageId == 0xFFU )
     {
-        return Du8EEPROM_eBAD_PARAM;
+        return Du8EEPROM_eSUCCESS;
     }
 
-    uint32_t u32PageEeraseCountAddress = PAGE_HEADER_ADDRESS( Fu8PageId ) + PAGE_STATUS_SIZE;
+    u8EraseStatus = FpstInst->pstFlash->pfEraseStatus();
 
-    *( Fpu32EraseCount ) = *( ( uint32_t * ) u32PageEeraseCountAddress );
+    while( u8EraseStatus == FLASH_ITF_ERASE_BUSY )
+    {
+        if( FbWait == FALSE )
+        {
+            return Du8EEPROM_eBUSY;
+        }
+
+        FpstInst->pstFlash->pfEraseWaitHook();
+        u8EraseStatus = FpstInst->pstFlash->pfEraseStatus();
+    }
+
+    FpstInst->u8ErasingPage = 0xFFU; /*before the write below, which waits for the running erase*/
+
+    if( u8EraseStatus != FLASH_ITF_ERASE_DONE )
+    {
+        return Du8EEPROM_eERASE_ERROR;
+    }
+
+    /*write erase count*/
+    ( void ) u8EEPROM_iWrite( FpstInst, ( PAGE_HEADER_ADDRESS( FpstInst, u8PageId ) + PAGE_STATUS_SIZE ), FpstInst->u32ErasingPageCount, PAGE_ERASE_COUNT_SIZE );
 
     return Du8EEPROM_eSUCCESS;
 }
 
 
 /**
- * @brief Get the header of an EEPROM page
- * @param eeprom_Page: Page ID of the EEPROM page
- * @return Header information of the EEPROM page
+ * @brief Wait for the end of the background erase of the instance (its erase count is written)
+ *        and for an erase started by another instance on the same flash
+ * @param FpstInst Instance
  */
-EEpromHeaderTypedef eEEPROM_GetHeader( uint8_t eeprom_Page )
+static void vEEPROM_iWaitFlashIdle( Tst_EepromInstance * FpstInst )
 {
-    uint32_t u32HeaderX;
-
-    u32HeaderX = u32EEPROM_iRead( PAGE_HEADER_ADDRESS( eeprom_Page ) );
+    ( void ) u8EEPROM_iEraseComplete( FpstInst, TRUE );
 
-    switch( u32HeaderX )
+    while( FpstInst->pstFlash->pfEraseStatus() == FLASH_ITF_ERASE_BUSY )
     {
-        case PAGE_STATUS_ERASED:
-           {
-               return EEPROM_PAGE_ERASED;
-           }
-
-        case PAGE_STATUS_ACTIVE:
-           {
-               return EEPROM_PAGE_ACTIVE;
-           }
-
-        case PAGE_STATUS_RECEIVING:
-           {
-               return EEPROM_PAGE_RECEIVING;
-           }
-
-        default:
-            return EEPROM_PAGE_UNDEFINED;
+        FpstInst->pstFlash->pfEraseWaitHook();
     }
 }
 
 
+
+#if EEPROM_STATS_ENABLE
+
 /**
- * @brief Initialize the EEPROM by checking the page headers and setting the active page and next write address
- * @return Status code indicating the result of the initialization
+ * @brief Get the runtime statistics of the driver, the slot usage of the active page is computed here
+ * @param FpstInst Instance
+ * @param Fpst Pointer to store the statistics
+ * @return Status code indicating the result of the operation
  */
-uint8_t u8EEPROM_eInit( void )
+uint8_t u8EEPROM_eInstGetStats( Tst_EepromInstance * FpstInst,
+                                Tst_EepromStats * Fpst )
 {
-    EEpromHeaderTypedef u32HeaderX0, u32HeaderX1;
+    uint32_t u32PacketAddress;
+    uint64_t u64Packet;
+    uint32_t u32NbLive = 0U;
+    uint8_t u8PageId;
 
-    u32HeaderX1 = eEEPROM_GetHeader( PAGE_1 );
+    if( Fpst == NULL )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
 
-    switch( u32HeaderX1 )
+    if( FpstInst->bInitDone == FALSE )
     {
-        case EEPROM_PAGE_ERASED:
-           {
-               /*P0 Active in all cases --------*/
-               ( void ) u8EEPROM_iSetPageStatus( PAGE_0, PAGE_STATUS_ACTIVE );
+        return Du8EEPROM_eERROR;
+    }
 
-               ( void ) u32EEPROM_iFindNextWriteAddress( PAGE_0, &u32NextWriteAddress );
+    EEPROM_WRITER_LOCK( FpstInst );
 
-               if( u32NextWriteAddress == NO_EMPTY_WRITE_SPACE_FOUND )
-               {
-                   if( Du8EEPROM_eSUCCESS != u8EEPROM_iPageTransfer( PAGE_0, PAGE_1 ) )
-                   {
-                       u8ActivePage = PAGE_0;
-                       return Du8EEPROM_eERROR;
-                   }
-                   else
-                   {
-                       u8ActivePage = PAGE_1;
-
-                       ( void ) u32EEPROM_iFindNextWriteAddress( PAGE_1, &u32NextWriteAddress );
-
-                       if( u32NextWriteAddress == NO_EMPTY_WRITE_SPACE_FOUND )
-                       {
-                           return Du8EEPROM_eERROR;
-                       }
-                   }
-               }
-               else
-               {
-                   u8ActivePage = PAGE_0;
-               }
+    *Fpst = FpstInst->stStats;
 
-               break;
-           }
+    for( u32PacketAddress = PAGE_BODY_ADDRESS( FpstInst, FpstInst->u8ActivePage ); u32PacketAddress < FpstInst->u32NextWriteAddress; u32PacketAddress += PACKET_SIZE )
+    {
+        u64Packet = *( ( uint64_t * ) u32PacketAddress );
 
+        /*payload slots are counted with their head, a tally with its counter*/
+        if( ( TRUE == IS_VIRTUAL_ADDRESS_VALID( ( uint16_t ) ( u64Packet >> 48 ) ) ) && ( TRUE == bEEPROM_iIsPacketValid( u64Packet ) ) &&
+            ( TRUE == bEEPROM_iIsNewestCopy( FpstInst, u32PacketAddress ) ) )
+        {
+            u32NbLive += ( TRUE == bEEPROM_iIsRecordValid( FpstInst, u32PacketAddress ) ) ? u32EEPROM_iPacketSlots( u64Packet ) : 1U;
+            u32NbLive += ( 0U != u32EEPROM_iCounterTally( FpstInst, u32PacketAddress ) ) ? 1U : 0U;
+        }
+    }
 
-        case EEPROM_PAGE_RECEIVING:
-           {
-               u32HeaderX0 = eEEPROM_GetHeader( PAGE_0 );
+    Fpst->u32ActiveLiveSlots = u32NbLive;
+    Fpst->u32ActiveStaleSlots = ( ( FpstInst->u32NextWriteAddress - PAGE_BODY_ADDRESS( FpstInst, FpstInst->u8ActivePage ) ) / PACKET_SIZE ) - u32NbLive;
+    Fpst->u32ActiveFreeSlots = u32EEPROM_iFreePackets( FpstInst );
 
-               switch( u32HeaderX0 )
-               {
-                   case EEPROM_PAGE_ERASED:
-                      {
-                          /*in case voltage drop duing transfer from page0 to page1 */
-                          ( void ) u8EEPROM_iSetPageStatus( PAGE_1, PAGE_STATUS_ACTIVE );
-                          u8ActivePage = PAGE_1;
-                          ( void ) u32EEPROM_iFindNextWriteAddress( PAGE_1, &u32NextWriteAddress );
-
-                          if( u32NextWriteAddress == NO_EMPTY_WRITE_SPACE_FOUND )
-                          {
-                              return Du8EEPROM_eERROR;
-                          }
-
-                          break;
-                      }
-
-                   case EEPROM_PAGE_RECEIVING:
-                      {
-                          /*invalid state*/
-                          ( void ) u8EEPROM_eFormat();
-                          break;
-                      }
-
-                   case EEPROM_PAGE_ACTIVE:
-                      {
-                          /*power loss during data transfer from PAGE_0 to PAGE_1 */
-                          /*=> Erase PAGE_1 (receiving ) and do restart transfer*/
-                          ( void ) u8EEPROM_iRestarPagetTransfer( PAGE_0, PAGE_1 );
-
-                          break;
-                      }
-
-                   case EEPROM_PAGE_UNDEFINED:
-                      {
-                          ( void ) u8EEPROM_eFormat();
-                          break;
-                      }
-
-                   default:
-                      {
-                          /*undefined*/
-                          ( void ) u8EEPROM_eFormat();
-
-                          break;
-                      }
-               }
+    for( u8PageId = 0U; u8PageId < NB_EEPROM_PAGES; u8PageId++ )
+    {
+        ( void ) u8EEPROM_eInstGetEraseCount( FpstInst, u8PageId, &Fpst->au32PageEraseCount[ u8PageId ] );
 
-               break;
-           }
+        if( Fpst->au32PageEraseCount[ u8PageId ] == 0xFFFFFFFFU )
+        {
+            Fpst->au32PageEraseCount[ u8PageId ] = 0U; /*never erased by the driver*/
+        }
+    }
 
-        /*eeporm page 1 is active*/
-        case EEPROM_PAGE_ACTIVE:
-           {
-               u32HeaderX0 = eEEPROM_GetHeader( PAGE_0 );
+    EEPROM_WRITER_UNLOCK( FpstInst );
 
-               switch( u32HeaderX0 )
-               {
-                   case EEPROM_PAGE_ERASED:
-                      {
-                          ( void ) u32EEPROM_iFindNextWriteAddress( PAGE_1, &u32NextWriteAddress );
-
-                          if( u32NextWriteAddress == NO_EMPTY_WRITE_SPACE_FOUND )
-                          {
-                              if( Du8EEPROM_eSUCCESS != u8EEPROM_iPageTransfer( PAGE_1, PAGE_0 ) )
-                              {
-                                  u8ActivePage = PAGE_1;
-                                  return Du8EEPROM_eERROR;
-                              }
-                              else
-                              {
-                                  u8ActivePage = PAGE_0;
-                                  ( void ) u32EEPROM_iFindNextWriteAddress( PAGE_0, &u32NextWriteAddress );
-
-                                  if( u32NextWriteAddress == NO_EMPTY_WRITE_SPACE_FOUND )
-                                  {
-                                      return Du8EEPROM_eERROR;
-                                  }
-                              }
-                          }
-                          else
-                          {
-                              u8ActivePage = PAGE_1;
-                          }
-
-                          break;
-                      }
-
-                   case EEPROM_PAGE_RECEIVING:
-                      { /*restart transfer from page 1 to page 0*/
-                          if( Du8EEPROM_eSUCCESS != u8EEPROM_iRestarPagetTransfer( PAGE_1, PAGE_0 ) )
-                          {
-                              return Du8EEPROM_eERROR;
-                          }
-
-                          break;
-                      }
-
-                   case EEPROM_PAGE_ACTIVE:
-                      {
-                          /*invalid state*/
-                          ( void ) u8EEPROM_eFormat();
-                          break;
-                      }
-
-                   case EEPROM_PAGE_UNDEFINED:
-                      {
-                          /*undefined*/
-                          ( void ) u8EEPROM_eFormat();
-                          break;
-                      }
-
-                   default:
-                      {
-                          /*undefined*/
-                          ( void ) u8EEPROM_eFormat();
-
-                          break;
-                      }
-               }
+    return Du8EEPROM_eSUCCESS;
+}
 
-               break;
-           }
 
+/**
+ * @brief Reset the counters of the runtime statistics
+ * @param FpstInst Instance
+ */
+void vEEPROM_eInstResetStats( Tst_EepromInstance * FpstInst )
+{
+    const Tst_EepromStats stEmpty = { 0U };
 
-        case EEPROM_PAGE_UNDEFINED:
-           {
-               /*undefined*/
-               ( void ) u8EEPROM_eFormat();
-               break;
-           }
+    FpstInst->stStats = stEmpty;
+}
 
-        default:
-           {
-               /*undefined*/
-               ( void ) u8EEPROM_eFormat();
 
-               break;
-           }
+/**
+ * @brief Add the packets read by a lookup to the statistics
+ * @param Fpu32Total Total of the lookups
+ * @param Fpu32Max Longest lookup
+ * @param Fu32NbScanned Packets read by this lookup
+ */
+static void vEEPROM_iStatsScan( uint32_t * Fpu32Total,
+                                uint32_t * Fpu32Max,
+                                uint32_t Fu32NbScanned )
+{
+    *Fpu32Total += Fu32NbScanned;
+
+    if( Fu32NbScanned > *Fpu32Max )
+    {
+        *Fpu32Max = Fu32NbScanned;
     }
+}
 
-    /*mark init as done, can't write or read vars if init is not done*/
-    /*also with init done == true, we're sure that u8ActivePage is initialized (firas)*/
 
+/**
+ * @brief Count a write API call and keep the longest one
+ * @param FpstInst Instance
+ * @param Fu32StartTime u32FLASH_ITF_eGetTimestamp at the start of the call
+ */
+static void vEEPROM_iStatsWriteDone( Tst_EepromInstance * FpstInst,
+                                     uint32_t Fu32StartTime )
+{
+    uint32_t u32Latency = u32FLASH_ITF_eGetTimestamp() - Fu32StartTime;
 
+    FpstInst->stStats.u32Writes++;
 
-    bEEPROM_iInitDone = TRUE;
+    if( u32Latency > FpstInst->stStats.u32MaxWriteLatency )
+    {
+        FpstInst->stStats.u32MaxWriteLatency = u32Latency;
+    }
+}
 
-    /*check integrity and removed redundant vars in they exist*/
-    ( void ) u8EEPROM_eCheckDataIntegrity();
+#endif /* EEPROM_STATS_ENABLE */
 
-    return Du8EEPROM_eSUCCESS;
-}
 
 /**
- * @brief Transfer data from one page to another in the EEPROM
- * @param Fu8PageIdSource: Page ID of the source EEPROM page
- * @param Fu8PageIdDestination: Page ID of the destination EEPROM page
+ * @brief Get the erase count of a specific EEPROM page
+ * @param FpstInst Instance
+ * @param Fu8PageId ID of the EEPROM page
+ * @param Fpu32EraseCount Pointer to store the erase count
  * @return Status code indicating the result of the operation
  */
-uint8_t u8EEPROM_iPageTransfer( uint8_t Fu8PageIdSource,
-                                uint8_t Fu8PageIdDestination )
+uint8_t u8EEPROM_eInstGetEraseCount( Tst_EepromInstance * FpstInst,
+                                     uint8_t Fu8PageId,
+                                     uint32_t * Fpu32EraseCount )
 {
-    uint64_t * pu64Counter = ( uint64_t * ) ( PAGE_HEADER_ADDRESS( Fu8PageIdSource ) + PAGE_HEADER_SIZE );
-    uint32_t u32pageBodyEndAddress;
-    uint64_t u64TempPacket;
-    uint8_t u8FnRet;
-
-    u32pageBodyEndAddress = PAGE_END_ADDRESS( Fu8PageIdSource );
-
-    if( ( Fu8PageIdSource > MAX_PAGE_ID ) || ( Fu8PageIdDestination > MAX_PAGE_ID ) )
+    if( Fpu32EraseCount == NULL )
     {
         return Du8EEPROM_eBAD_PARAM;
     }
 
-    /*STEP 0 : prepre destination page (erase + mark receiving)*/
+    uint32_t u32PageEeraseCountAddress = PAGE_HEADER_ADDRESS( FpstInst, Fu8PageId ) + PAGE_STATUS_SIZE;
 
-    if( FALSE == bEEPROM_isPageErased( Fu8PageIdDestination ) )
-    {
-        u8FnRet = u8EEPROM_iErasePage( Fu8PageIdDestination );
+    *( Fpu32EraseCount ) = *( ( uint32_t * ) u32PageEeraseCountAddress );
 
-        if( u8FnRet != Du8EEPROM_eSUCCESS )
-        {
-            return Du8EEPROM_eERROR;
-        }
-    }
+    return Du8EEPROM_eSUCCESS;
+}
 
-    u8FnRet = u8EEPROM_iSetPageStatus( Fu8PageIdDestination, PAGE_STATUS_RECEIVING );
 
-    if( u8FnRet != Du8EEPROM_eSUCCESS )
-    {
-        return Du8EEPROM_eERROR;
-    }
+/**
+ * @brief Get the header of an EEPROM page
+ * @param FpstInst Instance
+ * @param eeprom_Page: Page ID of the EEPROM page
+ * @return Header information of the EEPROM page
+ */
+EEpromHeaderTypedef eEEPROM_GetHeader( Tst_EepromInstance * FpstInst,
+                                       uint8_t eeprom_Page )
+{
+    uint32_t u32HeaderX;
 
-    /*set new nextWriteAddress*/
-    /*TODO check the line below for reentrancy problems (fismail)*/
-    u32NextWriteAddress = PAGE_HEADER_ADDRESS( Fu8PageIdDestination ) + PAGE_HEADER_SIZE;
+    u32HeaderX = u32EEPROM_iRead( PAGE_HEADER_ADDRESS( FpstInst, eeprom_Page ) );
 
-    /*STEP 1 : copy valid data from Fu8PageIdSource to Fu8PageIdDestination*/
-    while( pu64Counter < ( uint64_t * ) u32pageBodyEndAddress )
+    switch( u32HeaderX )
     {
-        u64TempPacket = *( pu64Counter );
-
-        if( ( u64TempPacket != FREED_PACKET ) && ( u64TempPacket != EMPTY_PACKET ) )
-        {
-            if( u32NextWriteAddress < PAGE_END_ADDRESS( Fu8PageIdDestination ) )
-            {
-                ( void ) u8EEPROM_iWrite( u32NextWriteAddress, u64TempPacket, PACKET_SIZE );
-                u32NextWriteAddress += PACKET_SIZE;
-            }
-            else
-            {
-                /*should not get here unless there are no redundant variables in pageSrc*/
-                /*and the pageSrc was fully used (2047 distinct variables !!!) (fismail)*/
+        case PAGE_STATUS_ERASED:
+           {
+               return EEPROM_PAGE_ERASED;
+           }
 
-                return Du8EEPROM_eWRITE_ERROR;
-            }
-        }
+        case PAGE_STATUS_ACTIVE:
+           {
+               return EEPROM_PAGE_ACTIVE;
+           }
 
-        pu64Counter++;
-    }
+        case PAGE_STATUS_RECEIVING:
+           {
+               return EEPROM_PAGE_RECEIVING;
+           }
 
-    /*TODO (VERY IMPORTANT) check setPageStatus order in case of power loss (fismail)*/
-    u8FnRet = u8EEPROM_iErasePage( Fu8PageIdSource ); /*erase + set to ERASED 0xfff*/
+        default:
+           {
+               /*only bits of RECEIVING were cleared: RECEIVING -> ACTIVE cut by a power loss, the page holds
+                * the data of a receiving page (ERASED -> ACTIVE cut the same way opened an empty page)*/
+               if( ( u32HeaderX & ~PAGE_STATUS_RECEIVING ) == 0U )
+               {
+                   return EEPROM_PAGE_RECEIVING;
+               }
 
-    if( u8FnRet != Du8EEPROM_eSUCCESS )
-    {
-        return Du8EEPROM_eERROR;
+               return EEPROM_PAGE_UNDEFINED;
+           }
     }
-
-    ( void ) u8EEPROM_iSetPageStatus( Fu8PageIdSource, PAGE_STATUS_ERASED ); /* line can be removed*/
-    ( void ) u8EEPROM_iSetPageStatus( Fu8PageIdDestination, PAGE_STATUS_ACTIVE );
-
-
-    u8ActivePage = Fu8PageIdDestination;
-
-    #if INTEGRATION_TEST_MODE
-        bPageTransferCheck = TRUE;
-    #endif
-
-
-    return Du8EEPROM_eSUCCESS;
 }
 
 
 /**
- * @brief Restart a page transfer in the EEPROM
- * @param Fu8PageIdSource: Page ID of the source EEPROM page
- * @param Fu8PageIdDestination: Page ID of the destination EEPROM page
- * @return Status code indicating the result of the operation
+ * @brief Initialize an instance by checking the page headers and setting the active page and next write address
+ * @note the pages holding data are consecutive in the ring (oldest -> active), all ACTIVE except the
+ *       active one, which is RECEIVING while the oldest page is being compacted into it.
+ *       headers are checked to resume from any interrupted page switch, transfer or erase
+ * @param FpstInst Instance
+ * @return Status code indicating the result of the initialization
  */
-uint8_t u8EEPROM_iRestarPagetTransfer( uint8_t Fu8PageIdSource,
-                                       uint8_t Fu8PageIdDestination )
+uint8_t u8EEPROM_eInstInit( Tst_EepromInstance * FpstInst )
 {
     uint8_t u8FnRet;
 
-    if( ( Fu8PageIdSource > MAX_PAGE_ID ) || ( Fu8PageIdDestination > MAX_PAGE_ID ) )
+    if( FALSE == bEEPROM_iIsGeometryValid( FpstInst ) )
     {
         return Du8EEPROM_eBAD_PARAM;
     }
 
-    /*erase the "receiving" page*/
-    u8FnRet = u8EEPROM_iErasePage( Fu8PageIdDestination );
+    EEPROM_WRITER_LOCK( FpstInst );
+    vEEPROM_iSetState( FpstInst );
+    EEPROM_UPDATE_BEGIN( FpstInst );
+    u8FnRet = u8EEPROM_iInit( FpstInst );
+    EEPROM_UPDATE_END( FpstInst );
+    EEPROM_WRITER_UNLOCK( FpstInst );
 
-    if( u8FnRet != Du8EEPROM_eSUCCESS )
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Check the geometry and the flash operations of an instance
+ * @param FpstInst Instance
+ * @return TRUE if the instance can be initialized, FALSE otherwise
+ */
+static BOOL bEEPROM_iIsGeometryValid( const Tst_EepromInstance * FpstInst )
+{
+    if( ( FpstInst == NULL ) || ( FpstInst->pstFlash == NULL ) )
     {
-        return u8FnRet;
+        return FALSE;
     }
-    else
+
+    /*packets are 8 bytes aligned, their slots are 16 bits and a page takes the largest record*/
+    if( ( ( FpstInst->u32StartAddr % PACKET_SIZE ) != 0U ) || ( ( FpstInst->u32PageSize % PACKET_SIZE ) != 0U ) ||
+        ( FpstInst->u32PageSize > ( ( 0xFFFFU / NB_EEPROM_PAGES ) * PACKET_SIZE ) ) ||
+        ( FpstInst->u32PageSize <= PAGE_HEADER_SIZE ) || ( FpstInst->u32PageSize > EEPROM_TRANSFER_MAX_PAGE_SIZE ) ||
+        ( PAGE_PACKETS( FpstInst ) <= ( RECORD_PAYLOAD_SLOTS( EEPROM_RECORD_MAX_SIZE ) + 1U ) ) )
     {
-        /*page erased, header automatically set to 0xFFFFFFFF*/
-        return u8EEPROM_iPageTransfer( Fu8PageIdSource, Fu8PageIdDestination );
+        return FALSE;
     }
+
+    return TRUE;
 }
 
 
 /**
- * @brief Find the next write address in a page of the EEPROM
- * @param u8pageId: Page ID of the EEPROM page
- * @param Fpu32NextWriteAddress: Pointer to store the next write address
- * @return Status code indicating the result of the operation
+ * @brief Set the RAM state of an instance before its first use (a static instance only has its geometry set)
+ * @param FpstInst Instance
  */
-uint32_t u32EEPROM_iFindNextWriteAddress( uint8_t u8pageId,
-                                          uint32_t * Fpu32NextWriteAddress )
+static void vEEPROM_iSetState( Tst_EepromInstance * FpstInst )
 {
-    uint64_t * pu64Counter = ( ( uint64_t * ) PAGE_BODY_ADDRESS( u8pageId ) );
-    uint32_t u32pageEndAddress = PAGE_END_ADDRESS( u8pageId );
-
-
-    if( Fpu32NextWriteAddress == NULL )
+    if( FpstInst->bStateSet == TRUE )
     {
-        return Du8EEPROM_eBAD_PARAM;
+        return; /*kept across the init calls: an erase started before may still run*/
     }
 
-    if( ( u8pageId > MAX_PAGE_ID ) )
+    FpstInst->bInitDone = FALSE;
+    FpstInst->u8ActivePage = 0xFFU;
+    FpstInst->u8OldestPage = 0xFFU;
+    FpstInst->u32NextWriteAddress = NO_EMPTY_WRITE_SPACE_FOUND;
+    FpstInst->eTransferState = EEPROM_TRANSFER_IDLE;
+    FpstInst->u8ErasingPage = 0xFFU;
+    FpstInst->bStateSet = TRUE;
+}
+
+
+/**
+ * @brief Find the pages holding data from their headers and mount them, recover an interrupted transfer
+ * @param FpstInst Instance
+ * @return Status code indicating the result of the initialization
+ */
+static uint8_t u8EEPROM_iInit( Tst_EepromInstance * FpstInst )
+{
+    EEpromHeaderTypedef aeHeader[ NB_EEPROM_PAGES ];
+    uint32_t u32EraseCount;
+    BOOL bImportCut = FALSE;
+    uint8_t u8PageId;
+    uint8_t u8HeadPage = 0xFFU;
+    uint8_t u8TailPage;
+    uint8_t u8NbReceiving = 0U;
+    uint8_t u8NbActive = 0U;
+    uint8_t u8NbRunEnds = 0U;
+    uint8_t u8NbUsedPages = 1U;
+
+    ( void ) u8EEPROM_iEraseComplete( FpstInst, TRUE );
+    FpstInst->eTransferState = EEPROM_TRANSFER_IDLE;
+
+    for( u8PageId = 0U; u8PageId < NB_EEPROM_PAGES; u8PageId++ )
     {
-        return Du8EEPROM_eBAD_PARAM;
+        aeHeader[ u8PageId ] = eEEPROM_GetHeader( FpstInst, u8PageId );
+
+        if( aeHeader[ u8PageId ] == EEPROM_PAGE_RECEIVING )
+        {
+            u8NbReceiving++;
+            u8HeadPage = u8PageId;
+        }
+        else if( aeHeader[ u8PageId ] == EEPROM_PAGE_ACTIVE )
+        {
+            u8NbActive++;
+        }
+
+        ( void ) u8EEPROM_eInstGetEraseCount( FpstInst, u8PageId, &u32EraseCount );
+
+        if( u32EraseCount == PAGE_ERASE_COUNT_IMPORT )
+        {
+            bImportCut = TRUE;
+        }
     }
 
-    while( pu64Counter < ( uint64_t * ) u32pageEndAddress )
+    if( u8NbReceiving == 0U )
     {
-        if( *( pu64Counter ) == EMPTY_PACKET )
+        /*active page = last page of the ACTIVE run*/
+        for( u8PageId = 0U; u8PageId < NB_EEPROM_PAGES; u8PageId++ )
         {
-            ( *Fpu32NextWriteAddress ) = ( uint32_t ) pu64Counter; /*found first empty packet in page*/
-            return Du8EEPROM_eSUCCESS;
+            if( ( aeHeader[ u8PageId ] == EEPROM_PAGE_ACTIVE ) && ( aeHeader[ NEXT_PAGE( u8PageId ) ] != EEPROM_PAGE_ACTIVE ) )
+            {
+                u8NbRunEnds++;
+                u8HeadPage = u8PageId;
+            }
+        }
+    }
+
+    if( bImportCut == TRUE )
+    {
+        /*an image import cut before all its pages were erased: the pages left hold withdrawn data*/
+        ( void ) u8EEPROM_iFormat( FpstInst );
+    }
+    else if( ( u8NbReceiving == 0U ) && ( u8NbActive == 0U ) )
+    {
+        for( u8PageId = 0U; ( u8PageId < NB_EEPROM_PAGES ) && ( aeHeader[ u8PageId ] == EEPROM_PAGE_ERASED ); u8PageId++ )
+        {
+        }
+
+        if( ( u8PageId == NB_EEPROM_PAGES ) && ( TRUE == bEEPROM_iIsPageBlank( FpstInst, PAGE_0 ) ) )
+        {
+            /*all pages erased: P0 Active --------*/
+            ( void ) u8EEPROM_iSetPageStatus( FpstInst, PAGE_0, PAGE_STATUS_ACTIVE );
+            ( void ) u8EEPROM_iMountPages( FpstInst, PAGE_0, PAGE_0 );
+        }
+        else
+        {
+            /*undefined, or an image import cut before the header of P0 was set*/
+            ( void ) u8EEPROM_iFormat( FpstInst );
         }
+    }
+    else if( ( u8NbReceiving > 1U ) || ( ( u8NbReceiving == 0U ) && ( u8NbRunEnds != 1U ) ) )
+    {
+        /*invalid state: several receiving pages, all pages active or active pages not consecutive*/
+        ( void ) u8EEPROM_iFormat( FpstInst );
+    }
+    else
+    {
+        u8TailPage = u8HeadPage;
+
+        while( ( u8NbUsedPages < NB_EEPROM_PAGES ) && ( aeHeader[ PREV_PAGE( u8TailPage ) ] == EEPROM_PAGE_ACTIVE ) )
+        {
+            u8TailPage = PREV_PAGE( u8TailPage );
+            u8NbUsedPages++;
+        }
+
+        if( ( u8NbUsedPages - u8NbReceiving ) != u8NbActive )
+        {
+            /*invalid state: active pages not consecutive*/
+            ( void ) u8EEPROM_iFormat( FpstInst );
+        }
+        else
+        {
+            /*free pages: finish the erase of the ones with an undefined header (power loss during erase)*/
+            for( u8PageId = NEXT_PAGE( u8HeadPage ); u8PageId != u8TailPage; u8PageId = NEXT_PAGE( u8PageId ) )
+            {
+                if( aeHeader[ u8PageId ] != EEPROM_PAGE_ERASED )
+                {
+                    ( void ) u8EEPROM_iErasePage( FpstInst, u8PageId );
+                }
+            }
 
-        pu64Counter++;
+            if( aeHeader[ u8HeadPage ] == EEPROM_PAGE_RECEIVING )
+            {
+                if( u8NbUsedPages == NB_EEPROM_PAGES )
+                {
+                    /*power loss during data transfer from the oldest page to the receiving page */
+                    /*=> restart transfer, the receiving page may already hold new writes and is kept*/
+                    ( void ) u8EEPROM_iMountPages( FpstInst, u8TailPage, u8HeadPage );
+
+                    if( Du8EEPROM_eSUCCESS != u8EEPROM_iRestarPagetTransfer( FpstInst ) )
+                    {
+                        return Du8EEPROM_eERROR;
+                    }
+                }
+                else
+                {
+                    /*in case voltage drop after the transfer erased the source page*/
+                    ( void ) u8EEPROM_iSetPageStatus( FpstInst, u8HeadPage, PAGE_STATUS_ACTIVE );
+                    ( void ) u8EEPROM_iMountPages( FpstInst, u8TailPage, u8HeadPage );
+                }
+            }
+            else
+            {
+                ( void ) u8EEPROM_iMountPages( FpstInst, u8TailPage, u8HeadPage );
+
+                if( FpstInst->u32NextWriteAddress == NO_EMPTY_WRITE_SPACE_FOUND )
+                {
+                    if( Du8EEPROM_eSUCCESS != u8EEPROM_iOpenNextPage( FpstInst ) )
+                    {
+                        return Du8EEPROM_eERROR;
+                    }
+                }
+            }
+
+            if( FpstInst->u32NextWriteAddress >= PAGE_END_ADDRESS( FpstInst, FpstInst->u8ActivePage ) )
+            {
+                return Du8EEPROM_eERROR;
+            }
+        }
     }
 
-    ( *Fpu32NextWriteAddress ) = NO_EMPTY_WRITE_SPACE_FOUND;
+    /*mark init as done, can't write or read vars if init is not done*/
+    /*also with init done == true, we're sure that FpstInst->u8ActivePage is initialized (firas)*/
+
+    /*the page scan above already checked the CRCs, removed the redundant var
+     * and filled the index, no second pass is needed*/
+
+    FpstInst->bInitDone = TRUE;
+
     return Du8EEPROM_eSUCCESS;
 }
 
 /**
- * @brief Check if the EEPROM is erased
- * @return TRUE if both EEPROM pages (PAGE_0 and PAGE_1) are erased, FALSE otherwise
+ * @brief Prepare a page to receive data: erase it unless its header and body are already erased
+ * @param FpstInst Instance
+ * @param Fu8PageId: Page ID of the EEPROM page
+ * @return Status code indicating the result of the operation
  */
-BOOL bEEPROM_eIsEepromErased( void )
+static uint8_t u8EEPROM_iPreparePage( Tst_EepromInstance * FpstInst,
+                                      uint8_t Fu8PageId )
 {
-    return( ( bEEPROM_isPageErased( PAGE_0 ) == TRUE ) && ( bEEPROM_isPageErased( PAGE_1 ) == TRUE ) );
+    ( void ) u8EEPROM_iEraseComplete( FpstInst, TRUE );
+
+    if( FALSE == bEEPROM_iIsPageBlank( FpstInst, Fu8PageId ) )
+    {
+        if( u8EEPROM_iErasePage( FpstInst, Fu8PageId ) != Du8EEPROM_eSUCCESS )
+        {
+            return Du8EEPROM_eERROR;
+        }
+    }
+
+    return Du8EEPROM_eSUCCESS;
 }
 
 
 /**
- * @brief Check if a page in the EEPROM is erased
- * @param Fu8PageId: Page ID of the EEPROM page to be checked
- * @return TRUE if the page is erased (all packets are empty), FALSE otherwise
+ * @brief Move the writes to the next page of the ring once the active page is full
+ * @note opening the last erased page compacts the oldest page into it (page transfer),
+ *       so one page is always free for the next switch
+ * @param FpstInst Instance
+ * @return Status code indicating the result of the operation
  */
-BOOL bEEPROM_isPageErased( const uint8_t Fu8PageId )
+static uint8_t u8EEPROM_iOpenNextPage( Tst_EepromInstance * FpstInst )
 {
-    if( Fu8PageId > MAX_PAGE_ID )
+    uint8_t u8NextPage = NEXT_PAGE( FpstInst->u8ActivePage );
+
+    if( FpstInst->eTransferState != EEPROM_TRANSFER_IDLE )
     {
-        return Du8EEPROM_eBAD_PARAM;
+        /*the pending transfer must free the oldest page (and end its erase) first*/
+        if( Du8EEPROM_eSUCCESS != u8EEPROM_iTransferStep( FpstInst, TRANSFER_STEP_UNLIMITED ) )
+        {
+            return Du8EEPROM_eERROR;
+        }
     }
 
-    uint32_t u32pageAdress = PAGE_HEADER_ADDRESS( Fu8PageId ) + PAGE_HEADER_SIZE;
+    if( NEXT_PAGE( u8NextPage ) == FpstInst->u8OldestPage )
+    {
+        return u8EEPROM_iPageTransfer( FpstInst, FpstInst->u8OldestPage, u8NextPage );
+    }
 
-    while( u32pageAdress <= ( PAGE_END_ADDRESS( Fu8PageId ) - PACKET_SIZE ) )
+    if( Du8EEPROM_eSUCCESS != u8EEPROM_iPreparePage( FpstInst, u8NextPage ) )
     {
-        if( *( uint64_t * ) u32pageAdress != EMPTY_PACKET )
-        {
-            return FALSE;
-        }
+        return Du8EEPROM_eERROR;
+    }
 
-        u32pageAdress += PACKET_SIZE;
+    if( Du8EEPROM_eSUCCESS != u8EEPROM_iSetPageStatus( FpstInst, u8NextPage, PAGE_STATUS_ACTIVE ) )
+    {
+        return Du8EEPROM_eERROR;
     }
 
-    return TRUE;
+    EEPROM_UPDATE_BEGIN( FpstInst );
+    FpstInst->u8ActivePage = u8NextPage;
+    FpstInst->u32NextWriteAddress = PAGE_BODY_ADDRESS( FpstInst, u8NextPage );
+    EEPROM_UPDATE_END( FpstInst );
+
+    return Du8EEPROM_eSUCCESS;
 }
 
 
 /**
- * @brief Write a variable to the EEPROM based on the virtual address
- * @param Fu16VirtAddr Virtual address of the variable to write
- * @param Fu32Data Data value to write
- * @return Status code indicating the result of the write operation
+ * @brief Transfer data from one page to another in the EEPROM
+ * @note the source is the oldest page, the destination becomes the active page: the packets of the
+ *       source that were not superseded are copied to the active page, interleaved with the new writes,
+ *       so the position of a packet always tells its age. with EEPROM_INCREMENTAL_TRANSFER_ENABLE
+ *       the copy and the erase are left to u8EEPROM_eTransferStep
+ * @param FpstInst Instance
+ * @param Fu8PageIdSource: Page ID of the source EEPROM page
+ * @param Fu8PageIdDestination: Page ID of the destination EEPROM page
+ * @return Status code indicating the result of the operation
  */
-uint8_t u8EEPROM_eWriteVar( uint16_t Fu16VirtAddr,
-                            uint32_t Fu32Data )
+uint8_t u8EEPROM_iPageTransfer( Tst_EepromInstance * FpstInst,
+                                uint8_t Fu8PageIdSource,
+                                uint8_t Fu8PageIdDestination )
 {
-    uint64_t u64Packet;
+    uint8_t u8FnRet;
 
-    #if ( WRITE_CORRECTION_ENABLE )
-        uint8_t u8WrtiteRetries = 0U;
-        BOOL bWriteProblem = FALSE;
-    #endif
-    uint64_t u64PacketRead;
-    uint16_t u16packetCRC;
+    if( ( Fu8PageIdSource > MAX_PAGE_ID ) || ( Fu8PageIdDestination > MAX_PAGE_ID ) || ( Fu8PageIdSource == Fu8PageIdDestination ) )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    /*STEP 0 : prepre destination page (erase + mark receiving)*/
+
+    u8FnRet = u8EEPROM_iPreparePage( FpstInst, Fu8PageIdDestination );
+
+    if( u8FnRet != Du8EEPROM_eSUCCESS )
+    {
+        return Du8EEPROM_eERROR;
+    }
 
-    if( bEEPROM_iInitDone == FALSE )
+    u8FnRet = u8EEPROM_iSetPageStatus( FpstInst, Fu8PageIdDestination, PAGE_STATUS_RECEIVING );
+
+    if( u8FnRet != Du8EEPROM_eSUCCESS )
     {
         return Du8EEPROM_eERROR;
     }
 
-    /*forbidden adresses*/
-    if( ( Fu16VirtAddr == 0U ) || ( Fu16VirtAddr == 0xFFFFU ) )
+    /*set new nextWriteAddress, the destination is now the newest page of the ring*/
+    EEPROM_UPDATE_BEGIN( FpstInst );
+    FpstInst->u8ActivePage = Fu8PageIdDestination;
+    FpstInst->u8OldestPage = Fu8PageIdSource;
+    FpstInst->u32NextWriteAddress = PAGE_HEADER_ADDRESS( FpstInst, Fu8PageIdDestination ) + PAGE_HEADER_SIZE;
+    EEPROM_UPDATE_END( FpstInst );
+
+    /*STEP 1 and 2 : copy valid data from Fu8PageIdSource to Fu8PageIdDestination, erase Fu8PageIdSource*/
+    return u8EEPROM_iRestarPagetTransfer( FpstInst );
+}
+
+
+/**
+ * @brief Restart a page transfer in the EEPROM, from the first packet of the oldest page to the active page
+ * @note after a power loss the packets already copied are superseded by their copy and are skipped
+ * @param FpstInst Instance
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_iRestarPagetTransfer( Tst_EepromInstance * FpstInst )
+{
+    if( ( FpstInst->u8OldestPage > MAX_PAGE_ID ) || ( FpstInst->u8OldestPage == FpstInst->u8ActivePage ) )
     {
-        return Du8EEPROM_eWRITE_ERROR;
+        return Du8EEPROM_eBAD_PARAM;
     }
 
-    u16packetCRC = u16EEPROM_iCalculateCRC( Fu16VirtAddr, Fu32Data );
+    FpstInst->eTransferState = EEPROM_TRANSFER_COPY;
+    FpstInst->u32TransferCursor = PAGE_BODY_ADDRESS( FpstInst, FpstInst->u8OldestPage );
+    FpstInst->u8TransferRetries = 0U;
+    vEEPROM_iTransferMarkLive( FpstInst );
 
-    u64Packet = ( ( uint64_t ) Fu16VirtAddr << 48 ) + ( ( uint64_t ) u16packetCRC << 32 ) + ( ( uint64_t ) Fu32Data );
+    #if EEPROM_INCREMENTAL_TRANSFER_ENABLE
+        /*the active page takes new writes first only if they can't starve the copy*/
+        if( FpstInst->u32TransferRemaining < u32EEPROM_iFreePackets( FpstInst ) )
+        {
+            return Du8EEPROM_eSUCCESS;
+        }
+    #endif
+
+    return u8EEPROM_iTransferStep( FpstInst, TRANSFER_STEP_UNLIMITED );
+}
+
+
+/**
+ * @brief Run a slice of the pending page transfer inside one flash programming session
+ * @param FpstInst Instance
+ * @param Fu32MaxPackets Maximum number of source packets to process
+ * @return Status code indicating the result of the operation
+ */
+static uint8_t u8EEPROM_iTransferStep( Tst_EepromInstance * FpstInst,
+                                       uint32_t Fu32MaxPackets )
+{
+    uint8_t u8FnRet;
 
-    if( Du8EEPROM_eSUCCESS == u8EEPROM_iWrite( u32NextWriteAddress, u64Packet, PACKET_SIZE ) )
+    FpstInst->pstFlash->pfSessionBegin();
+    u8FnRet = u8EEPROM_iTransferRun( FpstInst, Fu32MaxPackets );
+    FpstInst->pstFlash->pfSessionEnd();
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Run a slice of the pending page transfer
+ * @param FpstInst Instance
+ * @param Fu32MaxPackets Maximum number of source packets to process
+ * @return Status code indicating the result of the operation
+ */
+static uint8_t u8EEPROM_iTransferRun( Tst_EepromInstance * FpstInst,
+                                      uint32_t Fu32MaxPackets )
+{
+    uint32_t u32pageBodyEndAddress = PAGE_END_ADDRESS( FpstInst, FpstInst->u8OldestPage );
+    uint32_t u32NbSlots;
+    uint32_t u32SlotAddress;
+    uint64_t u64TempPacket;
+    uint64_t au64Burst[ EEPROM_TRANSFER_BURST_PACKETS ] = { 0U };
+    uint32_t u32NbBurst = 0U; /*packets gathered, programmed from FpstInst->u32NextWriteAddress*/
+    uint8_t u8FnRet;
+
+    /*STEP 1 : copy the packets marked live from the oldest page to the active page*/
+    while( ( FpstInst->eTransferState == EEPROM_TRANSFER_COPY ) && ( Fu32MaxPackets > 0U ) )
     {
-        /*by enabling WRITE_CORRECTION_ENABLE in the cfg file, the code below will detect if a writeVar operation
-         *  was not successful and will attempt to write it at the next empty 64* address.
-         * this feature was not fully tested (firas)*/
-        #if ( WRITE_CORRECTION_ENABLE ) /*partially tested*/
-            u64PacketRead = *( ( uint64_t * ) u32NextWriteAddress );
+        u8FnRet = Du8EEPROM_eSUCCESS;
+
+        if( FpstInst->u32TransferCursor >= u32pageBodyEndAddress )
+        {
+            /*the copies are in flash and read back before the source can be erased*/
+            if( Du8EEPROM_eSUCCESS == u8EEPROM_iFlushTransferBurst( FpstInst, au64Burst, &u32NbBurst ) )
+            {
+                FpstInst->eTransferState = EEPROM_TRANSFER_ERASE;
+                break;
+            }
+
+            u8FnRet = Du8EEPROM_eWRITE_ERROR;
+        }
+        else if( FALSE == bEEPROM_iIsTransferMarked( FpstInst, FpstInst->u32TransferCursor ) )
+        {
+            /*stale, freed or damaged: reclaimed with the source page*/
+            if( *( ( uint64_t * ) FpstInst->u32TransferCursor ) != EMPTY_PACKET )
+            {
+                EEPROM_STATS_ADD( FpstInst, u32TransferDropped, 1U );
+            }
+        }
+        else if( ( uint16_t ) ( *( ( uint64_t * ) FpstInst->u32TransferCursor ) >> 48 ) != RECORD_SLOT_MARKER ) /*payload slots move with their record head*/
+        {
+            u64TempPacket = *( ( uint64_t * ) FpstInst->u32TransferCursor );
+            u32NbSlots = u32EEPROM_iPacketSlots( u64TempPacket );
+
+            if( 0U != u32EEPROM_iCounterTally( FpstInst, FpstInst->u32TransferCursor ) )
+            {
+                /*a counter leaves its tally behind: its value is copied as a plain variable*/
+                u64TempPacket = u64EEPROM_iMakePacket( ( uint16_t ) ( u64TempPacket >> 48 ), u32EEPROM_iVarValue( FpstInst, FpstInst->u32TransferCursor ) );
+            }
 
-            while( ( u64PacketRead != u64Packet ) && ( u32NextWriteAddress < PAGE_END_ADDRESS( u8ActivePage ) - PACKET_SIZE ) )
+            if( FALSE == bEEPROM_iIsTransferLive( FpstInst, FpstInst->u32TransferCursor ) )
+            {
+                /*superseded by a write since the bitmap was built*/
+                FpstInst->u32TransferRemaining = ( FpstInst->u32TransferRemaining > u32NbSlots ) ? ( FpstInst->u32TransferRemaining - u32NbSlots ) : 0U;
+                EEPROM_STATS_ADD( FpstInst, u32TransferDropped, u32NbSlots );
+            }
+            else if( TRUE == bEEPROM_iRelocate( FpstInst, u64TempPacket ) )
+            {
+                /*written elsewhere, this copy leaves with the source page. its room stays reserved in
+                 * u32TransferRemaining: a transfer resumed after a power loss may have to copy it*/
+                vEEPROM_iFreeOlderCopies( FpstInst, FpstInst->u32TransferCursor );
+            }
+            else if( ( FpstInst->u32NextWriteAddress + ( ( u32NbBurst + u32NbSlots ) * PACKET_SIZE ) ) <= PAGE_END_ADDRESS( FpstInst, FpstInst->u8ActivePage ) )
             {
-                bWriteProblem = TRUE;
-                /*write error at address u32NextWriteAddress*/
-                /*flash cell wearing  (firas)*/
-                /*TODO : detect write error and write at another adress*/
-                ( void ) u8EEPROM_iWrite( u32NextWriteAddress, FREED_PACKET, PACKET_SIZE );
-                u32NextWriteAddress += PACKET_SIZE;
-                ( void ) u8EEPROM_iWrite( u32NextWriteAddress, u64Packet, PACKET_SIZE );
-                u64PacketRead = *( ( uint64_t * ) u32NextWriteAddress );
-                u8WrtiteRetries++;
-
-                if( ( u64PacketRead == u64Packet ) )
+                FpstInst->u32TransferRemaining = ( FpstInst->u32TransferRemaining > u32NbSlots ) ? ( FpstInst->u32TransferRemaining - u32NbSlots ) : 0U;
+
+                /*a record is copied in order: payload slots (just before its head), then the head*/
+                for( u32SlotAddress = FpstInst->u32TransferCursor - ( ( u32NbSlots - 1U ) * PACKET_SIZE );
+                     u32SlotAddress <= FpstInst->u32TransferCursor;
+                     u32SlotAddress += PACKET_SIZE )
                 {
-                    bWriteProblem = FALSE;
+                    if( u32NbBurst == EEPROM_TRANSFER_BURST_PACKETS )
+                    {
+                        u8FnRet = u8EEPROM_iFlushTransferBurst( FpstInst, au64Burst, &u32NbBurst );
+
+                        if( u8FnRet != Du8EEPROM_eSUCCESS )
+                        {
+                            break;
+                        }
+                    }
+
+                    au64Burst[ u32NbBurst ] = ( u32SlotAddress == FpstInst->u32TransferCursor ) ? u64TempPacket : *( ( uint64_t * ) u32SlotAddress );
+                    u32NbBurst++;
                 }
+            }
+            else
+            {
+                /*should not get here unless there are no redundant variables in pageSrc*/
+                /*and the pageSrc was fully used (2047 distinct variables !!!) (fismail)*/
 
-                /*we try to write at next address*/
+                ( void ) u8EEPROM_iFlushTransferBurst( FpstInst, au64Burst, &u32NbBurst );
+                return Du8EEPROM_eWRITE_ERROR;
             }
+        }
 
-            if( bWriteProblem )
+        if( u8FnRet != Du8EEPROM_eSUCCESS )
+        {
+            /*the flush freed its copies and moved the cursor back to the first packet of the page*/
+            if( FpstInst->u8TransferRetries > EEPROM_TRANSFER_VERIFY_RETRIES )
             {
                 return Du8EEPROM_eWRITE_ERROR;
             }
-        #endif /* if ( WRITE_CORRECTION_ENABLE ) */
-        /*free already written variable if it exists*/
 
-        /*if power shut down here, it won't cause problems after next page transfer
-         * because ransfer happens from top to buttom (fismail)*/
+            continue;
+        }
+
+        FpstInst->u32TransferCursor += PACKET_SIZE;
+        Fu32MaxPackets--;
+    }
+
+    /*the gathered copies are in flash before a write is appended*/
+    if( ( Du8EEPROM_eSUCCESS != u8EEPROM_iFlushTransferBurst( FpstInst, au64Burst, &u32NbBurst ) ) &&
+        ( FpstInst->u8TransferRetries > EEPROM_TRANSFER_VERIFY_RETRIES ) )
+    {
+        return Du8EEPROM_eWRITE_ERROR;
+    }
+
+    if( ( FpstInst->eTransferState == EEPROM_TRANSFER_ERASE ) && ( Fu32MaxPackets > 0U ) )
+    {
+        /*STEP 2 : start erasing the source, all its live data is copied so it leaves the ring now*/
+        /*TODO (VERY IMPORTANT) check setPageStatus order in case of power loss (fismail)*/
+        /*a read that was walking the source retries, the next ones stop before it*/
+        EEPROM_UPDATE_BEGIN( FpstInst );
+        u8FnRet = u8EEPROM_iEraseStart( FpstInst, FpstInst->u8OldestPage ); /*erase + set to ERASED 0xfff*/
+
+        if( u8FnRet != Du8EEPROM_eSUCCESS )
+        {
+            EEPROM_UPDATE_END( FpstInst );
+            return Du8EEPROM_eERROR;
+        }
+
+        #if EEPROM_RAM_INDEX_ENABLE
+            /*the relocated and the damaged variables left behind are no longer in the instance*/
+            vEEPROM_iIndexDropPage( FpstInst, FpstInst->u8OldestPage );
+        #endif
+
+        FpstInst->u8OldestPage = NEXT_PAGE( FpstInst->u8OldestPage );
+        EEPROM_UPDATE_END( FpstInst );
+        FpstInst->eTransferState = EEPROM_TRANSFER_ERASE_WAIT;
+    }
+
+    if( FpstInst->eTransferState == EEPROM_TRANSFER_ERASE_WAIT )
+    {
+        /*STEP 3 : once erased the source becomes the free page of the ring, only a full step waits for it*/
+        u8FnRet = u8EEPROM_iEraseComplete( FpstInst, ( Fu32MaxPackets == TRANSFER_STEP_UNLIMITED ) ? TRUE : FALSE );
+
+        if( u8FnRet == Du8EEPROM_eBUSY )
+        {
+            return Du8EEPROM_eSUCCESS;
+        }
+
+        if( u8FnRet != Du8EEPROM_eSUCCESS )
+        {
+            return Du8EEPROM_eERROR;
+        }
+
+        ( void ) u8EEPROM_iSetPageStatus( FpstInst, PREV_PAGE( FpstInst->u8OldestPage ), PAGE_STATUS_ERASED ); /* line can be removed*/
+        ( void ) u8EEPROM_iSetPageStatus( FpstInst, FpstInst->u8ActivePage, PAGE_STATUS_ACTIVE );
+
+        FpstInst->eTransferState = EEPROM_TRANSFER_IDLE;
+        EEPROM_STATS_ADD( FpstInst, u32Transfers, 1U );
+
+        #if INTEGRATION_TEST_MODE
+            bPageTransferCheck = TRUE;
+        #endif
+    }
+
+    return Du8EEPROM_eSUCCESS;
+}
+
+
+/**
+ * @brief Build the liveness bitmap of the oldest page in one backward scan: the newest copy of each variable
+ *        or record, if its CRC is valid, is marked (a record with its payload slots) and counted in u32TransferRemaining
+ * @param FpstInst Instance
+ */
+static void vEEPROM_iTransferMarkLive( Tst_EepromInstance * FpstInst )
+{
+    uint32_t u32BodyAddress = PAGE_BODY_ADDRESS( FpstInst, FpstInst->u8OldestPage );
+    uint32_t u32PacketAddress = PAGE_END_ADDRESS( FpstInst, FpstInst->u8OldestPage );
+    uint32_t u32NbSlots;
+    uint32_t u32Slot;
+    uint32_t u32Pos;
+    uint64_t u64Packet;
+
+    for( u32Pos = 0U; u32Pos < TRANSFER_LIVE_WORDS; u32Pos++ )
+    {
+        FpstInst->au32TransferLive[ u32Pos ] = 0U;
+    }
+
+    FpstInst->u32TransferRemaining = 0U;
+    FpstInst->u32TransferMarkEnd = FpstInst->u32NextWriteAddress;
+
+    /*newest first: a record head is met before its payload slots*/
+    while( u32PacketAddress > u32BodyAddress )
+    {
+        u32PacketAddress -= PACKET_SIZE;
+        u64Packet = *( ( uint64_t * ) u32PacketAddress );
+
+        /*record payload slots and counter tallies are not variables*/
+        if( ( u64Packet == EMPTY_PACKET ) || ( u64Packet == FREED_PACKET ) || ( FALSE == IS_VIRTUAL_ADDRESS_VALID( ( uint16_t ) ( u64Packet >> 48 ) ) ) ||
+            ( FALSE == bEEPROM_iIsPacketValid( u64Packet ) ) )
+        {
+            continue;
+        }
 
-        ( void ) u8EEPROM_freeVar( Fu16VirtAddr, ( u32NextWriteAddress - PACKET_SIZE ) );
+        if( ( ( TRUE == bEEPROM_iIsRecordHead( u64Packet ) ) && ( FALSE == bEEPROM_iIsRecordValid( FpstInst, u32PacketAddress ) ) ) ||
+            ( FALSE == bEEPROM_iIsNewestCopy( FpstInst, u32PacketAddress ) ) )
+        {
+            continue;
+        }
+
+        for( u32NbSlots = u32EEPROM_iPacketSlots( u64Packet ); u32NbSlots > 0U; u32NbSlots-- )
+        {
+            u32Slot = TRANSFER_LIVE_SLOT( FpstInst, u32PacketAddress );
+            FpstInst->au32TransferLive[ u32Slot / 32U ] |= ( 1UL << ( u32Slot % 32U ) );
+            FpstInst->u32TransferRemaining++;
+            u32PacketAddress -= PACKET_SIZE;
+        }
+
+        u32PacketAddress += PACKET_SIZE; /*first payload slot, the scan goes on before it*/
+    }
+}
+
+
+/**
+ * @brief Check if a packet of the oldest page is marked in the liveness bitmap of the transfer
+ * @param FpstInst Instance
+ * @param Fu32PacketAddress Address of the packet in the oldest page
+ * @return TRUE if it was marked live, FALSE otherwise
+ */
+static BOOL bEEPROM_iIsTransferMarked( Tst_EepromInstance * FpstInst,
+                                       uint32_t Fu32PacketAddress )
+{
+    uint32_t u32Slot = TRANSFER_LIVE_SLOT( FpstInst, Fu32PacketAddress );
+
+    return( ( ( FpstInst->au32TransferLive[ u32Slot / 32U ] & ( 1UL << ( u32Slot % 32U ) ) ) != 0U ) ? TRUE : FALSE );
+}
+
+
+/**
+ * @brief Check that a packet marked live is still the newest copy of its variable when it is copied
+ * @note only the packets written after the bitmap (u32TransferMarkEnd) can supersede it
+ * @param FpstInst Instance
+ * @param Fu32PacketAddress Address of a marked variable or record head in the oldest page
+ * @return TRUE if it must be copied, FALSE otherwise
+ */
+static BOOL bEEPROM_iIsTransferLive( Tst_EepromInstance * FpstInst,
+                                     uint32_t Fu32PacketAddress )
+{
+    uint16_t u16VirtAddr = ( uint16_t ) ( *( ( uint64_t * ) Fu32PacketAddress ) >> 48 );
+    uint32_t u32PacketAddress;
+
+    /*freed since by a newer write (EEPROM_LAZY_FREE_ENABLE == 0)*/
+    if( *( ( uint64_t * ) Fu32PacketAddress ) == FREED_PACKET )
+    {
+        return FALSE;
+    }
+
+    #if EEPROM_RAM_INDEX_ENABLE
+        u32PacketAddress = u32EEPROM_iIndexLookup( FpstInst, u16VirtAddr );
+
+        if( u32PacketAddress != INDEX_ENTRY_NOT_FOUND )
+        {
+            return( ( u32PacketAddress == Fu32PacketAddress ) ? TRUE : FALSE );
+        }
+    #endif
+
+    for( u32PacketAddress = FpstInst->u32TransferMarkEnd; u32PacketAddress < FpstInst->u32NextWriteAddress; u32PacketAddress += PACKET_SIZE )
+    {
+        if( ( uint16_t ) ( *( ( uint64_t * ) u32PacketAddress ) >> 48 ) == u16VirtAddr )
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+
+/**
+ * @brief Offer a live packet of the page being compacted to the pfRelocate hook of the instance
+ * @param FpstInst Instance
+ * @param Fu64Packet Newest packet of a variable, records and damaged packets are always copied
+ * @return TRUE if the variable was written elsewhere and must not be copied, FALSE otherwise
+ */
+static BOOL bEEPROM_iRelocate( Tst_EepromInstance * FpstInst,
+                               uint64_t Fu64Packet )
+{
+    uint16_t u16VirtAddr = ( uint16_t ) ( Fu64Packet >> 48 );
+
+    if( ( FpstInst->pfRelocate == NULL ) ||
+        ( ( uint16_t ) ( Fu64Packet >> 32 ) != u16EEPROM_iCalculateCRC( u16VirtAddr, ( uint32_t ) Fu64Packet ) ) )
+    {
+        return FALSE;
+    }
+
+    if( FALSE == FpstInst->pfRelocate( u16VirtAddr, ( uint32_t ) Fu64Packet ) )
+    {
+        return FALSE;
+    }
+
+    EEPROM_STATS_ADD( FpstInst, u32Relocations, 1U );
+
+    return TRUE;
+}
+
+
+/**
+ * @brief Free the older copies of a relocated variable in the page being compacted
+ * @note no copy of the variable is left in the ring to supersede them: an erase of the source cut by a power
+ *       loss could keep an older copy and lose the newest, the transfer resumed at init would copy it back
+ * @param FpstInst Instance
+ * @param Fu32PacketAddress Address of the relocated packet in the oldest page
+ */
+static void vEEPROM_iFreeOlderCopies( Tst_EepromInstance * FpstInst,
+                                      uint32_t Fu32PacketAddress )
+{
+    uint16_t u16VirtAddr = ( uint16_t ) ( *( ( uint64_t * ) Fu32PacketAddress ) >> 48 );
+    uint32_t u32PacketAddress;
+
+    for( u32PacketAddress = PAGE_BODY_ADDRESS( FpstInst, FpstInst->u8OldestPage ); u32PacketAddress < Fu32PacketAddress; u32PacketAddress += PACKET_SIZE )
+    {
+        if( ( uint16_t ) ( *( ( uint64_t * ) u32PacketAddress ) >> 48 ) == u16VirtAddr )
+        {
+            ( void ) u8EEPROM_iWrite( FpstInst, u32PacketAddress, FREED_PACKET, PACKET_SIZE );
+        }
+    }
+}
+
+
+/**
+ * @brief Run a slice of the pending page transfer (copy of the oldest page, then its erase)
+ * @param FpstInst Instance
+ * @param Fu32MaxPackets Maximum number of source packets to process, TRANSFER_STEP_UNLIMITED to finish the transfer
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eInstTransferStep( Tst_EepromInstance * FpstInst,
+                                    uint32_t Fu32MaxPackets )
+{
+    uint8_t u8FnRet = Du8EEPROM_eSUCCESS;
+
+    if( FpstInst->bInitDone == FALSE )
+    {
+        return Du8EEPROM_eERROR;
+    }
+
+    EEPROM_WRITER_LOCK( FpstInst );
+
+    if( FpstInst->eTransferState != EEPROM_TRANSFER_IDLE )
+    {
+        u8FnRet = u8EEPROM_iTransferStep( FpstInst, Fu32MaxPackets );
+    }
+
+    EEPROM_WRITER_UNLOCK( FpstInst );
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Check if a page transfer is pending
+ * @param FpstInst Instance
+ * @return TRUE if u8EEPROM_eTransferStep has work to do, FALSE otherwise
+ */
+BOOL bEEPROM_eInstIsTransferPending( Tst_EepromInstance * FpstInst )
+{
+    return( ( FpstInst->eTransferState != EEPROM_TRANSFER_IDLE ) ? TRUE : FALSE );
+}
+
+
+/**
+ * @brief Get the number of variables that can be written before a write has to switch page or finish a transfer
+ * @param FpstInst Instance
+ * @return Number of variables
+ */
+uint32_t u32EEPROM_eInstGetWriteBudget( Tst_EepromInstance * FpstInst )
+{
+    uint32_t u32Reserved = 1U; /*the write filling the page opens the next one*/
+
+    if( FpstInst->bInitDone == FALSE )
+    {
+        return 0U;
+    }
+
+    if( FpstInst->eTransferState != EEPROM_TRANSFER_IDLE )
+    {
+        u32Reserved += FpstInst->u32TransferRemaining;
+    }
+
+    #if EEPROM_INCREMENTAL_TRANSFER_ENABLE
+        else if( NEXT_PAGE( NEXT_PAGE( FpstInst->u8ActivePage ) ) == FpstInst->u8OldestPage )
+        {
+            u32Reserved = EEPROM_TRANSFER_START_THRESHOLD + 1U;
+        }
+    #endif
+
+    if( u32EEPROM_iFreePackets( FpstInst ) <= u32Reserved )
+    {
+        return 0U;
+    }
+
+    return u32EEPROM_iFreePackets( FpstInst ) - u32Reserved;
+}
+
+
+/**
+ * @brief Get the number of free packets left in the active page
+ * @param FpstInst Instance
+ * @return Number of packets that can still be written before a page switch
+ */
+static uint32_t u32EEPROM_iFreePackets( Tst_EepromInstance * FpstInst )
+{
+    if( ( FpstInst->u32NextWriteAddress == NO_EMPTY_WRITE_SPACE_FOUND ) || ( FpstInst->u32NextWriteAddress >= PAGE_END_ADDRESS( FpstInst, FpstInst->u8ActivePage ) ) )
+    {
+        return 0U;
+    }
+
+    return( PAGE_END_ADDRESS( FpstInst, FpstInst->u8ActivePage ) - FpstInst->u32NextWriteAddress ) / PACKET_SIZE;
+}
+
+
+/**
+ * @brief Load the pages holding data (oldest -> active): find the next write address and rebuild the RAM state
+ * @note without the RAM index and with EEPROM_LAZY_FREE_ENABLE the pages are not walked, boot cost does not
+ *       depend on the page fill
+ * @param FpstInst Instance
+ * @param Fu8OldestPage Page ID of the oldest page holding data
+ * @param Fu8ActivePage Page ID of the page receiving the writes
+ * @return Status code indicating the result of the operation
+ */
+static uint8_t u8EEPROM_iMountPages( Tst_EepromInstance * FpstInst,
+                                     uint8_t Fu8OldestPage,
+                                     uint8_t Fu8ActivePage )
+{
+    if( ( Fu8OldestPage > MAX_PAGE_ID ) || ( Fu8ActivePage > MAX_PAGE_ID ) )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    FpstInst->u8OldestPage = Fu8OldestPage;
+    FpstInst->u8ActivePage = Fu8ActivePage;
+    FpstInst->u32NextWriteAddress = u32EEPROM_iFindNextWriteAddress( FpstInst, Fu8ActivePage );
+
+    vEEPROM_iFreeTornPacket( FpstInst );
+
+    #if EEPROM_RAM_INDEX_ENABLE || ( EEPROM_LAZY_FREE_ENABLE == 0U )
+        return u8EEPROM_iScanPages( FpstInst, TRUE );
+    #else
+        /*the relocations free packets too (see vEEPROM_iFreeOlderCopies)*/
+        return( ( FpstInst->pfRelocate != NULL ) ? u8EEPROM_iScanPages( FpstInst, TRUE ) : Du8EEPROM_eSUCCESS );
+    #endif
+}
+
+
+/**
+ * @brief Free the last written packet if its CRC is wrong
+ * @note packets are programmed one after the other, so only the last one can be torn by a power loss.
+ *       freeing it gives back the previous value of the variable, and lets a resumed transfer copy it
+ * @param FpstInst Instance
+ */
+static void vEEPROM_iFreeTornPacket( Tst_EepromInstance * FpstInst )
+{
+    uint32_t u32LastAddress = u32EEPROM_iLastPacketAddress( FpstInst );
+    uint64_t u64Packet;
+
+    if( u32LastAddress == 0U )
+    {
+        return;
+    }
+
+    u64Packet = *( ( uint64_t * ) u32LastAddress );
+
+    /*also frees the payload slot of a record or the tally of a counter whose head was not written, ignored anyway*/
+    if( ( u64Packet != FREED_PACKET ) && ( u64Packet != EMPTY_PACKET ) && ( FALSE == bEEPROM_iIsPacketValid( u64Packet ) ) )
+    {
+        ( void ) u8EEPROM_iWrite( FpstInst, u32LastAddress, FREED_PACKET, PACKET_SIZE );
+    }
+}
+
+
+/**
+ * @brief Walk the pages holding data once, from the oldest packet up to the next write address
+ * @note in the same pass: checks the CRCs, fills the index and frees the older copy
+ *       of the last written variable (power shut between write and free)
+ * @param FpstInst Instance
+ * @param FbMount TRUE at boot: without EEPROM_LAZY_FREE_ENABLE or with a pfRelocate hook the packets with a
+ *        wrong CRC are freed
+ * @return Du8EEPROM_eDATA_CORRUPTED if a packet has a wrong CRC, status of the operation otherwise
+ */
+static uint8_t u8EEPROM_iScanPages( Tst_EepromInstance * FpstInst,
+                                    BOOL FbMount )
+{
+    uint32_t u32PacketAddress;
+    uint32_t u32LastValidAddress = 0U;
+    uint64_t u64Packet;
+    uint16_t u16VirtAddr;
+    uint8_t u8FnRet = Du8EEPROM_eSUCCESS;
+
+    if( ( FpstInst->u8ActivePage > MAX_PAGE_ID ) || ( FpstInst->u8OldestPage > MAX_PAGE_ID ) )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    #if EEPROM_RAM_INDEX_ENABLE
+        vEEPROM_iIndexClear( FpstInst );
+    #endif
+
+    for( u32PacketAddress = PAGE_BODY_ADDRESS( FpstInst, FpstInst->u8OldestPage );
+         ( u32PacketAddress != 0U ) && ( u32PacketAddress != FpstInst->u32NextWriteAddress );
+         u32PacketAddress = u32EEPROM_iNextPacketAddress( FpstInst, u32PacketAddress ) )
+    {
+        u64Packet = *( ( uint64_t * ) u32PacketAddress );
+
+        u16VirtAddr = ( uint16_t ) ( u64Packet >> 48 );
+
+        if( ( u64Packet == FREED_PACKET ) || ( FALSE == IS_VIRTUAL_ADDRESS_VALID( u16VirtAddr ) ) )
+        {
+            continue; /*freed packet, empty hole, torn write or record payload*/
+        }
+
+        if( FALSE == bEEPROM_iIsPacketValid( u64Packet ) ) /*is CRC correct*/
+        {
+            if( ( FbMount == TRUE ) && ( ( EEPROM_LAZY_FREE_ENABLE == 0U ) || ( FpstInst->pfRelocate != NULL ) ) )
+            {
+                /*older copies are freed on write or on relocation: this is a free cut by a power loss, the
+                 * bits left may name another variable and would hide its valid copy*/
+                ( void ) u8EEPROM_iWrite( FpstInst, u32PacketAddress, FREED_PACKET, PACKET_SIZE );
+                continue;
+            }
+
+            u8FnRet = Du8EEPROM_eDATA_CORRUPTED;
+        }
+        else if( ( TRUE == bEEPROM_iIsRecordHead( u64Packet ) ) && ( FALSE == bEEPROM_iIsRecordValid( FpstInst, u32PacketAddress ) ) )
+        {
+            u8FnRet = Du8EEPROM_eDATA_CORRUPTED;
+        }
+        else
+        {
+            u32LastValidAddress = u32PacketAddress;
+        }
+
+        #if EEPROM_RAM_INDEX_ENABLE
+            vEEPROM_iIndexUpdate( FpstInst, u16VirtAddr, u32PacketAddress ); /*forward walk => newest copy wins*/
+        #endif
+    }
+
+    #if ( EEPROM_LAZY_FREE_ENABLE == 0U )
+        /*a write frees the previous copy right after programming the new one, so only the last
+         * written variable can still have an older copy*/
+        if( ( u32LastValidAddress != 0U ) && ( u32EEPROM_iPrevPacketAddress( FpstInst, u32LastValidAddress ) != 0U ) )
+        {
+            if( Du8EEPROM_eSUCCESS != u8EEPROM_freeVar( FpstInst, ( uint16_t ) ( *( ( uint64_t * ) u32LastValidAddress ) >> 48 ),
+                                                       u32EEPROM_iPrevPacketAddress( FpstInst, u32LastValidAddress ) ) )
+            {
+                u8FnRet = Du8EEPROM_eERROR;
+            }
+        }
+    #else
+        ( void ) u32LastValidAddress;
+    #endif
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Get the address of the packet written before a packet (pages are chained from the oldest to the active one)
+ * @param FpstInst Instance
+ * @param Fu32PacketAddress Address of a packet
+ * @return Address of the previous packet, 0 if Fu32PacketAddress is the first packet of the oldest page
+ */
+static uint32_t u32EEPROM_iPrevPacketAddress( Tst_EepromInstance * FpstInst,
+                                              uint32_t Fu32PacketAddress )
+{
+    uint8_t u8PageId = ADDRESS_PAGE( FpstInst, Fu32PacketAddress );
+
+    if( Fu32PacketAddress > PAGE_BODY_ADDRESS( FpstInst, u8PageId ) )
+    {
+        return Fu32PacketAddress - PACKET_SIZE;
+    }
+
+    if( u8PageId == FpstInst->u8OldestPage )
+    {
+        return 0U;
+    }
+
+    return PAGE_END_ADDRESS( FpstInst, PREV_PAGE( u8PageId ) ) - PACKET_SIZE;
+}
+
+
+/**
+ * @brief Get the address of the packet written after a packet (pages are chained from the oldest to the active one)
+ * @param FpstInst Instance
+ * @param Fu32PacketAddress Address of a packet
+ * @return Address of the next packet, 0 if Fu32PacketAddress is the last packet of the active page
+ */
+static uint32_t u32EEPROM_iNextPacketAddress( Tst_EepromInstance * FpstInst,
+                                              uint32_t Fu32PacketAddress )
+{
+    uint8_t u8PageId = ADDRESS_PAGE( FpstInst, Fu32PacketAddress );
+
+    if( ( Fu32PacketAddress + PACKET_SIZE ) < PAGE_END_ADDRESS( FpstInst, u8PageId ) )
+    {
+        return Fu32PacketAddress + PACKET_SIZE;
+    }
+
+    if( u8PageId == FpstInst->u8ActivePage )
+    {
+        return 0U;
+    }
+
+    return PAGE_BODY_ADDRESS( FpstInst, NEXT_PAGE( u8PageId ) );
+}
+
+
+/**
+ * @brief Get the address of the last written packet
+ * @param FpstInst Instance
+ * @return Address of the newest packet, 0 if nothing was written yet
+ */
+static uint32_t u32EEPROM_iLastPacketAddress( Tst_EepromInstance * FpstInst )
+{
+    if( FpstInst->u32NextWriteAddress == NO_EMPTY_WRITE_SPACE_FOUND )
+    {
+        return PAGE_END_ADDRESS( FpstInst, FpstInst->u8ActivePage ) - PACKET_SIZE;
+    }
+
+    return u32EEPROM_iPrevPacketAddress( FpstInst, FpstInst->u32NextWriteAddress );
+}
+
+
+/**
+ * @brief Find the next write address in a page of the EEPROM
+ * @note pages are append-only, so the empty packets are a suffix of the page body: the first empty packet
+ *       is found by binary search, then EEPROM_WRITE_POINTER_CHECK_WINDOW packets after it are checked
+ *       to step over holes left by torn or stray writes
+ * @param FpstInst Instance
+ * @param Fu8PageId: Page ID of the EEPROM page
+ * @return Address of the first packet after the written area, NO_EMPTY_WRITE_SPACE_FOUND if the page is full
+ */
+static uint32_t u32EEPROM_iFindNextWriteAddress( Tst_EepromInstance * FpstInst,
+                                                 uint8_t Fu8PageId )
+{
+    uint64_t * pu64PageBody = ( uint64_t * ) PAGE_BODY_ADDRESS( FpstInst, Fu8PageId );
+    uint32_t u32Low = 0U;
+    uint32_t u32High = PAGE_PACKETS( FpstInst );
+    uint32_t u32Middle;
+    uint32_t u32Window;
+
+    if( Fu8PageId > MAX_PAGE_ID )
+    {
+        return NO_EMPTY_WRITE_SPACE_FOUND;
+    }
+
+    while( u32Low < PAGE_PACKETS( FpstInst ) )
+    {
+        /*first empty packet in [u32Low, u32High)*/
+        while( u32Low < u32High )
+        {
+            u32Middle = ( u32Low + u32High ) / 2U;
+
+            if( pu64PageBody[ u32Middle ] == EMPTY_PACKET )
+            {
+                u32High = u32Middle;
+            }
+            else
+            {
+                u32Low = u32Middle + 1U;
+            }
+        }
+
+        /*verification window*/
+        for( u32Window = 1U; u32Window <= EEPROM_WRITE_POINTER_CHECK_WINDOW; u32Window++ )
+        {
+            if( ( ( u32Low + u32Window ) < PAGE_PACKETS( FpstInst ) ) && ( pu64PageBody[ u32Low + u32Window ] != EMPTY_PACKET ) )
+            {
+                break;
+            }
+        }
+
+        if( u32Window > EEPROM_WRITE_POINTER_CHECK_WINDOW )
+        {
+            break;
+        }
+
+        /*hole: written data continues after it*/
+        u32Low += u32Window + 1U;
+        u32High = PAGE_PACKETS( FpstInst );
+    }
+
+    if( u32Low >= PAGE_PACKETS( FpstInst ) )
+    {
+        return NO_EMPTY_WRITE_SPACE_FOUND;
+    }
+
+    return( uint32_t ) &pu64PageBody[ u32Low ];
+}
+
+/**
+ * @brief Check if the EEPROM is erased
+ * @param FpstInst Instance
+ * @return TRUE if all EEPROM pages are erased, FALSE otherwise
+ */
+BOOL bEEPROM_eInstIsEepromErased( Tst_EepromInstance * FpstInst )
+{
+    uint8_t u8PageId;
+    BOOL bErased = TRUE;
+
+    if( FALSE == bEEPROM_iIsGeometryValid( FpstInst ) )
+    {
+        return FALSE;
+    }
+
+    EEPROM_WRITER_LOCK( FpstInst );
+    vEEPROM_iSetState( FpstInst );
+
+    ( void ) u8EEPROM_iEraseComplete( FpstInst, TRUE );
+
+    for( u8PageId = 0U; ( u8PageId < NB_EEPROM_PAGES ) && ( bErased == TRUE ); u8PageId++ )
+    {
+        bErased = bEEPROM_isPageErased( FpstInst, u8PageId );
+    }
+
+    EEPROM_WRITER_UNLOCK( FpstInst );
+
+    return bErased;
+}
+
+
+/**
+ * @brief Check if a page in the EEPROM is erased
+ * @note every packet is checked: an erase cut by a power loss or a stray write can leave data anywhere in
+ *       the body, where the binary search of the write pointer does not look. skipping an erase on such
+ *       a page would program over cells that are not erased
+ * @param FpstInst Instance
+ * @param Fu8PageId: Page ID of the EEPROM page to be checked
+ * @return TRUE if the page is erased (all packets are empty), FALSE otherwise
+ */
+BOOL bEEPROM_isPageErased( Tst_EepromInstance * FpstInst,
+                           const uint8_t Fu8PageId )
+{
+    uint32_t u32Address;
+
+    if( Fu8PageId > MAX_PAGE_ID )
+    {
+        return FALSE;
+    }
+
+    for( u32Address = PAGE_BODY_ADDRESS( FpstInst, Fu8PageId ); u32Address < PAGE_END_ADDRESS( FpstInst, Fu8PageId ); u32Address += PACKET_SIZE )
+    {
+        if( *( ( uint64_t * ) u32Address ) != EMPTY_PACKET )
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+
+/**
+ * @brief Check every word of a page: status erased and body empty (the erase count is kept)
+ * @param FpstInst Instance
+ * @param Fu8PageId: Page ID of the EEPROM page to be checked
+ * @return TRUE if the page does not need an erase, FALSE otherwise
+ */
+static BOOL bEEPROM_iIsPageBlank( Tst_EepromInstance * FpstInst,
+                                  uint8_t Fu8PageId )
+{
+    uint32_t u32Offset;
+
+    /*the whole status unit: a program of it cut by a power loss can leave its upper word cleared*/
+    for( u32Offset = 0U; u32Offset < PAGE_STATUS_SIZE; u32Offset += 4U )
+    {
+        if( *( ( uint32_t * ) ( PAGE_HEADER_ADDRESS( FpstInst, Fu8PageId ) + u32Offset ) ) != PAGE_STATUS_ERASED )
+        {
+            return FALSE;
+        }
+    }
+
+    return bEEPROM_isPageErased( FpstInst, Fu8PageId );
+}
+
+
+/**
+ * @brief Write a variable to the EEPROM based on the virtual address
+ * @param FpstInst Instance
+ * @param Fu16VirtAddr Virtual address of the variable to write
+ * @param Fu32Data Data value to write
+ * @return Status code indicating the result of the write operation
+ */
+uint8_t u8EEPROM_eInstWriteVar( Tst_EepromInstance * FpstInst,
+                                uint16_t Fu16VirtAddr,
+                                uint32_t Fu32Data )
+{
+    uint8_t u8FnRet;
+
+    EEPROM_WRITER_LOCK( FpstInst );
+    u8FnRet = u8EEPROM_iWriteVar( FpstInst, Fu16VirtAddr, Fu32Data );
+    EEPROM_WRITER_UNLOCK( FpstInst );
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Write a variable, free its older copy (EEPROM_LAZY_FREE_ENABLE == 0) and switch page if needed
+ * @param FpstInst Instance
+ * @param Fu16VirtAddr Virtual address of the variable to write
+ * @param Fu32Data Data value to write
+ * @return Status code indicating the result of the write operation
+ */
+static uint8_t u8EEPROM_iWriteVar( Tst_EepromInstance * FpstInst,
+                                   uint16_t Fu16VirtAddr,
+                                   uint32_t Fu32Data )
+{
+    if( FpstInst->bInitDone == FALSE )
+    {
+        return Du8EEPROM_eERROR;
+    }
+
+    /*forbidden adresses*/
+    if( FALSE == IS_VIRTUAL_ADDRESS_VALID( Fu16VirtAddr ) )
+    {
+        return Du8EEPROM_eWRITE_ERROR;
+    }
+
+    EEPROM_STATS_WRITE_BEGIN();
+
+    if( Du8EEPROM_eSUCCESS != u8EEPROM_iProgramVar( FpstInst, Fu16VirtAddr, Fu32Data ) )
+    {
+        EEPROM_STATS_WRITE_END( FpstInst );
+        return Du8EEPROM_eWRITE_ERROR;
+    }
+
+    #if ( EEPROM_LAZY_FREE_ENABLE == 0U )
+        /*free already written variable if it exists*/
+
+        /*if power shut down here, it won't cause problems after next page transfer
+         * because ransfer happens from top to buttom (fismail)*/
+
+        ( void ) u8EEPROM_freeVar( FpstInst, Fu16VirtAddr, u32EEPROM_iPrevPacketAddress( FpstInst, u32EEPROM_iLastPacketAddress( FpstInst ) ) );
+    #endif
+
+    vEEPROM_iCheckPageSwitch( FpstInst );
+
+    EEPROM_STATS_WRITE_END( FpstInst );
+
+    return Du8EEPROM_eSUCCESS;
+}
+
+
+/**
+ * @brief Write several variables to the EEPROM at once
+ * @note when a virtual address appears more than once the last value is kept. space for the whole batch
+ *       is reserved first (at most one page switch), then the packets are programmed back to back and,
+ *       without EEPROM_LAZY_FREE_ENABLE, the older copies are freed in a single backward sweep.
+ *       u16CRC of the input packets is ignored. a batch larger than the free space of a fresh page is
+ *       written variable by variable
+ * @param FpstInst Instance
+ * @param Fpst Array of variables to write (u16VirtAddr, u32DataVal)
+ * @param Fu32NbVars Number of entries in Fpst
+ * @return Status code indicating the result of the write operation, nothing is written on Du8EEPROM_eBAD_PARAM
+ */
+uint8_t u8EEPROM_eInstWriteVars( Tst_EepromInstance * FpstInst,
+                                 const Tst_EppromPacket * Fpst,
+                                 uint32_t Fu32NbVars )
+{
+    uint8_t u8FnRet;
+
+    EEPROM_WRITER_LOCK( FpstInst );
+    u8FnRet = u8EEPROM_iWriteVars( FpstInst, Fpst, Fu32NbVars );
+    EEPROM_WRITER_UNLOCK( FpstInst );
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Write a batch of variables (see u8EEPROM_eWriteVars)
+ * @param FpstInst Instance
+ * @param Fpst Array of variables to write (u16VirtAddr, u32DataVal)
+ * @param Fu32NbVars Number of entries in Fpst
+ * @return Status code indicating the result of the write operation
+ */
+static uint8_t u8EEPROM_iWriteVars( Tst_EepromInstance * FpstInst,
+                                    const Tst_EppromPacket * Fpst,
+                                    uint32_t Fu32NbVars )
+{
+    uint32_t u32Index;
+    uint32_t u32Next;
+    uint32_t u32NbUnique = 0U;
+    uint8_t u8FnRet = Du8EEPROM_eSUCCESS;
+
+    #if ( EEPROM_LAZY_FREE_ENABLE == 0U )
+        uint32_t u32PacketAddress;
+        uint32_t u32NbFreed = 0U;
+        uint16_t u16VirtAddr;
+    #endif
+
+    if( FpstInst->bInitDone == FALSE )
+    {
+        return Du8EEPROM_eERROR;
+    }
+
+    if( ( Fpst == NULL ) && ( Fu32NbVars != 0U ) )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    for( u32Index = 0U; u32Index < Fu32NbVars; u32Index++ )
+    {
+        /*forbidden adresses*/
+        if( FALSE == IS_VIRTUAL_ADDRESS_VALID( Fpst[ u32Index ].u16VirtAddr ) )
+        {
+            return Du8EEPROM_eBAD_PARAM;
+        }
+
+        if( FALSE == bEEPROM_iIsLastInBatch( Fpst, Fu32NbVars, u32Index ) )
+        {
+            continue;
+        }
+
+        u32NbUnique++;
+    }
+
+    if( u32NbUnique == 0U )
+    {
+        return Du8EEPROM_eSUCCESS;
+    }
+
+    EEPROM_STATS_WRITE_BEGIN();
+
+    /*one unlock for the whole batch*/
+    FpstInst->pstFlash->pfSessionBegin();
+
+    /*reserve the space of the whole batch: finish the pending transfer or switch page now, not in the middle*/
+    if( Du8EEPROM_eSUCCESS != u8EEPROM_iReserve( FpstInst, u32NbUnique ) )
+    {
+        /*does not fit in one page*/
+        for( u32Index = 0U; u32Index < Fu32NbVars; u32Index++ )
+        {
+            if( TRUE == bEEPROM_iIsLastInBatch( Fpst, Fu32NbVars, u32Index ) )
+            {
+                u8FnRet |= u8EEPROM_iWriteVar( FpstInst, Fpst[ u32Index ].u16VirtAddr, Fpst[ u32Index ].u32DataVal );
+            }
+        }
+
+        FpstInst->pstFlash->pfSessionEnd();
+        EEPROM_STATS_WRITE_END( FpstInst );
+
+        return( ( u8FnRet == Du8EEPROM_eSUCCESS ) ? Du8EEPROM_eSUCCESS : Du8EEPROM_eWRITE_ERROR );
+    }
+
+    u32Next = FpstInst->u32NextWriteAddress;
+
+    for( u32Index = 0U; u32Index < Fu32NbVars; u32Index++ )
+    {
+        if( TRUE == bEEPROM_iIsLastInBatch( Fpst, Fu32NbVars, u32Index ) )
+        {
+            u8FnRet |= u8EEPROM_iProgramVar( FpstInst, Fpst[ u32Index ].u16VirtAddr, Fpst[ u32Index ].u32DataVal );
+        }
+    }
+
+    #if ( EEPROM_LAZY_FREE_ENABLE == 0U )
+        /*older copies are never superseded twice without being freed: every not freed packet
+         * of a batch variable before the batch is its previous copy*/
+        EEPROM_UPDATE_BEGIN( FpstInst );
+
+        for( u32PacketAddress = u32EEPROM_iPrevPacketAddress( FpstInst, u32Next );
+             ( u32PacketAddress != 0U ) && ( u32NbFreed < u32NbUnique );
+             u32PacketAddress = u32EEPROM_iPrevPacketAddress( FpstInst, u32PacketAddress ) )
+        {
+            if( ( FpstInst->eTransferState != EEPROM_TRANSFER_IDLE ) && ( ADDRESS_PAGE( FpstInst, u32PacketAddress ) == FpstInst->u8OldestPage ) )
+            {
+                break; /*the page being compacted: superseded packets are not copied and die with its erase*/
+            }
+
+            u16VirtAddr = ( uint16_t ) ( *( ( uint64_t * ) u32PacketAddress ) >> 48 );
+
+            if( FALSE == IS_VIRTUAL_ADDRESS_VALID( u16VirtAddr ) )
+            {
+                continue;
+            }
+
+            for( u32Index = 0U; u32Index < Fu32NbVars; u32Index++ )
+            {
+                if( Fpst[ u32Index ].u16VirtAddr == u16VirtAddr )
+                {
+                    ( void ) u8EEPROM_iWrite( FpstInst, u32PacketAddress, FREED_PACKET, PACKET_SIZE );
+                    u32NbFreed++;
+                    break;
+                }
+            }
+        }
+
+        EEPROM_UPDATE_END( FpstInst );
+    #else
+        ( void ) u32Next;
+    #endif
+
+    vEEPROM_iCheckPageSwitch( FpstInst );
+
+    FpstInst->pstFlash->pfSessionEnd();
+    EEPROM_STATS_WRITE_END( FpstInst );
+
+    return( ( u8FnRet == Du8EEPROM_eSUCCESS ) ? Du8EEPROM_eSUCCESS : Du8EEPROM_eWRITE_ERROR );
+}
+
+
+/**
+ * @brief Check that a batch entry is not overwritten by a later entry of the same batch
+ * @param Fpst Array of variables to write
+ * @param Fu32NbVars Number of entries in Fpst
+ * @param Fu32Index Entry to check
+ * @return TRUE if the entry must be written, FALSE otherwise
+ */
+static BOOL bEEPROM_iIsLastInBatch( const Tst_EppromPacket * Fpst,
+                                    uint32_t Fu32NbVars,
+                                    uint32_t Fu32Index )
+{
+    uint32_t u32Index;
+
+    for( u32Index = Fu32Index + 1U; u32Index < Fu32NbVars; u32Index++ )
+    {
+        if( Fpst[ u32Index ].u16VirtAddr == Fpst[ Fu32Index ].u16VirtAddr )
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+
+/**
+ * @brief Program a variable at the next write address (no free of its older copy, no page switch)
+ * @param FpstInst Instance
+ * @param Fu16VirtAddr Virtual address of the variable to write
+ * @param Fu32Data Data value to write
+ * @return Status code indicating the result of the write operation
+ */
+static uint8_t u8EEPROM_iProgramVar( Tst_EepromInstance * FpstInst,
+                                     uint16_t Fu16VirtAddr,
+                                     uint32_t Fu32Data )
+{
+    uint64_t u64Packet;
+
+    #if ( WRITE_CORRECTION_ENABLE )
+        uint8_t u8WrtiteRetries = 0U;
+        BOOL bWriteProblem = FALSE;
+    #endif
+    uint64_t u64PacketRead;
+    uint16_t u16packetCRC;
+
+    /*the pending transfer must end before its live packets no longer fit in the active page*/
+    if( ( FpstInst->eTransferState != EEPROM_TRANSFER_IDLE ) && ( u32EEPROM_iFreePackets( FpstInst ) <= ( FpstInst->u32TransferRemaining + 1U ) ) )
+    {
+        ( void ) u8EEPROM_iTransferStep( FpstInst, TRANSFER_STEP_UNLIMITED );
+    }
+
+    /*no write space left (a page switch failed)*/
+    if( u32EEPROM_iFreePackets( FpstInst ) == 0U )
+    {
+        return Du8EEPROM_eWRITE_ERROR;
+    }
+
+    u16packetCRC = u16EEPROM_iCalculateCRC( Fu16VirtAddr, Fu32Data );
+
+    u64Packet = ( ( uint64_t ) Fu16VirtAddr << 48 ) + ( ( uint64_t ) u16packetCRC << 32 ) + ( ( uint64_t ) Fu32Data );
+
+    if( Du8EEPROM_eSUCCESS != u8EEPROM_iWrite( FpstInst, FpstInst->u32NextWriteAddress, u64Packet, PACKET_SIZE ) )
+    {
+        return Du8EEPROM_eWRITE_ERROR;
+    }
+
+    /*by enabling WRITE_CORRECTION_ENABLE in the cfg file, the code below will detect if a writeVar operation
+     *  was not successful and will attempt to write it at the next empty 64* address.
+     * this feature was not fully tested (firas)*/
+    #if ( WRITE_CORRECTION_ENABLE ) /*partially tested*/
+        u64PacketRead = *( ( uint64_t * ) FpstInst->u32NextWriteAddress );
+
+        while( ( u64PacketRead != u64Packet ) && ( FpstInst->u32NextWriteAddress < PAGE_END_ADDRESS( FpstInst, FpstInst->u8ActivePage ) - PACKET_SIZE ) )
+        {
+            bWriteProblem = TRUE;
+            /*write error at address FpstInst->u32NextWriteAddress*/
+            /*flash cell wearing  (firas)*/
+            /*TODO : detect write error and write at another adress*/
+            ( void ) u8EEPROM_iWrite( FpstInst, FpstInst->u32NextWriteAddress, FREED_PACKET, PACKET_SIZE );
+            FpstInst->u32NextWriteAddress += PACKET_SIZE;
+            ( void ) u8EEPROM_iWrite( FpstInst, FpstInst->u32NextWriteAddress, u64Packet, PACKET_SIZE );
+            u64PacketRead = *( ( uint64_t * ) FpstInst->u32NextWriteAddress );
+            u8WrtiteRetries++;
+            EEPROM_STATS_ADD( FpstInst, u32WriteRetries, 1U );
+
+            if( ( u64PacketRead == u64Packet ) )
+            {
+                bWriteProblem = FALSE;
+            }
+
+            /*we try to write at next address*/
+        }
+
+        if( bWriteProblem )
+        {
+            return Du8EEPROM_eWRITE_ERROR;
+        }
+    #endif /* if ( WRITE_CORRECTION_ENABLE ) */
+
+    #if EEPROM_RAM_INDEX_ENABLE
+        vEEPROM_iIndexUpdate( FpstInst, Fu16VirtAddr, FpstInst->u32NextWriteAddress );
+    #endif
+
+    FpstInst->u32NextWriteAddress += PACKET_SIZE;
+
+    return Du8EEPROM_eSUCCESS;
+}
+
+
+/**
+ * @brief Open the next page once the active page is full, or early when a transfer can be spread over the next writes
+ * @param FpstInst Instance
+ */
+static void vEEPROM_iCheckPageSwitch( Tst_EepromInstance * FpstInst )
+{
+    if( FpstInst->u32NextWriteAddress >= PAGE_END_ADDRESS( FpstInst, FpstInst->u8ActivePage ) )
+    {
+        ( void ) u8EEPROM_iOpenNextPage( FpstInst );
+    }
+
+    #if EEPROM_INCREMENTAL_TRANSFER_ENABLE
+        else if( ( FpstInst->eTransferState == EEPROM_TRANSFER_IDLE ) &&
+                 ( NEXT_PAGE( NEXT_PAGE( FpstInst->u8ActivePage ) ) == FpstInst->u8OldestPage ) &&
+                 ( u32EEPROM_iFreePackets( FpstInst ) <= EEPROM_TRANSFER_START_THRESHOLD ) )
+        {
+            /*early switch: the transfer can be spread over the steps before the page is full*/
+            ( void ) u8EEPROM_iOpenNextPage( FpstInst );
+        }
+    #endif
+}
+
+/*TODO: (maybe) create a var struct that contains the amount of variable writes to know whether to free or not (firas)*/
+
+#if ( EEPROM_LAZY_FREE_ENABLE == 0U )
+
+/**
+ * @brief Free a variable in the EEPROM based on the virtual address and starting search address
+ * @param FpstInst Instance
+ * @param Fu16VirtAddr Virtual address of the variable to free
+ * @param Fu32StartSearchAddr Starting address to search for the variable (searched backward, through older pages)
+ * @return Status code indicating the result of the free operation
+ */
+uint8_t u8EEPROM_freeVar( Tst_EepromInstance * FpstInst,
+                          uint64_t Fu16VirtAddr,
+                          uint32_t Fu32StartSearchAddr )
+{
+    uint32_t u32PacketAddress;
+    uint8_t ret = Du8EEPROM_eSUCCESS;
+
+    #if EEPROM_STATS_ENABLE
+        uint32_t u32NbScanned = 0U;
+    #endif
+
+    if( FALSE == IS_ADDRESS_IN_EEPROM( FpstInst, Fu32StartSearchAddr ) )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    if( FALSE == IS_VIRTUAL_ADDRESS_VALID( Fu16VirtAddr ) )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    EEPROM_STATS_ADD( FpstInst, u32Frees, 1U );
+
+    for( u32PacketAddress = Fu32StartSearchAddr; u32PacketAddress != 0U; u32PacketAddress = u32EEPROM_iPrevPacketAddress( FpstInst, u32PacketAddress ) )
+    {
+        EEPROM_STATS_COUNT( u32NbScanned );
+
+        if( ( uint16_t ) ( *( ( uint64_t * ) u32PacketAddress ) >> 48 ) == Fu16VirtAddr )
+        {
+            /*mark packet as freed (pull value to 0 )*/
+            EEPROM_UPDATE_BEGIN( FpstInst );
+            ret |= u8EEPROM_iWrite( FpstInst, u32PacketAddress, FREED_PACKET, PACKET_SIZE );
+            EEPROM_UPDATE_END( FpstInst );
+
+            /*comment line below to loop through all eeprom pages to free a var => not optimal for simple write operations (firas)*/
+            break;
+        }
+    }
+
+    EEPROM_STATS_SCAN( FpstInst, u32FreeScannedPackets, u32MaxFreeScan, u32NbScanned );
+
+    return ret;
+}
+
+#endif /* if ( EEPROM_LAZY_FREE_ENABLE == 0U ) */
+
+
+/**
+ * @brief Check that no newer copy of a packet's variable was written after it
+ * @param FpstInst Instance
+ * @param Fu32PacketAddress Address of the packet to check
+ * @return TRUE if the packet holds the newest value of its variable, FALSE otherwise
+ */
+static BOOL bEEPROM_iIsNewestCopy( Tst_EepromInstance * FpstInst,
+                                   uint32_t Fu32PacketAddress )
+{
+    uint16_t u16VirtAddr = ( uint16_t ) ( *( ( uint64_t * ) Fu32PacketAddress ) >> 48 );
+    uint32_t u32PacketAddress;
+
+    #if EEPROM_RAM_INDEX_ENABLE
+        u32PacketAddress = u32EEPROM_iIndexLookup( FpstInst, u16VirtAddr );
+
+        if( u32PacketAddress != INDEX_ENTRY_NOT_FOUND )
+        {
+            return( ( u32PacketAddress == Fu32PacketAddress ) ? TRUE : FALSE );
+        }
+    #endif
+
+    /*not indexed: look for a newer copy up to the next write address*/
+    for( u32PacketAddress = u32EEPROM_iNextPacketAddress( FpstInst, Fu32PacketAddress );
+         ( u32PacketAddress != 0U ) && ( u32PacketAddress != FpstInst->u32NextWriteAddress );
+         u32PacketAddress = u32EEPROM_iNextPacketAddress( FpstInst, u32PacketAddress ) )
+    {
+        if( ( uint16_t ) ( *( ( uint64_t * ) u32PacketAddress ) >> 48 ) == u16VirtAddr )
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+
+/**
+ * @brief Read a variable from the EEPROM based on the virtual address
+ * @param FpstInst Instance
+ * @param Fu16VirtAddr Virtual address of the variable to read
+ * @param Fpu32Value Pointer to store the read value
+ * @return Status code indicating the result of the read operation
+ */
+uint8_t u8EEPROM_eInstReadVar( Tst_EepromInstance * FpstInst,
+                               uint16_t Fu16VirtAddr,
+                               uint32_t * Fpu32Value )
+{
+    #if EEPROM_THREAD_SAFE_ENABLE
+        uint32_t u32Sequence;
+        uint32_t u32Value = 0U;
+        uint32_t u32Attempt;
+        uint8_t u8FnRet;
+
+        /*lock-free: the result is kept only if no writer changed the pages or the index meanwhile*/
+        for( u32Attempt = 0U; u32Attempt < EEPROM_READ_RETRIES; u32Attempt++ )
+        {
+            u32Sequence = u32EEPROM_iReadBegin( FpstInst );
+            u8FnRet = u8EEPROM_iReadVar( FpstInst, Fu16VirtAddr, &u32Value );
+
+            if( FALSE == bEEPROM_iReadRetry( FpstInst, u32Sequence ) )
+            {
+                if( u8FnRet == Du8EEPROM_eSUCCESS )
+                {
+                    *Fpu32Value = u32Value;
+                }
+
+                return u8FnRet;
+            }
+        }
+
+        EEPROM_WRITER_LOCK( FpstInst );
+        u8FnRet = u8EEPROM_iReadVar( FpstInst, Fu16VirtAddr, Fpu32Value );
+        EEPROM_WRITER_UNLOCK( FpstInst );
+
+        return u8FnRet;
+    #else
+        return u8EEPROM_iReadVar( FpstInst, Fu16VirtAddr, Fpu32Value );
+    #endif
+}
+
+
+/**
+ * @brief Read the newest copy of a variable and check its CRC
+ * @param FpstInst Instance
+ * @param Fu16VirtAddr Virtual address of the variable to read
+ * @param Fpu32Value Pointer to store the read value
+ * @return Status code indicating the result of the read operation
+ */
+static uint8_t u8EEPROM_iReadVar( Tst_EepromInstance * FpstInst,
+                                  uint16_t Fu16VirtAddr,
+                                  uint32_t * Fpu32Value )
+{
+    uint32_t u32PacketAddress;
+    uint64_t u64Packet;
+
+    if( FpstInst->bInitDone == FALSE )
+    {
+        return Du8EEPROM_eERROR;
+    }
+
+    u32PacketAddress = u32EEPROM_iFindVar( FpstInst, Fu16VirtAddr );
+
+    if( u32PacketAddress == 0U )
+    {
+        /*Virt address not found*/
+        return Du8EEPROM_eREAD_ERROR;
+    }
+
+    u64Packet = *( ( uint64_t * ) u32PacketAddress );
+
+    if( TRUE == bEEPROM_iIsRecordHead( u64Packet ) )
+    {
+        /*a record is stored at this address, see u8EEPROM_eReadRecord*/
+        return Du8EEPROM_eREAD_ERROR;
+    }
+
+    if( ( uint16_t ) ( u64Packet >> 32 ) != u16EEPROM_iCalculateCRC( Fu16VirtAddr, ( uint32_t ) u64Packet ) ) /*is CRC correct*/
+    {
+        /*corrupted data*/
+        return Du8EEPROM_eDATA_CORRUPTED;
+    }
+
+    *Fpu32Value = u32EEPROM_iVarValue( FpstInst, u32PacketAddress ); /*base + tally of a counter*/
+
+    return Du8EEPROM_eSUCCESS;
+}
+
+
+/**
+ * @brief Write a record (blob, struct, string) of up to EEPROM_RECORD_MAX_SIZE bytes
+ * @note the payload slots are programmed first and the head last: a record torn by a power loss
+ *       has no head and is ignored, the previous value stays readable
+ * @param FpstInst Instance
+ * @param Fu16VirtAddr Virtual address of the record
+ * @param Fpu8Data Data to write
+ * @param Fu16Size Size of the data in bytes
+ * @return Status code indicating the result of the write operation
+ */
+uint8_t u8EEPROM_eInstWriteRecord( Tst_EepromInstance * FpstInst,
+                                   uint16_t Fu16VirtAddr,
+                                   const uint8_t * Fpu8Data,
+                                   uint16_t Fu16Size )
+{
+    uint8_t u8FnRet;
+
+    EEPROM_WRITER_LOCK( FpstInst );
+    u8FnRet = u8EEPROM_iWriteRecord( FpstInst, Fu16VirtAddr, Fpu8Data, Fu16Size );
+    EEPROM_WRITER_UNLOCK( FpstInst );
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Write a record: payload slots, then its head
+ * @param FpstInst Instance
+ * @param Fu16VirtAddr Virtual address of the record
+ * @param Fpu8Data Data to write
+ * @param Fu16Size Size of the data in bytes
+ * @return Status code indicating the result of the write operation
+ */
+static uint8_t u8EEPROM_iWriteRecord( Tst_EepromInstance * FpstInst,
+                                      uint16_t Fu16VirtAddr,
+                                      const uint8_t * Fpu8Data,
+                                      uint16_t Fu16Size )
+{
+    uint32_t u32NbSlots = RECORD_PAYLOAD_SLOTS( Fu16Size );
+    uint32_t u32Slot;
+    uint32_t u32Byte;
+    uint32_t u32HeadData;
+    uint64_t u64Packet;
+    uint64_t au64Slots[ RECORD_PAYLOAD_SLOTS( EEPROM_RECORD_MAX_SIZE ) + 1U ];
+    uint16_t u16RecordCRC = EEPROM_CRC_INIT;
+    uint8_t u8FnRet = Du8EEPROM_eSUCCESS;
+
+    if( FpstInst->bInitDone == FALSE )
+    {
+        return Du8EEPROM_eERROR;
+    }
+
+    if( ( FALSE == IS_VIRTUAL_ADDRESS_VALID( Fu16VirtAddr ) ) || ( Fu16Size > EEPROM_RECORD_MAX_SIZE ) ||
+        ( ( Fpu8Data == NULL ) && ( Fu16Size != 0U ) ) )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    EEPROM_STATS_WRITE_BEGIN();
+
+    if( Du8EEPROM_eSUCCESS != u8EEPROM_iReserve( FpstInst, u32NbSlots + 1U ) )
+    {
+        EEPROM_STATS_WRITE_END( FpstInst );
+        return Du8EEPROM_eWRITE_ERROR;
+    }
+
+    for( u32Slot = 0U; u32Slot < u32NbSlots; u32Slot++ )
+    {
+        u64Packet = ( uint64_t ) RECORD_SLOT_MARKER << 48;
+
+        for( u32Byte = 0U; ( u32Byte < RECORD_SLOT_PAYLOAD_SIZE ) && ( ( u32Slot * RECORD_SLOT_PAYLOAD_SIZE + u32Byte ) < Fu16Size ); u32Byte++ )
+        {
+            u64Packet |= ( uint64_t ) Fpu8Data[ u32Slot * RECORD_SLOT_PAYLOAD_SIZE + u32Byte ] << ( 8U * u32Byte );
+        }
+
+        u16RecordCRC = u16EEPROM_iSlotCRC( u16RecordCRC, u64Packet );
+        au64Slots[ u32Slot ] = u64Packet;
+    }
+
+    /*the payload is programmed as one burst*/
+    u8FnRet = u8EEPROM_iWriteBurst( FpstInst, FpstInst->u32NextWriteAddress, au64Slots, u32NbSlots );
+
+    for( u32Slot = 0U; u32Slot < u32NbSlots; u32Slot++ )
+    {
+        if( *( ( uint64_t * ) FpstInst->u32NextWriteAddress ) != au64Slots[ u32Slot ] )
+        {
+            u8FnRet = Du8EEPROM_eWRITE_ERROR;
+        }
+
+        FpstInst->u32NextWriteAddress += PACKET_SIZE;
+    }
+
+    if( u8FnRet != Du8EEPROM_eSUCCESS )
+    {
+        /*no head => the written slots are ignored*/
+        vEEPROM_iCheckPageSwitch( FpstInst );
+        EEPROM_STATS_WRITE_END( FpstInst );
+        return Du8EEPROM_eWRITE_ERROR;
+    }
+
+    u32HeadData = ( ( uint32_t ) Fu16Size << 16 ) | u16RecordCRC;
+    u64Packet = ( ( uint64_t ) Fu16VirtAddr << 48 ) |
+                ( ( uint64_t ) ( uint16_t ) ~u16EEPROM_iCalculateCRC( Fu16VirtAddr, u32HeadData ) << 32 ) |
+                u32HeadData;
+
+    u8FnRet = u8EEPROM_iWrite( FpstInst, FpstInst->u32NextWriteAddress, u64Packet, PACKET_SIZE );
+
+    if( ( u8FnRet != Du8EEPROM_eSUCCESS ) || ( *( ( uint64_t * ) FpstInst->u32NextWriteAddress ) != u64Packet ) )
+    {
+        ( void ) u8EEPROM_iWrite( FpstInst, FpstInst->u32NextWriteAddress, FREED_PACKET, PACKET_SIZE );
+        FpstInst->u32NextWriteAddress += PACKET_SIZE;
+        vEEPROM_iCheckPageSwitch( FpstInst );
+        EEPROM_STATS_WRITE_END( FpstInst );
+        return Du8EEPROM_eWRITE_ERROR;
+    }
+
+    #if EEPROM_RAM_INDEX_ENABLE
+        vEEPROM_iIndexUpdate( FpstInst, Fu16VirtAddr, FpstInst->u32NextWriteAddress );
+    #endif
+
+    #if ( EEPROM_LAZY_FREE_ENABLE == 0U )
+        ( void ) u8EEPROM_freeVar( FpstInst, Fu16VirtAddr, u32EEPROM_iPrevPacketAddress( FpstInst, FpstInst->u32NextWriteAddress - ( u32NbSlots * PACKET_SIZE ) ) );
+    #endif
+
+    FpstInst->u32NextWriteAddress += PACKET_SIZE;
+
+    vEEPROM_iCheckPageSwitch( FpstInst );
+
+    EEPROM_STATS_WRITE_END( FpstInst );
+
+    return Du8EEPROM_eSUCCESS;
+}
+
+
+#if EEPROM_COUNTER_ENABLE
+/**
+ * @brief Add 1 to a counter of an instance
+ * @note see u8EEPROM_eIncrementCounter
+ * @param FpstInst Instance
+ * @param Fu16VirtAddr Virtual address of the counter
+ * @param Fpu32Value Pointer to store the new value, may be NULL
+ * @return Status code indicating the result of the write operation
+ */
+uint8_t u8EEPROM_eInstIncrementCounter( Tst_EepromInstance * FpstInst,
+                                        uint16_t Fu16VirtAddr,
+                                        uint32_t * Fpu32Value )
+{
+    uint8_t u8FnRet;
+
+    EEPROM_WRITER_LOCK( FpstInst );
+    u8FnRet = u8EEPROM_iIncrementCounter( FpstInst, Fu16VirtAddr, Fpu32Value );
+    EEPROM_WRITER_UNLOCK( FpstInst );
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Add 1 to a counter: one more bit cleared in its tally, or a new tally and base packet when it has
+ *        no tally (first increment, set by u8EEPROM_eWriteVar, copied by a page transfer) or a full one
+ * @param FpstInst Instance
+ * @param Fu16VirtAddr Virtual address of the counter
+ * @param Fpu32Value Pointer to store the new value, may be NULL
+ * @return Status code indicating the result of the write operation
+ */
+static uint8_t u8EEPROM_iIncrementCounter( Tst_EepromInstance * FpstInst,
+                                           uint16_t Fu16VirtAddr,
+                                           uint32_t * Fpu32Value )
+{
+    uint32_t u32PacketAddress;
+    uint32_t u32TallyAddress = 0U;
+    uint32_t u32Tally = 0U;
+    uint32_t u32Value = 0U; /*never written: counts from 0*/
+    uint64_t u64Packet;
+    uint8_t u8FnRet;
+
+    if( FpstInst->bInitDone == FALSE )
+    {
+        return Du8EEPROM_eERROR;
+    }
+
+    if( FALSE == IS_VIRTUAL_ADDRESS_VALID( Fu16VirtAddr ) )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    u32PacketAddress = u32EEPROM_iFindVar( FpstInst, Fu16VirtAddr );
+
+    if( u32PacketAddress != 0U )
+    {
+        u64Packet = *( ( uint64_t * ) u32PacketAddress );
+
+        if( TRUE == bEEPROM_iIsRecordHead( u64Packet ) )
+        {
+            /*a record is stored at this address*/
+            return Du8EEPROM_eBAD_PARAM;
+        }
+
+        if( ( uint16_t ) ( u64Packet >> 32 ) != u16EEPROM_iCalculateCRC( Fu16VirtAddr, ( uint32_t ) u64Packet ) )
+        {
+            /*unknown base, the counter must be set again by u8EEPROM_eWriteVar*/
+            return Du8EEPROM_eDATA_CORRUPTED;
+        }
+
+        u32TallyAddress = u32EEPROM_iCounterTally( FpstInst, u32PacketAddress );
+        u32Value = u32EEPROM_iVarValue( FpstInst, u32PacketAddress );
+    }
+
+    EEPROM_STATS_WRITE_BEGIN();
+
+    u32Value++;
+
+    if( u32TallyAddress != 0U )
+    {
+        u32Tally = ( uint32_t ) *( ( uint64_t * ) u32TallyAddress );
+    }
+
+    /*in place: 1 -> 0 on the next bit of the tally, nothing appended*/
+    if( ( u32TallyAddress != 0U ) && ( u32EEPROM_iTallyCount( u32Tally ) < COUNTER_TALLY_BITS ) )
+    {
+        u32Tally &= ~( 1UL << u32EEPROM_iTallyCount( u32Tally ) );
+
+        /*the whole program unit: the marker half of the tally packet is programmed again unchanged*/
+        u64Packet = ( *( ( uint64_t * ) u32TallyAddress ) & 0xFFFFFFFF00000000U ) | u32Tally;
+
+        if( ( Du8EEPROM_eSUCCESS == u8EEPROM_iWrite( FpstInst, u32TallyAddress, u64Packet, MCU_FLASH_PROGRAM_UNIT ) ) &&
+            ( u32EEPROM_iVarValue( FpstInst, u32PacketAddress ) == u32Value ) )
+        {
+            EEPROM_STATS_ADD( FpstInst, u32CounterInPlace, 1U );
+            EEPROM_STATS_WRITE_END( FpstInst );
+
+            if( Fpu32Value != NULL )
+            {
+                *Fpu32Value = u32Value;
+            }
+
+            return Du8EEPROM_eSUCCESS;
+        }
+
+        /*the bit did not clear (or others did): the value moves to a new tally and base*/
+    }
+
+    if( Du8EEPROM_eSUCCESS != u8EEPROM_iReserve( FpstInst, 2U ) )
+    {
+        EEPROM_STATS_WRITE_END( FpstInst );
+        return Du8EEPROM_eWRITE_ERROR;
+    }
+
+    /*the tally first: a base torn by a power loss leaves an orphan tally, ignored*/
+    u64Packet = ( ( uint64_t ) COUNTER_TALLY_MARKER << 48 ) | ( ( uint64_t ) Fu16VirtAddr << 32 ) | 0xFFFFFFFFU;
+    u8FnRet = u8EEPROM_iWrite( FpstInst, FpstInst->u32NextWriteAddress, u64Packet, PACKET_SIZE );
+
+    if( ( u8FnRet != Du8EEPROM_eSUCCESS ) || ( *( ( uint64_t * ) FpstInst->u32NextWriteAddress ) != u64Packet ) )
+    {
+        /*no tally => the base below is a plain variable, the next increment appends a new pair*/
+        ( void ) u8EEPROM_iWrite( FpstInst, FpstInst->u32NextWriteAddress, FREED_PACKET, PACKET_SIZE );
+    }
+
+    FpstInst->u32NextWriteAddress += PACKET_SIZE;
+
+    /*the reserved room keeps the pending transfer out of the way: the base follows its tally*/
+    if( Du8EEPROM_eSUCCESS != u8EEPROM_iProgramVar( FpstInst, Fu16VirtAddr, u32Value ) )
+    {
+        vEEPROM_iCheckPageSwitch( FpstInst );
+        EEPROM_STATS_WRITE_END( FpstInst );
+        return Du8EEPROM_eWRITE_ERROR;
+    }
+
+    #if ( EEPROM_LAZY_FREE_ENABLE == 0U )
+        ( void ) u8EEPROM_freeVar( FpstInst, Fu16VirtAddr, u32EEPROM_iPrevPacketAddress( FpstInst, u32EEPROM_iLastPacketAddress( FpstInst ) ) );
+    #endif
+
+    vEEPROM_iCheckPageSwitch( FpstInst );
+
+    EEPROM_STATS_WRITE_END( FpstInst );
+
+    if( Fpu32Value != NULL )
+    {
+        *Fpu32Value = u32Value;
+    }
+
+    return Du8EEPROM_eSUCCESS;
+}
+#endif /* EEPROM_COUNTER_ENABLE */
+
+
+/**
+ * @brief Read a record written by u8EEPROM_eWriteRecord
+ * @param FpstInst Instance
+ * @param Fu16VirtAddr Virtual address of the record
+ * @param Fpu8Data Buffer to store the data
+ * @param Fu16MaxSize Size of the buffer in bytes
+ * @param Fpu16Size Pointer to store the size of the record (also set when the buffer is too small)
+ * @return Status code indicating the result of the read operation
+ */
+uint8_t u8EEPROM_eInstReadRecord( Tst_EepromInstance * FpstInst,
+                                  uint16_t Fu16VirtAddr,
+                                  uint8_t * Fpu8Data,
+                                  uint16_t Fu16MaxSize,
+                                  uint16_t * Fpu16Size )
+{
+    #if EEPROM_THREAD_SAFE_ENABLE
+        uint32_t u32Sequence;
+        uint32_t u32Attempt;
+        uint8_t u8FnRet;
+
+        /*lock-free: the data is copied again if a writer changed the pages or the index meanwhile*/
+        for( u32Attempt = 0U; u32Attempt < EEPROM_READ_RETRIES; u32Attempt++ )
+        {
+            u32Sequence = u32EEPROM_iReadBegin( FpstInst );
+            u8FnRet = u8EEPROM_iReadRecord( FpstInst, Fu16VirtAddr, Fpu8Data, Fu16MaxSize, Fpu16Size );
+
+            if( FALSE == bEEPROM_iReadRetry( FpstInst, u32Sequence ) )
+            {
+                return u8FnRet;
+            }
+        }
+
+        EEPROM_WRITER_LOCK( FpstInst );
+        u8FnRet = u8EEPROM_iReadRecord( FpstInst, Fu16VirtAddr, Fpu8Data, Fu16MaxSize, Fpu16Size );
+        EEPROM_WRITER_UNLOCK( FpstInst );
+
+        return u8FnRet;
+    #else
+        return u8EEPROM_iReadRecord( FpstInst, Fu16VirtAddr, Fpu8Data, Fu16MaxSize, Fpu16Size );
+    #endif
+}
+
+
+/**
+ * @brief Read a record and check its CRC
+ * @param FpstInst Instance
+ * @param Fu16VirtAddr Virtual address of the record
+ * @param Fpu8Data Buffer to store the data
+ * @param Fu16MaxSize Size of the buffer in bytes
+ * @param Fpu16Size Pointer to store the size of the record
+ * @return Status code indicating the result of the read operation
+ */
+static uint8_t u8EEPROM_iReadRecord( Tst_EepromInstance * FpstInst,
+                                     uint16_t Fu16VirtAddr,
+                                     uint8_t * Fpu8Data,
+                                     uint16_t Fu16MaxSize,
+                                     uint16_t * Fpu16Size )
+{
+    uint32_t u32HeadAddress;
+    uint32_t u32SlotAddress;
+    uint32_t u32NbSlots;
+    uint32_t u32Pos;
+    uint64_t u64Packet;
+    uint16_t u16Size;
+
+    if( FpstInst->bInitDone == FALSE )
+    {
+        return Du8EEPROM_eERROR;
+    }
+
+    if( ( Fpu16Size == NULL ) || ( ( Fpu8Data == NULL ) && ( Fu16MaxSize != 0U ) ) )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    u32HeadAddress = u32EEPROM_iFindVar( FpstInst, Fu16VirtAddr );
+
+    if( u32HeadAddress == 0U )
+    {
+        return Du8EEPROM_eREAD_ERROR;
+    }
+
+    u64Packet = *( ( uint64_t * ) u32HeadAddress );
+
+    if( FALSE == bEEPROM_iIsRecordHead( u64Packet ) )
+    {
+        /*a 32 bits variable or a corrupted head*/
+        return( ( FALSE == bEEPROM_iIsPacketValid( u64Packet ) ) ? Du8EEPROM_eDATA_CORRUPTED : Du8EEPROM_eREAD_ERROR );
+    }
+
+    u16Size = ( uint16_t ) ( u64Packet >> 16 );
+    u32NbSlots = RECORD_PAYLOAD_SLOTS( u16Size );
+    *Fpu16Size = u16Size;
+
+    if( u16Size > Fu16MaxSize )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    if( FALSE == bEEPROM_iIsRecordValid( FpstInst, u32HeadAddress ) )
+    {
+        return Du8EEPROM_eDATA_CORRUPTED;
+    }
+
+    u32SlotAddress = u32HeadAddress - ( u32NbSlots * PACKET_SIZE );
+
+    for( u32Pos = 0U; u32Pos < u16Size; u32Pos++ )
+    {
+        Fpu8Data[ u32Pos ] = *( ( uint8_t * ) ( u32SlotAddress + ( ( u32Pos / RECORD_SLOT_PAYLOAD_SIZE ) * PACKET_SIZE ) +
+                                                 ( u32Pos % RECORD_SLOT_PAYLOAD_SIZE ) ) );
+    }
+
+    return Du8EEPROM_eSUCCESS;
+}
+
+
+/**
+ * @brief Find the newest packet of a variable (or head of a record)
+ * @param FpstInst Instance
+ * @param Fu16VirtAddr Virtual address of the variable
+ * @return Address of the packet, 0 if the variable is not stored
+ */
+static uint32_t u32EEPROM_iFindVar( Tst_EepromInstance * FpstInst,
+                                    uint16_t Fu16VirtAddr )
+{
+    uint32_t u32PacketAddress;
+
+    #if EEPROM_STATS_ENABLE
+        uint32_t u32NbScanned = 0U;
+    #endif
+
+    EEPROM_STATS_ADD( FpstInst, u32Reads, 1U );
+
+    #if EEPROM_RAM_INDEX_ENABLE
+        u32PacketAddress = u32EEPROM_iIndexLookup( FpstInst, Fu16VirtAddr );
+
+        if( u32PacketAddress != INDEX_ENTRY_NOT_FOUND )
+        {
+            return u32PacketAddress;
+        }
+
+        if( FpstInst->bIndexOverflow == FALSE )
+        {
+            /*every stored variable is indexed => Virt address not found*/
+            return 0U;
+        }
+    #endif
+
+    /*newest to oldest packet*/
+    for( u32PacketAddress = u32EEPROM_iLastPacketAddress( FpstInst );
+         u32PacketAddress != 0U;
+         u32PacketAddress = u32EEPROM_iPrevPacketAddress( FpstInst, u32PacketAddress ) )
+    {
+        EEPROM_STATS_COUNT( u32NbScanned );
+
+        if( ( uint16_t ) ( *( ( uint64_t * ) u32PacketAddress ) >> 48 ) == Fu16VirtAddr ) /*addr found*/
+        {
+            EEPROM_STATS_SCAN( FpstInst, u32ReadScannedPackets, u32MaxReadScan, u32NbScanned );
+            return u32PacketAddress;
+        }
+    }
+
+    EEPROM_STATS_SCAN( FpstInst, u32ReadScannedPackets, u32MaxReadScan, u32NbScanned );
+
+    return 0U;
+}
+
+
+/**
+ * @brief Make room for packets that must be programmed back to back in the active page
+ * @note finishes the pending transfer and/or opens the next page (at most one page switch)
+ * @param FpstInst Instance
+ * @param Fu32NbPackets Number of packets
+ * @return Du8EEPROM_eSUCCESS if the packets fit in the active page, Du8EEPROM_eWRITE_ERROR otherwise
+ */
+static uint8_t u8EEPROM_iReserve( Tst_EepromInstance * FpstInst,
+                                  uint32_t Fu32NbPackets )
+{
+    if( ( FpstInst->eTransferState != EEPROM_TRANSFER_IDLE ) && ( u32EEPROM_iFreePackets( FpstInst ) <= ( FpstInst->u32TransferRemaining + Fu32NbPackets ) ) )
+    {
+        ( void ) u8EEPROM_iTransferStep( FpstInst, TRANSFER_STEP_UNLIMITED );
+    }
+
+    if( u32EEPROM_iFreePackets( FpstInst ) < Fu32NbPackets )
+    {
+        ( void ) u8EEPROM_iOpenNextPage( FpstInst );
+
+        if( ( FpstInst->eTransferState != EEPROM_TRANSFER_IDLE ) && ( u32EEPROM_iFreePackets( FpstInst ) <= ( FpstInst->u32TransferRemaining + Fu32NbPackets ) ) )
+        {
+            ( void ) u8EEPROM_iTransferStep( FpstInst, TRANSFER_STEP_UNLIMITED );
+        }
+    }
+
+    return( ( u32EEPROM_iFreePackets( FpstInst ) < Fu32NbPackets ) ? Du8EEPROM_eWRITE_ERROR : Du8EEPROM_eSUCCESS );
+}
+
+
+#if EEPROM_RAM_INDEX_ENABLE
+
+/**
+ * @brief Empty the RAM index
+ * @param FpstInst Instance
+ */
+static void vEEPROM_iIndexClear( Tst_EepromInstance * FpstInst )
+{
+    uint32_t u32Pos;
+
+    for( u32Pos = 0U; u32Pos < EEPROM_RAM_INDEX_SIZE; u32Pos++ )
+    {
+        FpstInst->astIndex[ u32Pos ].u16VirtAddr = 0U;
+    }
+
+    FpstInst->u16IndexCount = 0U;
+    FpstInst->bIndexOverflow = FALSE;
+}
+
+
+/**
+ * @brief Point the index entry of a variable to its newest packet
+ * @param FpstInst Instance
+ * @param Fu16VirtAddr Virtual address of the variable
+ * @param Fu32PacketAddress Flash address of the newest packet of the variable
+ */
+static void vEEPROM_iIndexUpdate( Tst_EepromInstance * FpstInst,
+                                  uint16_t Fu16VirtAddr,
+                                  uint32_t Fu32PacketAddress )
+{
+    uint32_t u32Pos = INDEX_HASH( Fu16VirtAddr );
+
+    EEPROM_UPDATE_BEGIN( FpstInst );
+
+    /*linear probing, stops at the variable entry or at the first unused entry*/
+    while( ( FpstInst->astIndex[ u32Pos ].u16VirtAddr != Fu16VirtAddr ) &&
+           ( FpstInst->astIndex[ u32Pos ].u16VirtAddr != 0U ) )
+    {
+        u32Pos = ( u32Pos + 1U ) & ( EEPROM_RAM_INDEX_SIZE - 1U );
+    }
+
+    if( FpstInst->astIndex[ u32Pos ].u16VirtAddr == 0U )
+    {
+        /*keep 1/4 of the table unused so probe sequences stay short*/
+        if( FpstInst->u16IndexCount >= ( ( EEPROM_RAM_INDEX_SIZE * 3U ) / 4U ) )
+        {
+            FpstInst->bIndexOverflow = TRUE;
+            EEPROM_UPDATE_END( FpstInst );
+            return;
+        }
+
+        FpstInst->astIndex[ u32Pos ].u16VirtAddr = Fu16VirtAddr;
+        FpstInst->u16IndexCount++;
+    }
+
+    FpstInst->astIndex[ u32Pos ].u16Slot = PACKET_SLOT( FpstInst, Fu32PacketAddress );
+
+    EEPROM_UPDATE_END( FpstInst );
+}
+
+
+/**
+ * @brief Remove the variables whose newest packet is in a page from the index (not copied by the transfer)
+ * @param FpstInst Instance
+ * @param Fu8PageId Page leaving the ring
+ */
+static void vEEPROM_iIndexDropPage( Tst_EepromInstance * FpstInst,
+                                    uint8_t Fu8PageId )
+{
+    uint32_t u32Pos = 0U;
+    uint32_t u32Hole;
+    uint32_t u32Next;
+    uint32_t u32Home;
+
+    while( u32Pos < EEPROM_RAM_INDEX_SIZE )
+    {
+        if( ( FpstInst->astIndex[ u32Pos ].u16VirtAddr == 0U ) ||
+            ( ADDRESS_PAGE( FpstInst, SLOT_ADDRESS( FpstInst, FpstInst->astIndex[ u32Pos ].u16Slot ) ) != Fu8PageId ) )
+        {
+            u32Pos++;
+            continue;
+        }
+
+        /*backward shift: the next entries of the probe sequence move into the hole when their home allows it,
+         * so lookups never stop early at an unused entry (the entry now at u32Pos is checked again)*/
+        u32Hole = u32Pos;
+        u32Next = ( u32Hole + 1U ) & ( EEPROM_RAM_INDEX_SIZE - 1U );
+
+        while( FpstInst->astIndex[ u32Next ].u16VirtAddr != 0U )
+        {
+            u32Home = INDEX_HASH( FpstInst->astIndex[ u32Next ].u16VirtAddr );
+
+            if( ( ( u32Next - u32Home ) & ( EEPROM_RAM_INDEX_SIZE - 1U ) ) >= ( ( u32Next - u32Hole ) & ( EEPROM_RAM_INDEX_SIZE - 1U ) ) )
+            {
+                FpstInst->astIndex[ u32Hole ] = FpstInst->astIndex[ u32Next ];
+                u32Hole = u32Next;
+            }
+
+            u32Next = ( u32Next + 1U ) & ( EEPROM_RAM_INDEX_SIZE - 1U );
+        }
+
+        FpstInst->astIndex[ u32Hole ].u16VirtAddr = 0U;
+        FpstInst->u16IndexCount--;
+    }
+}
+
+
+/**
+ * @brief Get the flash address of the newest packet of a variable from the index
+ * @param FpstInst Instance
+ * @param Fu16VirtAddr Virtual address of the variable
+ * @return Packet address, INDEX_ENTRY_NOT_FOUND if the variable is not indexed
+ */
+static uint32_t u32EEPROM_iIndexLookup( Tst_EepromInstance * FpstInst,
+                                        uint16_t Fu16VirtAddr )
+{
+    uint32_t u32Pos = INDEX_HASH( Fu16VirtAddr );
+
+    while( FpstInst->astIndex[ u32Pos ].u16VirtAddr != 0U )
+    {
+        if( FpstInst->astIndex[ u32Pos ].u16VirtAddr == Fu16VirtAddr )
+        {
+            return SLOT_ADDRESS( FpstInst, FpstInst->astIndex[ u32Pos ].u16Slot );
+        }
+
+        u32Pos = ( u32Pos + 1U ) & ( EEPROM_RAM_INDEX_SIZE - 1U );
+    }
+
+    return INDEX_ENTRY_NOT_FOUND;
+}
+
+#endif /* if EEPROM_RAM_INDEX_ENABLE */
+
+
+#if EEPROM_THREAD_SAFE_ENABLE
+
+/**
+ * @brief Open a window in which a writer changes the state the lock-free reads rely on
+ *        (active/oldest page, write address, RAM index, packets freed or erased), windows can be nested
+ * @param FpstInst Instance
+ */
+static void vEEPROM_iUpdateBegin( Tst_EepromInstance * FpstInst )
+{
+    if( FpstInst->u32UpdateDepth == 0U )
+    {
+        FpstInst->u32UpdateSequence++; /*odd*/
+        __sync_synchronize();
+    }
+
+    FpstInst->u32UpdateDepth++;
+}
+
+
+/**
+ * @brief Close the window opened by vEEPROM_iUpdateBegin
+ * @param FpstInst Instance
+ */
+static void vEEPROM_iUpdateEnd( Tst_EepromInstance * FpstInst )
+{
+    FpstInst->u32UpdateDepth--;
+
+    if( FpstInst->u32UpdateDepth == 0U )
+    {
+        __sync_synchronize();
+        FpstInst->u32UpdateSequence++; /*even*/
+    }
+}
+
+
+/**
+ * @brief Start a lock-free read
+ * @param FpstInst Instance
+ * @return Sequence to give to bEEPROM_iReadRetry at the end of the read
+ */
+static uint32_t u32EEPROM_iReadBegin( Tst_EepromInstance * FpstInst )
+{
+    uint32_t u32Sequence = FpstInst->u32UpdateSequence;
+
+    __sync_synchronize();
+
+    return u32Sequence;
+}
+
+
+/**
+ * @brief End a lock-free read
+ * @param FpstInst Instance
+ * @param Fu32Sequence Sequence returned by u32EEPROM_iReadBegin
+ * @return TRUE if a writer was in an update window during the read (its result must be dropped), FALSE otherwise
+ */
+static BOOL bEEPROM_iReadRetry( Tst_EepromInstance * FpstInst,
+                                uint32_t Fu32Sequence )
+{
+    __sync_synchronize();
+
+    return( ( ( Fu32Sequence & 1U ) != 0U ) || ( FpstInst->u32UpdateSequence != Fu32Sequence ) ) ? TRUE : FALSE;
+}
+
+#endif /* if EEPROM_THREAD_SAFE_ENABLE */
+
+
+/**
+ * @brief Calculate CRC for EEPROM data
+ * @param Fu16VirtAddr: Virtual address in the EEPROM
+ * @param Fu32Data: Data for which CRC needs to be calculated
+ * @return Calculated CRC value
+ */
+uint16_t u16EEPROM_iCalculateCRC( uint16_t Fu16VirtAddr,
+                                  uint32_t Fu32Data )
+{
+    /*engine selected by EEPROM_CRC_ENGINE (eeprom_crc.c)*/
+    return u16EEPROM_eCrcUpdate( EEPROM_CRC_INIT, Fu16VirtAddr, Fu32Data );
+}
+
+
+/**
+ * @brief Check if a packet is the head of a record (its CRC is complemented)
+ * @param Fu64Packet Packet to check
+ * @return TRUE if the packet is a record head, FALSE otherwise
+ */
+static BOOL bEEPROM_iIsRecordHead( uint64_t Fu64Packet )
+{
+    uint16_t u16VirtAddr = ( uint16_t ) ( Fu64Packet >> 48 );
+
+    return( ( IS_VIRTUAL_ADDRESS_VALID( u16VirtAddr ) &&
+              ( ( uint16_t ) ( Fu64Packet >> 32 ) == ( uint16_t ) ~u16EEPROM_iCalculateCRC( u16VirtAddr, ( uint32_t ) Fu64Packet ) ) ) ? TRUE : FALSE );
+}
+
+
+/**
+ * @brief Check the CRC of a variable packet or record head
+ * @param Fu64Packet Packet to check
+ * @return TRUE if the CRC is correct, FALSE otherwise
+ */
+static BOOL bEEPROM_iIsPacketValid( uint64_t Fu64Packet )
+{
+    if( ( uint16_t ) ( Fu64Packet >> 32 ) == u16EEPROM_iCalculateCRC( ( uint16_t ) ( Fu64Packet >> 48 ), ( uint32_t ) Fu64Packet ) )
+    {
+        return TRUE;
+    }
+
+    return bEEPROM_iIsRecordHead( Fu64Packet );
+}
+
+
+/**
+ * @brief Get the number of packets taken by a variable
+ * @param Fu64Packet Packet of the variable (head of a record)
+ * @return 1 for a 32 bits variable, 1 + payload slots for a record
+ */
+static uint32_t u32EEPROM_iPacketSlots( uint64_t Fu64Packet )
+{
+    if( FALSE == bEEPROM_iIsRecordHead( Fu64Packet ) )
+    {
+        return 1U;
+    }
+
+    return 1U + RECORD_PAYLOAD_SLOTS( ( uint16_t ) ( Fu64Packet >> 16 ) );
+}
+
+
+/**
+ * @brief Find the tally of a counter
+ * @param FpstInst Instance
+ * @param Fu32PacketAddress Address of a variable packet
+ * @return Address of its tally, just before it in the same page, 0 if the variable is not a counter
+ */
+static uint32_t u32EEPROM_iCounterTally( Tst_EepromInstance * FpstInst,
+                                         uint32_t Fu32PacketAddress )
+{
+    uint64_t u64Packet = *( ( uint64_t * ) Fu32PacketAddress );
+    uint64_t u64Tally;
+
+    if( ( Fu32PacketAddress == PAGE_BODY_ADDRESS( FpstInst, ADDRESS_PAGE( FpstInst, Fu32PacketAddress ) ) ) ||
+        ( TRUE == bEEPROM_iIsRecordHead( u64Packet ) ) )
+    {
+        return 0U;
+    }
+
+    u64Tally = *( ( uint64_t * ) ( Fu32PacketAddress - PACKET_SIZE ) );
+
+    return( ( ( ( uint16_t ) ( u64Tally >> 48 ) == COUNTER_TALLY_MARKER ) &&
+              ( ( uint16_t ) ( u64Tally >> 32 ) == ( uint16_t ) ( u64Packet >> 48 ) ) ) ? ( Fu32PacketAddress - PACKET_SIZE ) : 0U );
+}
+
+
+/**
+ * @brief Count the increments recorded in a tally
+ * @param Fu32Tally Tally bits
+ * @return Number of bits cleared from bit 0, COUNTER_TALLY_BITS when the tally is full
+ */
+static uint32_t u32EEPROM_iTallyCount( uint32_t Fu32Tally )
+{
+    uint32_t u32Count = 0U;
+
+    while( ( u32Count < COUNTER_TALLY_BITS ) && ( ( Fu32Tally & ( 1UL << u32Count ) ) == 0U ) )
+    {
+        u32Count++;
+    }
+
+    return u32Count;
+}
+
+
+/**
+ * @brief Get the value of a variable packet, the increments of its tally added for a counter
+ * @param FpstInst Instance
+ * @param Fu32PacketAddress Address of the variable packet (CRC checked by the caller)
+ * @return Value of the variable
+ */
+static uint32_t u32EEPROM_iVarValue( Tst_EepromInstance * FpstInst,
+                                     uint32_t Fu32PacketAddress )
+{
+    uint32_t u32Value = ( uint32_t ) *( ( uint64_t * ) Fu32PacketAddress );
+    uint32_t u32TallyAddress = u32EEPROM_iCounterTally( FpstInst, Fu32PacketAddress );
+
+    if( u32TallyAddress != 0U )
+    {
+        u32Value += u32EEPROM_iTallyCount( ( uint32_t ) *( ( uint64_t * ) u32TallyAddress ) );
+    }
+
+    return u32Value;
+}
+
+
+/**
+ * @brief Build the packet of a variable
+ * @param Fu16VirtAddr Virtual address of the variable
+ * @param Fu32Data Data value
+ * @return Packet: virtual address, CRC, data
+ */
+static uint64_t u64EEPROM_iMakePacket( uint16_t Fu16VirtAddr,
+                                       uint32_t Fu32Data )
+{
+    return( ( ( uint64_t ) Fu16VirtAddr << 48 ) | ( ( uint64_t ) u16EEPROM_iCalculateCRC( Fu16VirtAddr, Fu32Data ) << 32 ) | Fu32Data );
+}
+
+
+/**
+ * @brief Update the CRC of a record payload with a slot (48 bits after the marker)
+ * @param Fu16CRC CRC of the previous slots, EEPROM_CRC_INIT for the first one
+ * @param Fu64Slot Payload slot
+ * @return Updated CRC value
+ */
+static uint16_t u16EEPROM_iSlotCRC( uint16_t Fu16CRC,
+                                    uint64_t Fu64Slot )
+{
+    return u16EEPROM_eCrcUpdate( Fu16CRC, ( uint16_t ) ( Fu64Slot >> 32 ), ( uint32_t ) Fu64Slot );
+}
+
+
+/**
+ * @brief Check the payload of a record against the CRC of its head
+ * @param FpstInst Instance
+ * @param Fu32HeadAddress Address of the record head, the payload slots are just before it in the same page
+ * @return TRUE if the record is complete and its CRC is correct, FALSE otherwise
+ */
+static BOOL bEEPROM_iIsRecordValid( Tst_EepromInstance * FpstInst,
+                                    uint32_t Fu32HeadAddress )
+{
+    uint64_t u64Head = *( ( uint64_t * ) Fu32HeadAddress );
+    uint32_t u32NbSlots = u32EEPROM_iPacketSlots( u64Head ) - 1U;
+    uint32_t u32SlotAddress = Fu32HeadAddress - ( u32NbSlots * PACKET_SIZE );
+    uint16_t u16CRC = EEPROM_CRC_INIT;
+
+    if( ( FALSE == bEEPROM_iIsRecordHead( u64Head ) ) ||
+        ( ( u32NbSlots * PACKET_SIZE ) > ( Fu32HeadAddress - PAGE_BODY_ADDRESS( FpstInst, ADDRESS_PAGE( FpstInst, Fu32HeadAddress ) ) ) ) )
+    {
+        return FALSE;
+    }
+
+    for( ; u32SlotAddress < Fu32HeadAddress; u32SlotAddress += PACKET_SIZE )
+    {
+        if( ( uint16_t ) ( *( ( uint64_t * ) u32SlotAddress ) >> 48 ) != RECORD_SLOT_MARKER )
+        {
+            return FALSE;
+        }
+
+        u16CRC = u16EEPROM_iSlotCRC( u16CRC, *( ( uint64_t * ) u32SlotAddress ) );
+    }
+
+    return( ( u16CRC == ( uint16_t ) u64Head ) ? TRUE : FALSE );
+}
+
+
+/**
+ * @brief Write data to the EEPROM
+ * @param FpstInst Instance
+ * @param Fu32Address: Address in the EEPROM to write the data
+ * @param Fu64Data: Data to be written (up to 64 bits)
+ * @param fu8WriteSizeBytes: Size of the data to be written in bytes
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_iWrite( Tst_EepromInstance * FpstInst,
+                         uint32_t Fu32Address,
+                         uint64_t Fu64Data,
+                         uint8_t fu8WriteSizeBytes )
+{
+    uint8_t u8FnRet;
+    uint8_t u8Ret = Du8EEPROM_eSUCCESS;
+
+    if( FALSE == IS_ADDRESS_IN_EEPROM( FpstInst, Fu32Address ) )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    if( fu8WriteSizeBytes == 0U )
+    {
+        return Du8EEPROM_eBAD_PARAM; /*Size of the data null*/
+    }
+
+    if( ( Fu32Address % fu8WriteSizeBytes ) != 0U )
+    {
+        return Du8EEPROM_eBAD_PARAM; /*alignment error*/
+    }
+
+    /*the flash can't be programmed while a background erase runs*/
+    vEEPROM_iWaitFlashIdle( FpstInst );
+
+    u8FnRet = FpstInst->pstFlash->pfProgram( Fu32Address, Fu64Data, fu8WriteSizeBytes );
+    EEPROM_STATS_ADD( FpstInst, u32Programs, 1U );
+
+    if( u8FnRet != Du8EEPROM_eSUCCESS )
+    {
+        u8Ret = Du8EEPROM_eERROR;
+    }
+
+    return u8Ret;
+}
+
+
+
+/**
+ * @brief Write consecutive packets to the EEPROM in the native program unit of the flash
+ * @param FpstInst Instance
+ * @param Fu32Address: Address in the EEPROM of the first packet
+ * @param Fpu64Packets: Packets to be written
+ * @param Fu32NbPackets: Number of packets
+ * @return Status code indicating the result of the operation
+ */
+static uint8_t u8EEPROM_iWriteBurst( Tst_EepromInstance * FpstInst,
+                                     uint32_t Fu32Address,
+                                     const uint64_t * Fpu64Packets,
+                                     uint32_t Fu32NbPackets )
+{
+    if( Fu32NbPackets == 0U )
+    {
+        return Du8EEPROM_eSUCCESS;
+    }
+
+    if( ( FALSE == IS_ADDRESS_IN_EEPROM( FpstInst, Fu32Address ) ) ||
+        ( FALSE == IS_ADDRESS_IN_EEPROM( FpstInst, Fu32Address + ( ( Fu32NbPackets - 1U ) * PACKET_SIZE ) ) ) )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    if( ( Fu32Address % PACKET_SIZE ) != 0U )
+    {
+        return Du8EEPROM_eBAD_PARAM; /*alignment error*/
+    }
+
+    /*the flash can't be programmed while a background erase runs*/
+    vEEPROM_iWaitFlashIdle( FpstInst );
+
+    EEPROM_STATS_ADD( FpstInst, u32Programs, Fu32NbPackets );
+
+    if( 0U != FpstInst->pstFlash->pfProgramBurst( Fu32Address, Fpu64Packets, Fu32NbPackets ) )
+    {
+        return Du8EEPROM_eERROR;
+    }
+
+    return Du8EEPROM_eSUCCESS;
+}
+
+
+/**
+ * @brief Program the packets gathered by the page transfer at FpstInst->u32NextWriteAddress and read them back
+ * @note the RAM index is moved to the copies once they are programmed, a read never sees an index entry
+ *       pointing to a packet still in the RAM buffer. copies that don't read back are freed and the copy
+ *       of the oldest page starts again from its first packet
+ * @param FpstInst Instance
+ * @param Fpu64Packets: Gathered packets
+ * @param Fpu32NbPackets: Number of gathered packets, reset to 0
+ * @return Du8EEPROM_eWRITE_ERROR if a copy didn't read back, Du8EEPROM_eSUCCESS otherwise
+ */
+static uint8_t u8EEPROM_iFlushTransferBurst( Tst_EepromInstance * FpstInst,
+                                             const uint64_t * Fpu64Packets,
+                                             uint32_t * Fpu32NbPackets )
+{
+    uint32_t u32Pos;
+    uint32_t u32NbGood = 0U; /*packets read back before the first mismatch*/
+
+    ( void ) u8EEPROM_iWriteBurst( FpstInst, FpstInst->u32NextWriteAddress, Fpu64Packets, *Fpu32NbPackets );
+
+    while( ( u32NbGood < *Fpu32NbPackets ) &&
+           ( *( ( uint64_t * ) ( FpstInst->u32NextWriteAddress + ( u32NbGood * PACKET_SIZE ) ) ) == Fpu64Packets[ u32NbGood ] ) )
+    {
+        u32NbGood++;
+    }
+
+    if( u32NbGood < *Fpu32NbPackets )
+    {
+        /*the copies from the record of the bad packet on are freed: their source stays the newest copy*/
+        while( ( u32NbGood > 0U ) && ( ( uint16_t ) ( Fpu64Packets[ u32NbGood - 1U ] >> 48 ) == RECORD_SLOT_MARKER ) )
+        {
+            u32NbGood--;
+        }
+
+        for( u32Pos = u32NbGood; u32Pos < *Fpu32NbPackets; u32Pos++ )
+        {
+            ( void ) u8EEPROM_iWrite( FpstInst, FpstInst->u32NextWriteAddress + ( u32Pos * PACKET_SIZE ), FREED_PACKET, PACKET_SIZE );
+        }
+
+        EEPROM_STATS_ADD( FpstInst, u32TransferVerifyErrors, 1U );
+    }
+
+    #if EEPROM_RAM_INDEX_ENABLE
+        for( u32Pos = 0U; u32Pos < u32NbGood; u32Pos++ )
+        {
+            /*every gathered packet is a live variable or record head, except the payload slots*/
+            if( ( uint16_t ) ( Fpu64Packets[ u32Pos ] >> 48 ) != RECORD_SLOT_MARKER )
+            {
+                vEEPROM_iIndexUpdate( FpstInst, ( uint16_t ) ( Fpu64Packets[ u32Pos ] >> 48 ), FpstInst->u32NextWriteAddress + ( u32Pos * PACKET_SIZE ) );
+            }
+        }
+    #endif
+
+    EEPROM_STATS_ADD( FpstInst, u32TransferPackets, u32NbGood );
+
+    FpstInst->u32NextWriteAddress += *Fpu32NbPackets * PACKET_SIZE;
+
+    if( u32NbGood < *Fpu32NbPackets )
+    {
+        *Fpu32NbPackets = 0U;
+
+        /*copy the page again, the packets copied so far are superseded by their copy and are skipped*/
+        if( FpstInst->u8TransferRetries <= EEPROM_TRANSFER_VERIFY_RETRIES )
+        {
+            FpstInst->u8TransferRetries++;
+        }
+
+        FpstInst->u32TransferCursor = PAGE_BODY_ADDRESS( FpstInst, FpstInst->u8OldestPage );
+        vEEPROM_iTransferMarkLive( FpstInst );
+
+        return Du8EEPROM_eWRITE_ERROR;
+    }
+
+    *Fpu32NbPackets = 0U;
+
+    return Du8EEPROM_eSUCCESS;
+}
+
+
+/**
+ * @brief Read data from the EEPROM
+ * @param Fu32Address: Address in the EEPROM to read the data
+ * @return Read data from the EEPROM
+ */
+static uint32_t u32EEPROM_iRead( uint32_t Fu32Address )
+{
+    uint32_t u32Data = 0;
+
+    u32Data = *( ( uint32_t * ) Fu32Address );
+
+    return u32Data;
+}
+
+
+/*checks flash integrity (crc is correct for all stored values) after init*/
+
+/**
+ * @brief Check the data integrity of the EEPROM
+ * @param FpstInst Instance
+ * @return Status code indicating the result of the data integrity check
+ */
+uint8_t u8EEPROM_eInstCheckDataIntegrity( Tst_EepromInstance * FpstInst )
+{
+    uint8_t u8FnRet;
+
+    if( ( FpstInst->bInitDone == FALSE ) || ( FpstInst->u8ActivePage == 0xFFU ) )
+    {
+        return Du8EEPROM_eERROR;
+    }
+
+    /*the scan rebuilds the RAM index*/
+    EEPROM_WRITER_LOCK( FpstInst );
+    EEPROM_UPDATE_BEGIN( FpstInst );
+    u8FnRet = u8EEPROM_iScanPages( FpstInst, FALSE );
+    EEPROM_UPDATE_END( FpstInst );
+    EEPROM_WRITER_UNLOCK( FpstInst );
+
+    return u8FnRet;
+}
+
+
+/*
+ * loops through the pages holding data and reads all variables
+ */
+
+/**
+ * @brief Read all variables from the EEPROM and store them in the provided array
+ * @param FpstInst Instance
+ * @param Fu64arr Pointer to the array to store the read variables
+ * @param u32MaArrSize Maximum size of the array
+ * @param Fu32Size Pointer to a variable to store the actual size of the read variables
+ * @return Status code indicating the result of the read operation
+ */
+uint8_t u8EEPROM_eInstReadAllVar( Tst_EepromInstance * FpstInst,
+                                  Tst_EppromPacket * Fu64arr,
+                                  uint32_t u32MaArrSize,
+                                  uint32_t * Fu32Size )
+{
+    uint8_t u8FnRet;
+
+    /*walks all the pages: holds off the writers instead of retrying*/
+    EEPROM_WRITER_LOCK( FpstInst );
+    u8FnRet = u8EEPROM_iReadAllVar( FpstInst, Fu64arr, u32MaArrSize, Fu32Size );
+    EEPROM_WRITER_UNLOCK( FpstInst );
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Copy the newest value of each variable in an array, newest written first
+ * @param FpstInst Instance
+ * @param Fu64arr Pointer to the array to store the read variables
+ * @param u32MaArrSize Maximum size of the array
+ * @param Fu32Size Pointer to a variable to store the actual size of the read variables
+ * @return Status code indicating the result of the read operation
+ */
+static uint8_t u8EEPROM_iReadAllVar( Tst_EepromInstance * FpstInst,
+                                     Tst_EppromPacket * Fu64arr,
+                                     uint32_t u32MaArrSize,
+                                     uint32_t * Fu32Size )
+{
+    Tst_EepromArrayFill stFill;
+
+    uint8_t u8FnRet;
+
+
+    if( ( Fu64arr == NULL ) || ( Fu32Size == NULL ) )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    stFill.pstArr = Fu64arr;
+    stFill.u32MaxSize = u32MaArrSize;
+    stFill.u32Size = 0U;
+    stFill.bOverflow = FALSE;
+
+    u8FnRet = u8EEPROM_iForEachVar( FpstInst, bEEPROM_iArrayFillVisit, &stFill );
+
+    *Fu32Size = stFill.u32Size;
+
+    if( ( u8FnRet == Du8EEPROM_eSUCCESS ) && ( stFill.bOverflow == TRUE ) )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Append a variable to the array of u8EEPROM_iReadAllVar
+ * @param Fu16VirtAddr Virtual address of the variable
+ * @param Fu32Data Newest value of the variable
+ * @param FpvContext Array (Tst_EepromArrayFill)
+ * @return FALSE once the array is full
+ */
+static BOOL bEEPROM_iArrayFillVisit( uint16_t Fu16VirtAddr,
+                                     uint32_t Fu32Data,
+                                     void * FpvContext )
+{
+    Tst_EepromArrayFill * pstFill = ( Tst_EepromArrayFill * ) FpvContext;
+
+    if( pstFill->u32Size >= pstFill->u32MaxSize )
+    {
+        pstFill->bOverflow = TRUE;
+        return FALSE;
+    }
+
+    pstFill->pstArr[ pstFill->u32Size ].u16VirtAddr = Fu16VirtAddr;
+    pstFill->pstArr[ pstFill->u32Size ].u16CRC = u16EEPROM_iCalculateCRC( Fu16VirtAddr, Fu32Data );
+    pstFill->pstArr[ pstFill->u32Size ].u32DataVal = Fu32Data;
+    pstFill->u32Size++;
+
+    return TRUE;
+}
+
+
+/**
+ * @brief Visit the stored variables of an instance
+ * @param FpstInst Instance
+ * @param FpfVisit Visitor, returns FALSE to stop the walk
+ * @param FpvContext Passed to FpfVisit
+ * @return Status code indicating the result of the walk
+ */
+uint8_t u8EEPROM_eInstForEachVar( Tst_EepromInstance * FpstInst,
+                                  Tpf_EepromVarVisitor FpfVisit,
+                                  void * FpvContext )
+{
+    uint8_t u8FnRet;
+
+    EEPROM_WRITER_LOCK( FpstInst );
+    u8FnRet = u8EEPROM_iForEachVar( FpstInst, FpfVisit, FpvContext );
+    EEPROM_WRITER_UNLOCK( FpstInst );
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Walk the pages from the newest packet and visit the newest copy of each variable
+ * @note a packet is visited when no newer copy of its variable follows it (RAM index, or scan up to the
+ *       next write address without it), so superseded copies left by a failed free are skipped
+ * @param FpstInst Instance
+ * @param FpfVisit Visitor, returns FALSE to stop the walk
+ * @param FpvContext Passed to FpfVisit
+ * @return Status code indicating the result of the walk
+ */
+static uint8_t u8EEPROM_iForEachVar( Tst_EepromInstance * FpstInst,
+                                     Tpf_EepromVarVisitor FpfVisit,
+                                     void * FpvContext )
+{
+    uint32_t u32PacketAddress;
+
+    uint64_t u64Packet;
+
+    uint16_t u16VirtAddr;
+
+    uint8_t u8FnRet = Du8EEPROM_eSUCCESS;
+
+
+    if( ( FpstInst->bInitDone == FALSE ) || ( FpstInst->u8ActivePage == 0xFFU ) )
+    {
+        return Du8EEPROM_eERROR;
+    }
+
+    if( FpfVisit == NULL )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    for( u32PacketAddress = u32EEPROM_iLastPacketAddress( FpstInst );
+         u32PacketAddress != 0U;
+         u32PacketAddress = u32EEPROM_iPrevPacketAddress( FpstInst, u32PacketAddress ) )
+    {
+        u64Packet = *( ( uint64_t * ) u32PacketAddress );
+        u16VirtAddr = ( uint16_t ) ( u64Packet >> 48 );
+
+        /*freed, empty, record slot, counter tally or record head*/
+        if( ( FALSE == IS_VIRTUAL_ADDRESS_VALID( u16VirtAddr ) ) || ( TRUE == bEEPROM_iIsRecordHead( u64Packet ) ) ||
+            ( FALSE == bEEPROM_iIsNewestCopy( FpstInst, u32PacketAddress ) ) )
+        {
+            continue;
+        }
+
+        if( ( uint16_t ) ( u64Packet >> 32 ) != u16EEPROM_iCalculateCRC( u16VirtAddr, ( uint32_t ) u64Packet ) )
+        {
+            u8FnRet = Du8EEPROM_eDATA_CORRUPTED; /*what u8EEPROM_eReadVar returns for it*/
+            continue;
+        }
+
+        if( FALSE == FpfVisit( u16VirtAddr, u32EEPROM_iVarValue( FpstInst, u32PacketAddress ), FpvContext ) )
+        {
+            break;
+        }
+    }
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Load a range of variables of an instance in a table indexed by virtual address
+ * @param FpstInst Instance
+ * @param Fu16FirstVirtAddr Virtual address of the first entry of the table
+ * @param Fpst Table of Fu32NbVars entries
+ * @param Fu32NbVars Number of entries
+ * @param Fpu32NbStored Pointer to store the number of entries found in the EEPROM (can be NULL)
+ * @return Status code indicating the result of the read operation
+ */
+uint8_t u8EEPROM_eInstReadSnapshot( Tst_EepromInstance * FpstInst,
+                                    uint16_t Fu16FirstVirtAddr,
+                                    Tst_EppromPacket * Fpst,
+                                    uint32_t Fu32NbVars,
+                                    uint32_t * Fpu32NbStored )
+{
+    uint8_t u8FnRet;
+
+    EEPROM_WRITER_LOCK( FpstInst );
+    u8FnRet = u8EEPROM_iReadSnapshot( FpstInst, Fu16FirstVirtAddr, Fpst, Fu32NbVars, Fpu32NbStored );
+    EEPROM_WRITER_UNLOCK( FpstInst );
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Clear the table then fill it in one walk of the pages
+ * @param FpstInst Instance
+ * @param Fu16FirstVirtAddr Virtual address of the first entry of the table
+ * @param Fpst Table of Fu32NbVars entries
+ * @param Fu32NbVars Number of entries
+ * @param Fpu32NbStored Pointer to store the number of entries found in the EEPROM (can be NULL)
+ * @return Status code indicating the result of the read operation
+ */
+static uint8_t u8EEPROM_iReadSnapshot( Tst_EepromInstance * FpstInst,
+                                       uint16_t Fu16FirstVirtAddr,
+                                       Tst_EppromPacket * Fpst,
+                                       uint32_t Fu32NbVars,
+                                       uint32_t * Fpu32NbStored )
+{
+    Tst_EepromSnapshotFill stFill;
+
+    uint32_t u32Pos;
+
+    uint8_t u8FnRet;
+
+
+    if( ( Fpst == NULL ) || ( Fu32NbVars == 0U ) || ( FALSE == IS_VIRTUAL_ADDRESS_VALID( Fu16FirstVirtAddr ) ) ||
+        ( ( ( uint32_t ) Fu16FirstVirtAddr + Fu32NbVars ) > COUNTER_TALLY_MARKER ) ) /*last entry must be a valid address*/
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    for( u32Pos = 0U; u32Pos < Fu32NbVars; u32Pos++ )
+    {
+        Fpst[ u32Pos ].u16VirtAddr = 0U;
+        Fpst[ u32Pos ].u16CRC = 0U;
+        Fpst[ u32Pos ].u32DataVal = 0U;
+    }
+
+    stFill.pstTable = Fpst;
+    stFill.u16FirstVirtAddr = Fu16FirstVirtAddr;
+    stFill.u32NbVars = Fu32NbVars;
+    stFill.u32NbStored = 0U;
+
+    u8FnRet = u8EEPROM_iForEachVar( FpstInst, bEEPROM_iSnapshotVisit, &stFill );
+
+    if( Fpu32NbStored != NULL )
+    {
+        *Fpu32NbStored = stFill.u32NbStored;
+    }
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Store a variable in the table of u8EEPROM_iReadSnapshot if it is in its range
+ * @param Fu16VirtAddr Virtual address of the variable
+ * @param Fu32Data Newest value of the variable
+ * @param FpvContext Table (Tst_EepromSnapshotFill)
+ * @return FALSE once every entry of the table is filled
+ */
+static BOOL bEEPROM_iSnapshotVisit( uint16_t Fu16VirtAddr,
+                                    uint32_t Fu32Data,
+                                    void * FpvContext )
+{
+    Tst_EepromSnapshotFill * pstFill = ( Tst_EepromSnapshotFill * ) FpvContext;
+
+    uint32_t u32Pos = ( uint32_t ) Fu16VirtAddr - pstFill->u16FirstVirtAddr; /*wraps above the range when below it*/
+
+    if( u32Pos < pstFill->u32NbVars )
+    {
+        pstFill->pstTable[ u32Pos ].u16VirtAddr = Fu16VirtAddr;
+        pstFill->pstTable[ u32Pos ].u16CRC = u16EEPROM_iCalculateCRC( Fu16VirtAddr, Fu32Data );
+        pstFill->pstTable[ u32Pos ].u32DataVal = Fu32Data;
+        pstFill->u32NbStored++;
+    }
+
+    return( ( pstFill->u32NbStored < pstFill->u32NbVars ) ? TRUE : FALSE );
+}
+
+
+/**
+ * @brief Serialize the variables and records of an instance in an image
+ * @param FpstInst Instance
+ * @param Fpu8Image Buffer receiving the image
+ * @param Fu32MaxSize Size of the buffer
+ * @param Fpu32Size Pointer to store the size of the image
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eInstExportImage( Tst_EepromInstance * FpstInst,
+                                   uint8_t * Fpu8Image,
+                                   uint32_t Fu32MaxSize,
+                                   uint32_t * Fpu32Size )
+{
+    uint8_t u8FnRet;
+
+    EEPROM_WRITER_LOCK( FpstInst );
+    u8FnRet = u8EEPROM_iExportImage( FpstInst, Fpu8Image, Fu32MaxSize, Fpu32Size );
+    EEPROM_WRITER_UNLOCK( FpstInst );
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Walk the pages from the newest packet and append the newest copy of each variable and record to the image
+ * @note the image holds the packets of a compacted page: no superseded copy, no tally, no freed packet
+ * @param FpstInst Instance
+ * @param Fpu8Image Buffer receiving the image
+ * @param Fu32MaxSize Size of the buffer
+ * @param Fpu32Size Pointer to store the size of the image
+ * @return Status code indicating the result of the operation
+ */
+static uint8_t u8EEPROM_iExportImage( Tst_EepromInstance * FpstInst,
+                                      uint8_t * Fpu8Image,
+                                      uint32_t Fu32MaxSize,
+                                      uint32_t * Fpu32Size )
+{
+    uint32_t u32PacketAddress;
+    uint32_t u32SlotAddress;
+    uint32_t u32NbSlots;
+    uint32_t u32NbPackets = 0U;
+
+    uint64_t u64Packet;
+
+    uint16_t u16VirtAddr;
+
+    uint8_t u8FnRet = Du8EEPROM_eSUCCESS;
+
+
+    if( ( FpstInst->bInitDone == FALSE ) || ( FpstInst->u8ActivePage == 0xFFU ) )
+    {
+        return Du8EEPROM_eERROR;
+    }
+
+    if( ( Fpu8Image == NULL ) || ( Fpu32Size == NULL ) || ( Fu32MaxSize < EEPROM_IMAGE_HEADER_SIZE ) )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    *Fpu32Size = 0U;
+
+    for( u32PacketAddress = u32EEPROM_iLastPacketAddress( FpstInst );
+         u32PacketAddress != 0U;
+         u32PacketAddress = u32EEPROM_iPrevPacketAddress( FpstInst, u32PacketAddress ) )
+    {
+        u64Packet = *( ( uint64_t * ) u32PacketAddress );
+        u16VirtAddr = ( uint16_t ) ( u64Packet >> 48 );
+
+        /*freed, empty, record slot (exported with its head) or counter tally*/
+        if( ( FALSE == IS_VIRTUAL_ADDRESS_VALID( u16VirtAddr ) ) || ( FALSE == bEEPROM_iIsNewestCopy( FpstInst, u32PacketAddress ) ) )
+        {
+            continue;
+        }
+
+        if( TRUE == bEEPROM_iIsRecordHead( u64Packet ) )
+        {
+            if( FALSE == bEEPROM_iIsRecordValid( FpstInst, u32PacketAddress ) )
+            {
+                u8FnRet = Du8EEPROM_eDATA_CORRUPTED;
+                continue;
+            }
+
+            u32NbSlots = u32EEPROM_iPacketSlots( u64Packet );
+        }
+        else if( ( uint16_t ) ( u64Packet >> 32 ) != u16EEPROM_iCalculateCRC( u16VirtAddr, ( uint32_t ) u64Packet ) )
+        {
+            u8FnRet = Du8EEPROM_eDATA_CORRUPTED;
+            continue;
+        }
+        else
+        {
+            u32NbSlots = 1U;
+            u64Packet = u64EEPROM_iMakePacket( u16VirtAddr, u32EEPROM_iVarValue( FpstInst, u32PacketAddress ) ); /*a counter is exported as a plain variable*/
+        }
+
+        if( ( EEPROM_IMAGE_SIZE( u32NbPackets + u32NbSlots ) > Fu32MaxSize ) || ( ( u32NbPackets + u32NbSlots ) > PAGE_PACKETS( FpstInst ) ) )
+        {
+            return Du8EEPROM_eBAD_PARAM;
+        }
+
+        /*a record is exported in order: payload slots (just before its head), then the head*/
+        for( u32SlotAddress = u32PacketAddress - ( ( u32NbSlots - 1U ) * PACKET_SIZE ); u32SlotAddress < u32PacketAddress; u32SlotAddress += PACKET_SIZE )
+        {
+            vEEPROM_iImagePut( &Fpu8Image[ EEPROM_IMAGE_SIZE( u32NbPackets ) ], *( ( uint64_t * ) u32SlotAddress ), PACKET_SIZE );
+            u32NbPackets++;
+        }
+
+        vEEPROM_iImagePut( &Fpu8Image[ EEPROM_IMAGE_SIZE( u32NbPackets ) ], u64Packet, PACKET_SIZE );
+        u32NbPackets++;
+    }
+
+    vEEPROM_iImagePut( &Fpu8Image[ EEPROM_IMAGE_MAGIC_OFFSET ], EEPROM_IMAGE_MAGIC, 4U );
+    vEEPROM_iImagePut( &Fpu8Image[ EEPROM_IMAGE_VERSION_OFFSET ], EEPROM_IMAGE_VERSION, 2U );
+    vEEPROM_iImagePut( &Fpu8Image[ EEPROM_IMAGE_NB_PACKETS_OFFSET ], u32NbPackets, 2U );
+    vEEPROM_iImagePut( &Fpu8Image[ EEPROM_IMAGE_RESERVED_OFFSET ], 0xFFFFU, 2U );
+    vEEPROM_iImagePut( &Fpu8Image[ EEPROM_IMAGE_CHECKSUM_OFFSET ], u16EEPROM_iImageChecksum( Fpu8Image, u32NbPackets ), 2U );
+
+    *Fpu32Size = EEPROM_IMAGE_SIZE( u32NbPackets );
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Replace the content of an instance with an image
+ * @param FpstInst Instance
+ * @param Fpu8Image Image
+ * @param Fu32Size Size of the image
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eInstImportImage( Tst_EepromInstance * FpstInst,
+                                   const uint8_t * Fpu8Image,
+                                   uint32_t Fu32Size )
+{
+    uint8_t u8FnRet;
+
+    if( FALSE == bEEPROM_iIsGeometryValid( FpstInst ) )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    EEPROM_WRITER_LOCK( FpstInst );
+    vEEPROM_iSetState( FpstInst );
+    EEPROM_UPDATE_BEGIN( FpstInst );
+    u8FnRet = u8EEPROM_iImportImage( FpstInst, Fpu8Image, Fu32Size );
+    EEPROM_UPDATE_END( FpstInst );
+    EEPROM_WRITER_UNLOCK( FpstInst );
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Check the image, withdraw and erase the pages that are not blank, program the image in the body
+ *        of page 0 in bursts, read it back, then set the header of page 0 and mount it
+ * @param FpstInst Instance
+ * @param Fpu8Image Image
+ * @param Fu32Size Size of the image
+ * @return Status code indicating the result of the operation
+ */
+static uint8_t u8EEPROM_iImportImage( Tst_EepromInstance * FpstInst,
+                                      const uint8_t * Fpu8Image,
+                                      uint32_t Fu32Size )
+{
+    uint64_t au64Burst[ EEPROM_TRANSFER_BURST_PACKETS ];
+    uint32_t u32NbPackets;
+    uint32_t u32NbBurst;
+    uint32_t u32Pos;
+    uint32_t u32BurstPos;
+    uint32_t u32Address;
+    uint16_t u16VirtAddr;
+    uint32_t u32EraseCount;
+    uint32_t au32EraseCount[ NB_EEPROM_PAGES ];
+    BOOL abBlank[ NB_EEPROM_PAGES ];
+    uint8_t u8PageId;
+    uint8_t u8FnRet = Du8EEPROM_eSUCCESS;
+
+    if( ( Fpu8Image == NULL ) || ( Fu32Size < EEPROM_IMAGE_HEADER_SIZE ) )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    u32NbPackets = ( uint32_t ) u64EEPROM_iImageGet( &Fpu8Image[ EEPROM_IMAGE_NB_PACKETS_OFFSET ], 2U );
+
+    if( ( u64EEPROM_iImageGet( &Fpu8Image[ EEPROM_IMAGE_MAGIC_OFFSET ], 4U ) != EEPROM_IMAGE_MAGIC ) ||
+        ( u64EEPROM_iImageGet( &Fpu8Image[ EEPROM_IMAGE_VERSION_OFFSET ], 2U ) != EEPROM_IMAGE_VERSION ) ||
+        ( Fu32Size != EEPROM_IMAGE_SIZE( u32NbPackets ) ) || ( u32NbPackets > PAGE_PACKETS( FpstInst ) ) )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    if( u64EEPROM_iImageGet( &Fpu8Image[ EEPROM_IMAGE_CHECKSUM_OFFSET ], 2U ) != u16EEPROM_iImageChecksum( Fpu8Image, u32NbPackets ) )
+    {
+        return Du8EEPROM_eDATA_CORRUPTED;
+    }
+
+    /*only variables, records and their payload slots: a tally or a freed packet does not belong to an image*/
+    for( u32Pos = 0U; u32Pos < u32NbPackets; u32Pos++ )
+    {
+        u16VirtAddr = ( uint16_t ) u64EEPROM_iImageGet( &Fpu8Image[ EEPROM_IMAGE_SIZE( u32Pos ) + 6U ], 2U );
+
+        if( ( u16VirtAddr != RECORD_SLOT_MARKER ) &&
+            ( ( FALSE == IS_VIRTUAL_ADDRESS_VALID( u16VirtAddr ) ) ||
+              ( FALSE == bEEPROM_iIsPacketValid( u64EEPROM_iImageGet( &Fpu8Image[ EEPROM_IMAGE_SIZE( u32Pos ) ], PACKET_SIZE ) ) ) ) )
+        {
+            return Du8EEPROM_eBAD_PARAM;
+        }
+    }
+
+    /*the pages are rewritten: no read or write until the image is mounted*/
+    FpstInst->bInitDone = FALSE;
+    FpstInst->u8ActivePage = 0xFFU;
+
+    ( void ) u8EEPROM_iEraseComplete( FpstInst, TRUE );
+
+    FpstInst->pstFlash->pfSessionBegin();
+
+    /*blank check: new parts come erased, the erase is most of the time spent per unit*/
+    for( u8PageId = 0U; u8PageId < NB_EEPROM_PAGES; u8PageId++ )
+    {
+        abBlank[ u8PageId ] = bEEPROM_iIsPageBlank( FpstInst, u8PageId );
+        ( void ) u8EEPROM_eInstGetEraseCount( FpstInst, u8PageId, &au32EraseCount[ u8PageId ] );
+
+        if( ( au32EraseCount[ u8PageId ] == 0xFFFFFFFFU ) || ( au32EraseCount[ u8PageId ] == PAGE_ERASE_COUNT_IMPORT ) )
+        {
+            au32EraseCount[ u8PageId ] = 0U;
+        }
+    }
+
+    /*every page keeps its data until it is erased: a power loss between two erases would leave the old
+     * pages not erased yet, mounted as the whole content. they are withdrawn first (an all zeros word, also
+     * programmable on ECC flash), the next init formats*/
+    for( u8PageId = 0U; ( u8PageId < NB_EEPROM_PAGES ) && ( u8FnRet == Du8EEPROM_eSUCCESS ); u8PageId++ )
+    {
+        if( abBlank[ u8PageId ] == FALSE )
+        {
+            ( void ) u8EEPROM_iWrite( FpstInst, PAGE_HEADER_ADDRESS( FpstInst, u8PageId ) + PAGE_STATUS_SIZE, PAGE_ERASE_COUNT_IMPORT, PAGE_ERASE_COUNT_SIZE );
+            ( void ) u8EEPROM_eInstGetEraseCount( FpstInst, u8PageId, &u32EraseCount );
+            u8FnRet = ( u32EraseCount == PAGE_ERASE_COUNT_IMPORT ) ? Du8EEPROM_eSUCCESS : Du8EEPROM_eWRITE_ERROR;
+        }
+    }
+
+    for( u8PageId = 0U; ( u8PageId < NB_EEPROM_PAGES ) && ( u8FnRet == Du8EEPROM_eSUCCESS ); u8PageId++ )
+    {
+        if( abBlank[ u8PageId ] == FALSE )
+        {
+            u8FnRet = u8EEPROM_iEraseStart( FpstInst, u8PageId );
+
+            if( u8FnRet == Du8EEPROM_eSUCCESS )
+            {
+                FpstInst->u32ErasingPageCount = au32EraseCount[ u8PageId ] + 1U; /*not the withdrawn mark*/
+                u8FnRet = u8EEPROM_iEraseComplete( FpstInst, TRUE );
+            }
+        }
+    }
+
+    /*one sequential pass in the body of page 0, each burst read back*/
+    u32Address = PAGE_BODY_ADDRESS( FpstInst, PAGE_0 );
+
+    for( u32Pos = 0U; ( u32Pos < u32NbPackets ) && ( u8FnRet == Du8EEPROM_eSUCCESS ); u32Pos += u32NbBurst )
+    {
+        u32NbBurst = ( ( u32NbPackets - u32Pos ) < EEPROM_TRANSFER_BURST_PACKETS ) ? ( u32NbPackets - u32Pos ) : EEPROM_TRANSFER_BURST_PACKETS;
+
+        for( u32BurstPos = 0U; u32BurstPos < u32NbBurst; u32BurstPos++ )
+        {
+            au64Burst[ u32BurstPos ] = u64EEPROM_iImageGet( &Fpu8Image[ EEPROM_IMAGE_SIZE( u32Pos + u32BurstPos ) ], PACKET_SIZE );
+        }
+
+        ( void ) u8EEPROM_iWriteBurst( FpstInst, u32Address, au64Burst, u32NbBurst );
+
+        for( u32BurstPos = 0U; u32BurstPos < u32NbBurst; u32BurstPos++ )
+        {
+            if( *( ( uint64_t * ) u32Address ) != au64Burst[ u32BurstPos ] )
+            {
+                u8FnRet = Du8EEPROM_eWRITE_ERROR;
+            }
+
+            u32Address += PACKET_SIZE;
+        }
+    }
 
-        u32NextWriteAddress += PACKET_SIZE;
+    /*header last: until it is set, the next init formats the EEPROM instead of mounting a partial image*/
+    if( u8FnRet == Du8EEPROM_eSUCCESS )
+    {
+        u8FnRet = u8EEPROM_iSetPageStatus( FpstInst, PAGE_0, PAGE_STATUS_ACTIVE );
+    }
 
-        if( u32NextWriteAddress >= PAGE_END_ADDRESS( u8ActivePage ) )
-        {
-            ( void ) u8EEPROM_iPageTransfer( u8ActivePage, u8ActivePage ^ 1U );
-        }
+    FpstInst->pstFlash->pfSessionEnd();
 
-        return Du8EEPROM_eSUCCESS;
+    if( u8FnRet != Du8EEPROM_eSUCCESS )
+    {
+        return u8FnRet;
     }
 
-    return Du8EEPROM_eWRITE_ERROR;
+    return u8EEPROM_iInit( FpstInst );
 }
 
-/*TODO: (maybe) create a var struct that contains the amount of variable writes to know whether to free or not (firas)*/
 
 /**
- * @brief Free a variable in the EEPROM based on the virtual address and starting search address
- * @param Fu16VirtAddr Virtual address of the variable to free
- * @param Fu32StartSearchAddr Starting address to search for the variable
- * @return Status code indicating the result of the free operation
+ * @brief Write a value in an image, little endian
+ * @param Fpu8Dest First byte
+ * @param Fu64Value Value
+ * @param Fu32NbBytes Number of bytes
  */
-uint8_t u8EEPROM_freeVar( uint64_t Fu16VirtAddr,
-                          uint32_t Fu32StartSearchAddr )
+static void vEEPROM_iImagePut( uint8_t * Fpu8Dest,
+                               uint64_t Fu64Value,
+                               uint32_t Fu32NbBytes )
 {
-    uint64_t * u64PageCounter = ( uint64_t * ) Fu32StartSearchAddr;
-    uint32_t u32pageStartAddress = PAGE_HEADER_ADDRESS( u8ActivePage ) + PAGE_HEADER_SIZE;
-    BOOL bIsVarFound = FALSE;
-    uint8_t ret = Du8EEPROM_eSUCCESS;
-
-    if( FALSE == IS_ADDRESS_IN_EEPROM( Fu32StartSearchAddr ) )
-    {
-        return Du8EEPROM_eBAD_PARAM;
-    }
+    uint32_t u32Pos;
 
-    if( FALSE == IS_VIRTUAL_ADDRESS_VALID( Fu16VirtAddr ) )
+    for( u32Pos = 0U; u32Pos < Fu32NbBytes; u32Pos++ )
     {
-        return Du8EEPROM_eBAD_PARAM;
+        Fpu8Dest[ u32Pos ] = ( uint8_t ) ( Fu64Value >> ( 8U * u32Pos ) );
     }
+}
 
-    while( ( u64PageCounter >= ( uint64_t * ) u32pageStartAddress ) && ( FALSE == bIsVarFound ) )
-    {
-        if( ( uint16_t ) ( *( u64PageCounter ) >> 48 ) == Fu16VirtAddr )
-        {
-            /*mark packet as freed (pull value to 0 )*/
-            ret |= u8EEPROM_iWrite( ( uint32_t ) u64PageCounter, FREED_PACKET, PACKET_SIZE );
 
-            /*comment line below to loop through all eeprom page to free a var => not optimal for simple write operations (firas)*/
-            bIsVarFound = TRUE;
-        }
+/**
+ * @brief Read a value of an image, little endian
+ * @param Fpu8Src First byte
+ * @param Fu32NbBytes Number of bytes
+ * @return Value
+ */
+static uint64_t u64EEPROM_iImageGet( const uint8_t * Fpu8Src,
+                                     uint32_t Fu32NbBytes )
+{
+    uint64_t u64Value = 0U;
+    uint32_t u32Pos;
 
-        u64PageCounter--;
+    for( u32Pos = 0U; u32Pos < Fu32NbBytes; u32Pos++ )
+    {
+        u64Value |= ( uint64_t ) Fpu8Src[ u32Pos ] << ( 8U * u32Pos );
     }
 
-    return ret;
+    return u64Value;
 }
 
 
 /**
- * @brief Read a variable from the EEPROM based on the virtual address
- * @param Fu16VirtAddr Virtual address of the variable to read
- * @param Fpu32Value Pointer to store the read value
- * @return Status code indicating the result of the read operation
+ * @brief Checksum of an image: the packet checksum chained over the version, the number of packets, the reserved bytes and the
+ *        8 bytes of each packet (virtual address and the 4 next bytes, then the 2 last ones)
+ * @param Fpu8Image Image
+ * @param Fu32NbPackets Number of packets of the image
+ * @return Checksum
  */
-uint8_t u8EEPROM_eReadVar( uint16_t Fu16VirtAddr,
-                           uint32_t * Fpu32Value )
+static uint16_t u16EEPROM_iImageChecksum( const uint8_t * Fpu8Image,
+                                          uint32_t Fu32NbPackets )
 {
-    uint64_t * u64PageCounter;
-    uint32_t u32Data;
-    uint16_t u16CRC, u16VirtAddr;
+    uint16_t u16Checksum;
     uint64_t u64Packet;
+    uint32_t u32Pos;
+
+    u16Checksum = u16EEPROM_eCrcUpdate( EEPROM_CRC_INIT, ( uint16_t ) u64EEPROM_iImageGet( &Fpu8Image[ EEPROM_IMAGE_VERSION_OFFSET ], 2U ),
+                                        ( uint32_t ) u64EEPROM_iImageGet( &Fpu8Image[ EEPROM_IMAGE_NB_PACKETS_OFFSET ], 4U ) );
 
-    if( bEEPROM_iInitDone == FALSE )
+    for( u32Pos = 0U; u32Pos < Fu32NbPackets; u32Pos++ )
     {
-        return Du8EEPROM_eERROR;
+        u64Packet = u64EEPROM_iImageGet( &Fpu8Image[ EEPROM_IMAGE_SIZE( u32Pos ) ], PACKET_SIZE );
+        u16Checksum = u16EEPROM_eCrcUpdate( u16Checksum, ( uint16_t ) ( u64Packet >> 48 ), ( uint32_t ) ( u64Packet >> 16 ) );
+        u16Checksum = u16EEPROM_eCrcUpdate( u16Checksum, ( uint16_t ) u64Packet, 0U );
     }
 
-    uint32_t u32pageStartAdress = PAGE_HEADER_ADDRESS( u8ActivePage ) + PAGE_HEADER_SIZE;
+    return u16Checksum;
+}
 
-    u64PageCounter = ( uint64_t * ) ( u32NextWriteAddress - PACKET_SIZE );
 
-    while( u64PageCounter >= ( uint64_t * ) u32pageStartAdress )
-    {
-        u64Packet = *( u64PageCounter );
-        u16VirtAddr = ( uint16_t ) ( u64Packet >> 48 );
+/*single instance APIs -----------*/
 
-        if( u16VirtAddr == Fu16VirtAddr ) /*addr found*/
-        {
-            u16CRC = ( uint16_t ) ( u64Packet >> 32 );
-            u32Data = ( uint32_t ) ( u64Packet );
 
-            if( u16CRC == u16EEPROM_iCalculateCRC( u16VirtAddr, u32Data ) ) /*is CRC correct*/
-            {
-                *Fpu32Value = u32Data;
+/**
+ * @brief Initialize the EEPROM by checking the page headers and setting the active page and next write address
+ * @return Status code indicating the result of the initialization
+ */
+uint8_t u8EEPROM_eInit( void )
+{
+    return u8EEPROM_eInstInit( &stEEPROM_iDefault );
+}
 
-                return Du8EEPROM_eSUCCESS;
-            }
-            else
-            {
-                /*corrupted data*/
-                return Du8EEPROM_eDATA_CORRUPTED;
-            }
-        }
 
-        u64PageCounter--;
-    }
+/**
+ * @brief Format the EEPROM by erasing all pages and setting the active page
+ * @return Status code indicating the result of the formatting operation
+ */
+uint8_t u8EEPROM_eFormat( void )
+{
+    uint8_t u8FnRet;
+
+    EEPROM_WRITER_LOCK( &stEEPROM_iDefault );
+    u8FnRet = u8EEPROM_eInstFormat( &stEEPROM_iDefault );
+    EEPROM_CACHE_CLEAR();
+    EEPROM_WRITER_UNLOCK( &stEEPROM_iDefault );
 
-    /*Virt address not found*/
-    return Du8EEPROM_eREAD_ERROR;
+    return u8FnRet;
 }
 
 
 /**
- * @brief Calculate CRC for EEPROM data
- * @param Fu16VirtAddr: Virtual address in the EEPROM
- * @param Fu32Data: Data for which CRC needs to be calculated
- * @return Calculated CRC value
+ * @brief Write a variable to the EEPROM based on the virtual address
+ * @param Fu16VirtAddr Virtual address of the variable to write
+ * @param Fu32Data Data value to write
+ * @return Status code indicating the result of the write operation
  */
-uint16_t u16EEPROM_iCalculateCRC( uint16_t Fu16VirtAddr,
-                                  uint32_t Fu32Data )
+uint8_t u8EEPROM_eWriteVar( uint16_t Fu16VirtAddr,
+                            uint32_t Fu32Data )
 {
-    /*proposed method to calculate CRC of u32 Data and u16 address :
-     * decompose u32 data into 2 u16
-     * sum with u16 address
-     * CRC = u16Addr + u160Data + u161Data;
-     */
-    uint32_t u32Sum = 0;
-    uint16_t u16CRC = 0;
-
-    u32Sum = Fu16VirtAddr + ( Fu32Data & 0xFFFFU ) + ( ( Fu32Data >> 16 ) & 0xFFFFU );
+    uint8_t u8FnRet;
 
-    u16CRC = ( u32Sum & 0xFFFFU );
+    EEPROM_WRITER_LOCK( &stEEPROM_iDefault );
+    u8FnRet = u8EEPROM_eInstWriteVar( &stEEPROM_iDefault, Fu16VirtAddr, Fu32Data );
+    EEPROM_CACHE_INVALIDATE( Fu16VirtAddr );
+    EEPROM_WRITER_UNLOCK( &stEEPROM_iDefault );
 
-    return u16CRC;
+    return u8FnRet;
 }
 
 
 /**
- * @brief Write data to the EEPROM
- * @param Fu32Address: Address in the EEPROM to write the data
- * @param Fu64Data: Data to be written (up to 64 bits)
- * @param fu8WriteSizeBytes: Size of the data to be written in bytes
- * @return Status code indicating the result of the operation
+ * @brief Write several variables to the EEPROM at once
+ * @param Fpst Array of variables to write (u16VirtAddr, u32DataVal)
+ * @param Fu32NbVars Number of entries in Fpst
+ * @return Status code indicating the result of the write operation
  */
-uint8_t u8EEPROM_iWrite( uint32_t Fu32Address,
-                         uint64_t Fu64Data,
-                         uint8_t fu8WriteSizeBytes )
+uint8_t u8EEPROM_eWriteVars( const Tst_EppromPacket * Fpst,
+                             uint32_t Fu32NbVars )
 {
+    uint32_t u32Pos;
     uint8_t u8FnRet;
-    uint8_t u8Ret = Du8EEPROM_eSUCCESS;
-
-    if( FALSE == IS_ADDRESS_IN_EEPROM( Fu32Address ) )
-    {
-        return Du8EEPROM_eBAD_PARAM;
-    }
 
-    if( fu8WriteSizeBytes == 0U )
-    {
-        return Du8EEPROM_eBAD_PARAM; /*Size of the data null*/
-    }
+    EEPROM_WRITER_LOCK( &stEEPROM_iDefault );
+    u8FnRet = u8EEPROM_eInstWriteVars( &stEEPROM_iDefault, Fpst, Fu32NbVars );
 
-    if( ( Fu32Address % fu8WriteSizeBytes ) != 0U )
+    for( u32Pos = 0U; ( Fpst != NULL ) && ( u32Pos < Fu32NbVars ); u32Pos++ )
     {
-        return Du8EEPROM_eBAD_PARAM; /*alignment error*/
+        EEPROM_CACHE_INVALIDATE( Fpst[ u32Pos ].u16VirtAddr );
     }
 
-    u8FnRet = u8FLASH_ITF_FlashProgram( Fu32Address, Fu64Data, fu8WriteSizeBytes );
-
-    if( u8FnRet != Du8EEPROM_eSUCCESS )
-    {
-        u8Ret = Du8EEPROM_eERROR;
-    }
+    EEPROM_WRITER_UNLOCK( &stEEPROM_iDefault );
 
-    return u8Ret;
+    return u8FnRet;
 }
 
 
-
 /**
- * @brief Read data from the EEPROM
- * @param Fu32Address: Address in the EEPROM to read the data
- * @return Read data from the EEPROM
+ * @brief Write a record (blob, struct, string) of up to EEPROM_RECORD_MAX_SIZE bytes
+ * @param Fu16VirtAddr Virtual address of the record
+ * @param Fpu8Data Data to write
+ * @param Fu16Size Size of the data in bytes
+ * @return Status code indicating the result of the write operation
  */
-static uint32_t u32EEPROM_iRead( uint32_t Fu32Address )
+uint8_t u8EEPROM_eWriteRecord( uint16_t Fu16VirtAddr,
+                               const uint8_t * Fpu8Data,
+                               uint16_t Fu16Size )
 {
-    uint32_t u32Data = 0;
+    uint8_t u8FnRet;
 
-    u32Data = *( ( uint32_t * ) Fu32Address );
+    EEPROM_WRITER_LOCK( &stEEPROM_iDefault );
+    u8FnRet = u8EEPROM_eInstWriteRecord( &stEEPROM_iDefault, Fu16VirtAddr, Fpu8Data, Fu16Size );
+    EEPROM_CACHE_INVALIDATE( Fu16VirtAddr );
+    EEPROM_WRITER_UNLOCK( &stEEPROM_iDefault );
 
-    return u32Data;
+    return u8FnRet;
 }
 
 
-/*checks flash integrity (crc is correct for all stored values) after init*/
-
-
-uint8_t u8EEPROM_eCheckDataIntegrity( void )
+#if EEPROM_COUNTER_ENABLE
+/**
+ * @brief Add 1 to a counter, read back with u8EEPROM_eReadVar and set with u8EEPROM_eWriteVar
+ * @param Fu16VirtAddr Virtual address of the counter, a variable never written counts from 0
+ * @param Fpu32Value Pointer to store the new value, may be NULL
+ * @return Status code indicating the result of the write operation
+ */
+uint8_t u8EEPROM_eIncrementCounter( uint16_t Fu16VirtAddr,
+                                    uint32_t * Fpu32Value )
 {
-    uint64_t * u64PageCounter = ( uint64_t * ) ( u32NextWriteAddress - PACKET_SIZE );
-    uint64_t u64Packet;
-    uint32_t u32pageStartAdress = PAGE_HEADER_ADDRESS( u8ActivePage ) + PAGE_HEADER_SIZE;
-    uint32_t u32Data;
-    uint16_t u16VirtAddr, u16CRC;
-
-    uint8_t u8FnRet = Du8EEPROM_eSUCCESS;
-
-    if( ( bEEPROM_iInitDone == FALSE ) || ( u8ActivePage == 0xFFU ) )
-    {
-        return Du8EEPROM_eERROR;
-    }
-
-    while( u64PageCounter >= ( uint64_t * ) u32pageStartAdress )
-    {
-        u64Packet = *( u64PageCounter );
-
-        if( ( u64Packet != FREED_PACKET ) && ( u64Packet != EMPTY_PACKET ) )
-        {
-            u16VirtAddr = ( uint16_t ) ( u64Packet >> 48 );
+    uint8_t u8FnRet;
 
-            u16CRC = ( uint16_t ) ( u64Packet >> 32 );
-            u32Data = ( uint32_t ) ( u64Packet );
+    EEPROM_WRITER_LOCK( &stEEPROM_iDefault );
+    u8FnRet = u8EEPROM_eInstIncrementCounter( &stEEPROM_iDefault, Fu16VirtAddr, Fpu32Value );
+    EEPROM_CACHE_INVALIDATE( Fu16VirtAddr );
+    EEPROM_WRITER_UNLOCK( &stEEPROM_iDefault );
 
-            if( u16CRC != u16EEPROM_iCalculateCRC( u16VirtAddr, u32Data ) ) /*is CRC correct*/
-            {
-                u8FnRet = Du8EEPROM_eDATA_CORRUPTED;
+    return u8FnRet;
+}
+#endif
 
-                return u8FnRet;
-            }
 
-            /*the freeVar call was made to free old variables in case of power shut between write and free*/
-            u8FnRet = u8EEPROM_freeVar( u16VirtAddr, ( ( uint32_t ) u64PageCounter - PACKET_SIZE ) );
-        }
+/**
+ * @brief Read a record written by u8EEPROM_eWriteRecord
+ * @param Fu16VirtAddr Virtual address of the record
+ * @param Fpu8Data Buffer to store the data
+ * @param Fu16MaxSize Size of the buffer in bytes
+ * @param Fpu16Size Pointer to store the size of the record (also set when the buffer is too small)
+ * @return Status code indicating the result of the read operation
+ */
+uint8_t u8EEPROM_eReadRecord( uint16_t Fu16VirtAddr,
+                              uint8_t * Fpu8Data,
+                              uint16_t Fu16MaxSize,
+                              uint16_t * Fpu16Size )
+{
+    return u8EEPROM_eInstReadRecord( &stEEPROM_iDefault, Fu16VirtAddr, Fpu8Data, Fu16MaxSize, Fpu16Size );
+}
 
-        u64PageCounter--;
-    }
 
-    if( u8FnRet != Du8EEPROM_eSUCCESS )
-    {
-        return Du8EEPROM_eERROR;
-    }
-    else
-    {
-        return Du8EEPROM_eSUCCESS;
-    }
+/**
+ * @brief Read a variable from the EEPROM based on the virtual address
+ * @param Fu16VirtAddr Virtual address of the variable to read
+ * @param Fpu32Value Pointer to store the read value
+ * @return Status code indicating the result of the read operation
+ */
+uint8_t u8EEPROM_eReadVar( uint16_t Fu16VirtAddr,
+                           uint32_t * Fpu32Value )
+{
+    return u8EEPROM_eInstReadVar( &stEEPROM_iDefault, Fu16VirtAddr, Fpu32Value );
 }
 
 
-/*
- * loops through active page and reads all variables
+/**
+ * @brief Check the data integrity of the EEPROM
+ * @return Status code indicating the result of the data integrity check
  */
+uint8_t u8EEPROM_eCheckDataIntegrity( void )
+{
+    return u8EEPROM_eInstCheckDataIntegrity( &stEEPROM_iDefault );
+}
+
 
 /**
  * @brief Read all variables from the EEPROM and store them in the provided array
@@ -979,63 +4360,148 @@ uint8_t u8EEPROM_eReadAllVar( Tst_EppromPacket * Fu64arr,
                               uint32_t u32MaArrSize,
                               uint32_t * Fu32Size )
 {
-    uint32_t u32pageStartAdress;
-    uint64_t * u64PageCounter;
+    return u8EEPROM_eInstReadAllVar( &stEEPROM_iDefault, Fu64arr, u32MaArrSize, Fu32Size );
+}
 
-    uint64_t u64Packet;
 
-    uint32_t u32Data;
+/**
+ * @brief Walk the pages once and call FpfVisit once per stored variable with its newest value
+ * @param FpfVisit Visitor, returns FALSE to stop the walk
+ * @param FpvContext Passed to FpfVisit
+ * @return Status code indicating the result of the walk
+ */
+uint8_t u8EEPROM_eForEachVar( Tpf_EepromVarVisitor FpfVisit,
+                              void * FpvContext )
+{
+    return u8EEPROM_eInstForEachVar( &stEEPROM_iDefault, FpfVisit, FpvContext );
+}
+
 
-    uint16_t u16VirtAddr, u16CRC;
+/**
+ * @brief Load a range of variables in a table indexed by virtual address
+ * @param Fu16FirstVirtAddr Virtual address of the first entry of the table
+ * @param Fpst Table of Fu32NbVars entries
+ * @param Fu32NbVars Number of entries
+ * @param Fpu32NbStored Pointer to store the number of entries found in the EEPROM (can be NULL)
+ * @return Status code indicating the result of the read operation
+ */
+uint8_t u8EEPROM_eReadSnapshot( uint16_t Fu16FirstVirtAddr,
+                                Tst_EppromPacket * Fpst,
+                                uint32_t Fu32NbVars,
+                                uint32_t * Fpu32NbStored )
+{
+    return u8EEPROM_eInstReadSnapshot( &stEEPROM_iDefault, Fu16FirstVirtAddr, Fpst, Fu32NbVars, Fpu32NbStored );
+}
 
 
-    if( ( bEEPROM_iInitDone == FALSE ) || ( u8ActivePage == 0xFFU ) )
-    {
-        return Du8EEPROM_eERROR;
-    }
+/**
+ * @brief Serialize the newest copy of every variable and record in an image
+ * @param Fpu8Image Buffer receiving the image
+ * @param Fu32MaxSize Size of the buffer
+ * @param Fpu32Size Pointer to store the size of the image
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eExportImage( uint8_t * Fpu8Image,
+                               uint32_t Fu32MaxSize,
+                               uint32_t * Fpu32Size )
+{
+    return u8EEPROM_eInstExportImage( &stEEPROM_iDefault, Fpu8Image, Fu32MaxSize, Fpu32Size );
+}
 
-    if( ( Fu64arr == NULL ) || ( Fu32Size == NULL ) )
-    {
-        return Du8EEPROM_eBAD_PARAM;
-    }
 
-    *Fu32Size = 0;
+/**
+ * @brief Replace the content of the EEPROM with an image
+ * @param Fpu8Image Image
+ * @param Fu32Size Size of the image
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eImportImage( const uint8_t * Fpu8Image,
+                               uint32_t Fu32Size )
+{
+    uint8_t u8FnRet;
 
+    EEPROM_WRITER_LOCK( &stEEPROM_iDefault );
+    u8FnRet = u8EEPROM_eInstImportImage( &stEEPROM_iDefault, Fpu8Image, Fu32Size );
+    EEPROM_CACHE_CLEAR();
+    EEPROM_WRITER_UNLOCK( &stEEPROM_iDefault );
 
-    u32pageStartAdress = PAGE_HEADER_ADDRESS( u8ActivePage ) + PAGE_HEADER_SIZE;
-    u64PageCounter = ( uint64_t * ) ( u32NextWriteAddress - PACKET_SIZE );
+    return u8FnRet;
+}
 
-    while( u64PageCounter >= ( uint64_t * ) u32pageStartAdress )
-    {
-        u64Packet = *( u64PageCounter );
 
-        if( u64Packet != FREED_PACKET )
-        {
-            u16VirtAddr = ( uint16_t ) ( u64Packet >> 48 );
+/**
+ * @brief Run a slice of the pending page transfer (copy of the oldest page, then its erase)
+ * @param Fu32MaxPackets Maximum number of source packets to process, TRANSFER_STEP_UNLIMITED to finish the transfer
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eTransferStep( uint32_t Fu32MaxPackets )
+{
+    return u8EEPROM_eInstTransferStep( &stEEPROM_iDefault, Fu32MaxPackets );
+}
 
-            u16CRC = ( uint16_t ) ( u64Packet >> 32 );
-            u32Data = ( uint32_t ) ( u64Packet );
 
-            if( u16CRC != u16EEPROM_iCalculateCRC( u16VirtAddr, u32Data ) ) /*is CRC correct*/
-            {
-                /*return Du8EEPROM_eDATA_CORRUPTED;*/
-            }
-            else
-            {
-                Fu64arr[ ( *Fu32Size ) ].u16VirtAddr = u16VirtAddr;
-                Fu64arr[ ( *Fu32Size ) ].u16CRC = u16CRC;
-                Fu64arr[ ( *Fu32Size ) ].u32DataVal = u32Data;
-                ( *Fu32Size )++;
+/**
+ * @brief Check if a page transfer is pending
+ * @return TRUE if u8EEPROM_eTransferStep has work to do, FALSE otherwise
+ */
+BOOL bEEPROM_eIsTransferPending( void )
+{
+    return bEEPROM_eInstIsTransferPending( &stEEPROM_iDefault );
+}
 
-                if( *Fu32Size > u32MaArrSize )
-                {
-                    return Du8EEPROM_eBAD_PARAM;
-                }
-            }
-        }
 
-        u64PageCounter--;
-    }
+/**
+ * @brief Get the number of variables that can be written before a write has to switch page or finish a transfer
+ * @return Number of variables
+ */
+uint32_t u32EEPROM_eGetWriteBudget( void )
+{
+    return u32EEPROM_eInstGetWriteBudget( &stEEPROM_iDefault );
+}
 
-    return Du8EEPROM_eSUCCESS;
+
+/**
+ * @brief Check if the EEPROM is erased
+ * @return TRUE if all EEPROM pages are erased, FALSE otherwise
+ */
+BOOL bEEPROM_eIsEepromErased( void )
+{
+    return bEEPROM_eInstIsEepromErased( &stEEPROM_iDefault );
+}
+
+
+#if EEPROM_STATS_ENABLE
+
+/**
+ * @brief Get the runtime statistics of the driver
+ * @param Fpst Pointer to store the statistics
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eGetStats( Tst_EepromStats * Fpst )
+{
+    return u8EEPROM_eInstGetStats( &stEEPROM_iDefault, Fpst );
+}
+
+
+/**
+ * @brief Reset the counters of the runtime statistics
+ */
+void vEEPROM_eResetStats( void )
+{
+    vEEPROM_eInstResetStats( &stEEPROM_iDefault );
+}
+
+#endif /* EEPROM_STATS_ENABLE */
+
+
+/**
+ * @brief Get the erase count of a specific EEPROM page
+ * @param Fu8PageId ID of the EEPROM page
+ * @param Fpu32EraseCount Pointer to store the erase count
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_iGetEraseCount( uint8_t Fu8PageId,
+                                 uint32_t * Fpu32EraseCount )
+{
+    return u8EEPROM_eInstGetEraseCount( &stEEPROM_iDefault, Fu8PageId, Fpu32EraseCount );
 }
@@ -0,0 +1,475 @@
+/*
+ * eeprom_hotcold.c
+ * fyras1
+ *
+ */
+
+#include "eeprom_hotcold.h"
+
+#if EEPROM_HOTCOLD_ENABLE
+
+#if ( EEPROM_HOTCOLD_HOT_SCORE == 0U ) || ( EEPROM_HOTCOLD_HOT_SCORE > 0xFFU )
+    #error "EEPROM_HOTCOLD_HOT_SCORE must be in [1, 255]"
+#endif
+#if ( EEPROM_HOTCOLD_DECAY_WRITES == 0U )
+    #error "EEPROM_HOTCOLD_DECAY_WRITES must be at least 1"
+#endif
+#if ( EEPROM_HOT_PAGE_SIZE > EEPROM_TRANSFER_MAX_PAGE_SIZE )
+    #error "EEPROM_TRANSFER_MAX_PAGE_SIZE must cover EEPROM_HOT_PAGE_SIZE"
+#endif
+
+static Tst_EepromInstance stEEPROM_iHot = EEPROM_INSTANCE_INIT( EEPROM_HOT_START_ADDR, EEPROM_HOT_PAGE_SIZE,
+                                                                EEPROM_HOT_FIRST_SECTOR, &stEEPROM_eMcuFlash );
+static Tst_EepromKeyTrack astEEPROM_iTrack[ EEPROM_HOTCOLD_TRACK_SIZE ];
+static uint32_t u32WritesSinceDecay = 0U;
+static uint32_t u32MovingCount = 0U; /*entries with bMoving set*/
+
+
+/*Internal -----------*/
+
+
+/** @defgroup EEPROMHotColdPrivate_Func Private_Functions
+ * @{
+ */
+
+static void vEEPROM_iHotColdForget( void );
+static void vEEPROM_iHotColdEndMoves( void );
+static BOOL bEEPROM_iHotColdIsHot( const Tst_EepromKeyTrack * FpstTrack );
+static BOOL bEEPROM_iHotColdInHot( uint16_t Fu16VirtAddr );
+static BOOL bEEPROM_iHotColdRelocate( uint16_t Fu16VirtAddr,
+                                      uint32_t Fu32Data );
+static Tst_EepromKeyTrack * pstEEPROM_iTrackFind( uint16_t Fu16VirtAddr );
+static Tst_EepromKeyTrack * pstEEPROM_iTrackAlloc( uint16_t Fu16VirtAddr );
+/**
+ * @}
+ */
+
+
+/**
+ * @brief Initialize the cold region (u8EEPROM_eInit) and the hot region, forget the learned write rates
+ * @return Status code indicating the result of the initialization
+ */
+uint8_t u8EEPROM_eHotColdInit( void )
+{
+    uint8_t u8FnRet;
+
+    vEEPROM_iHotColdForget();
+    stEEPROM_iHot.pfRelocate = bEEPROM_iHotColdRelocate;
+
+    /*the cold region first: the hot one may resume a transfer that moves variables to it*/
+    u8FnRet = u8EEPROM_eInit();
+
+    if( u8FnRet != Du8EEPROM_eSUCCESS )
+    {
+        return u8FnRet;
+    }
+
+    return u8EEPROM_eInstInit( &stEEPROM_iHot );
+}
+
+
+/**
+ * @brief Format the cold and the hot regions, forget the learned write rates
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eHotColdFormat( void )
+{
+    uint8_t u8FnRet;
+
+    vEEPROM_iHotColdForget();
+    stEEPROM_iHot.pfRelocate = bEEPROM_iHotColdRelocate;
+
+    u8FnRet = u8EEPROM_eFormat();
+
+    if( u8FnRet != Du8EEPROM_eSUCCESS )
+    {
+        return u8FnRet;
+    }
+
+    return u8EEPROM_eInstFormat( &stEEPROM_iHot );
+}
+
+
+/**
+ * @brief Set the class of a variable instead of learning it from its write rate
+ * @param Fu16VirtAddr Virtual address of the variable
+ * @param FeClass EEPROM_KEY_HOT, EEPROM_KEY_COLD or EEPROM_KEY_AUTO to learn it again
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eHotColdDeclare( uint16_t Fu16VirtAddr,
+                                  EEpromKeyClassTypedef FeClass )
+{
+    Tst_EepromKeyTrack * pstTrack;
+
+    if( ( FALSE == IS_VIRTUAL_ADDRESS_VALID( Fu16VirtAddr ) ) || ( FeClass > EEPROM_KEY_COLD ) )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    pstTrack = pstEEPROM_iTrackFind( Fu16VirtAddr );
+
+    if( pstTrack == NULL )
+    {
+        pstTrack = pstEEPROM_iTrackAlloc( Fu16VirtAddr );
+
+        if( pstTrack == NULL )
+        {
+            return Du8EEPROM_eERROR;
+        }
+    }
+
+    pstTrack->u8Class = ( uint8_t ) FeClass;
+
+    return Du8EEPROM_eSUCCESS;
+}
+
+
+/**
+ * @brief Write a variable to the region of its class
+ * @param Fu16VirtAddr Virtual address of the variable to write
+ * @param Fu32Data Data value to write
+ * @return Status code indicating the result of the write operation
+ */
+uint8_t u8EEPROM_eHotColdWriteVar( uint16_t Fu16VirtAddr,
+                                   uint32_t Fu32Data )
+{
+    Tst_EepromKeyTrack * pstTrack;
+    uint32_t u32Pos;
+    BOOL bToHot;
+
+    /*forbidden adresses*/
+    if( FALSE == IS_VIRTUAL_ADDRESS_VALID( Fu16VirtAddr ) )
+    {
+        return Du8EEPROM_eWRITE_ERROR;
+    }
+
+    vEEPROM_iHotColdEndMoves();
+
+    pstTrack = pstEEPROM_iTrackFind( Fu16VirtAddr );
+
+    if( pstTrack == NULL )
+    {
+        pstTrack = pstEEPROM_iTrackAlloc( Fu16VirtAddr );
+    }
+
+    if( ( pstTrack != NULL ) && ( pstTrack->u8Score < 0xFFU ) )
+    {
+        pstTrack->u8Score++;
+    }
+
+    u32WritesSinceDecay++;
+
+    if( u32WritesSinceDecay >= EEPROM_HOTCOLD_DECAY_WRITES )
+    {
+        /*the score follows the recent write rate*/
+        for( u32Pos = 0U; u32Pos < EEPROM_HOTCOLD_TRACK_SIZE; u32Pos++ )
+        {
+            astEEPROM_iTrack[ u32Pos ].u8Score >>= 1;
+        }
+
+        u32WritesSinceDecay = 0U;
+    }
+
+    if( ( pstTrack != NULL ) && ( ( TRUE == bEEPROM_iHotColdIsHot( pstTrack ) ) || ( pstTrack->bMoving == TRUE ) ) )
+    {
+        bToHot = TRUE;
+    }
+    else
+    {
+        /*a copy left in the hot region would hide the cold one*/
+        bToHot = bEEPROM_iHotColdInHot( Fu16VirtAddr );
+    }
+
+    if( bToHot == TRUE )
+    {
+        return u8EEPROM_eInstWriteVar( &stEEPROM_iHot, Fu16VirtAddr, Fu32Data );
+    }
+
+    return u8EEPROM_eWriteVar( Fu16VirtAddr, Fu32Data );
+}
+
+
+/**
+ * @brief Read a variable, from the hot region first
+ * @param Fu16VirtAddr Virtual address of the variable to read
+ * @param Fpu32Value Pointer to store the read value
+ * @return Status code indicating the result of the read operation
+ */
+uint8_t u8EEPROM_eHotColdReadVar( uint16_t Fu16VirtAddr,
+                                  uint32_t * Fpu32Value )
+{
+    uint8_t u8FnRet;
+
+    if( Fpu32Value == NULL )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    u8FnRet = u8EEPROM_eInstReadVar( &stEEPROM_iHot, Fu16VirtAddr, Fpu32Value );
+
+    if( u8FnRet != Du8EEPROM_eREAD_ERROR )
+    {
+        return u8FnRet;
+    }
+
+    return u8EEPROM_eReadVar( Fu16VirtAddr, Fpu32Value );
+}
+
+
+/**
+ * @brief Run a slice of the pending transfers of the hot and the cold regions
+ * @param Fu32MaxPackets Maximum number of source packets to process per region, TRANSFER_STEP_UNLIMITED to finish
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eHotColdTransferStep( uint32_t Fu32MaxPackets )
+{
+    uint8_t u8FnRet;
+
+    u8FnRet = u8EEPROM_eInstTransferStep( &stEEPROM_iHot, Fu32MaxPackets );
+
+    if( u8FnRet == Du8EEPROM_eSUCCESS )
+    {
+        u8FnRet = u8EEPROM_eTransferStep( Fu32MaxPackets );
+    }
+
+    vEEPROM_iHotColdEndMoves();
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Check if a transfer of the hot or the cold region is pending
+ * @return TRUE if u8EEPROM_eHotColdTransferStep has work to do, FALSE otherwise
+ */
+BOOL bEEPROM_eHotColdIsTransferPending( void )
+{
+    if( TRUE == bEEPROM_eInstIsTransferPending( &stEEPROM_iHot ) )
+    {
+        return TRUE;
+    }
+
+    return bEEPROM_eIsTransferPending();
+}
+
+
+/**
+ * @brief Check the current class of a variable
+ * @param Fu16VirtAddr Virtual address of the variable
+ * @return TRUE if its writes go to the hot region, FALSE otherwise
+ */
+BOOL bEEPROM_eHotColdIsHot( uint16_t Fu16VirtAddr )
+{
+    Tst_EepromKeyTrack * pstTrack = pstEEPROM_iTrackFind( Fu16VirtAddr );
+
+    if( ( pstTrack != NULL ) && ( ( TRUE == bEEPROM_iHotColdIsHot( pstTrack ) ) || ( pstTrack->bMoving == TRUE ) ) )
+    {
+        return TRUE;
+    }
+
+    return bEEPROM_iHotColdInHot( Fu16VirtAddr );
+}
+
+
+#if EEPROM_STATS_ENABLE
+
+/**
+ * @brief Get the runtime statistics of both regions
+ * @param FpstHot Pointer to store the statistics of the hot region
+ * @param FpstCold Pointer to store the statistics of the cold region
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eHotColdGetStats( Tst_EepromStats * FpstHot,
+                                   Tst_EepromStats * FpstCold )
+{
+    uint8_t u8FnRet;
+
+    u8FnRet = u8EEPROM_eInstGetStats( &stEEPROM_iHot, FpstHot );
+
+    if( u8FnRet != Du8EEPROM_eSUCCESS )
+    {
+        return u8FnRet;
+    }
+
+    return u8EEPROM_eGetStats( FpstCold );
+}
+
+#endif /* if EEPROM_STATS_ENABLE */
+
+
+/**
+ * @brief Drop the learned write rates and the pending moves, the declared classes are kept
+ */
+static void vEEPROM_iHotColdForget( void )
+{
+    uint32_t u32Pos;
+
+    for( u32Pos = 0U; u32Pos < EEPROM_HOTCOLD_TRACK_SIZE; u32Pos++ )
+    {
+        if( astEEPROM_iTrack[ u32Pos ].u8Class == ( uint8_t ) EEPROM_KEY_AUTO )
+        {
+            astEEPROM_iTrack[ u32Pos ].u16VirtAddr = 0U;
+        }
+
+        astEEPROM_iTrack[ u32Pos ].u8Score = 0U;
+        astEEPROM_iTrack[ u32Pos ].bMoving = FALSE;
+    }
+
+    u32WritesSinceDecay = 0U;
+    u32MovingCount = 0U;
+}
+
+
+/**
+ * @brief Clear the pending moves once the hot transfer that made them is over (its source page is erased)
+ * @note until then a power loss resumes the transfer from the source page: a cold write of a moved variable
+ *       could be overwritten by the same move done again
+ */
+static void vEEPROM_iHotColdEndMoves( void )
+{
+    uint32_t u32Pos;
+
+    if( ( u32MovingCount == 0U ) || ( TRUE == bEEPROM_eInstIsTransferPending( &stEEPROM_iHot ) ) )
+    {
+        return;
+    }
+
+    for( u32Pos = 0U; u32Pos < EEPROM_HOTCOLD_TRACK_SIZE; u32Pos++ )
+    {
+        astEEPROM_iTrack[ u32Pos ].bMoving = FALSE;
+    }
+
+    u32MovingCount = 0U;
+}
+
+
+/**
+ * @brief Get the class of a tracked variable
+ * @param FpstTrack Tracking entry of the variable
+ * @return TRUE if the variable is hot, FALSE otherwise
+ */
+static BOOL bEEPROM_iHotColdIsHot( const Tst_EepromKeyTrack * FpstTrack )
+{
+    if( FpstTrack->u8Class == ( uint8_t ) EEPROM_KEY_AUTO )
+    {
+        return( ( FpstTrack->u8Score >= EEPROM_HOTCOLD_HOT_SCORE ) ? TRUE : FALSE );
+    }
+
+    return( ( FpstTrack->u8Class == ( uint8_t ) EEPROM_KEY_HOT ) ? TRUE : FALSE );
+}
+
+
+/**
+ * @brief Check if the hot region stores a variable (damaged copies included)
+ * @param Fu16VirtAddr Virtual address of the variable
+ * @return TRUE if the hot region has a copy, FALSE otherwise
+ */
+static BOOL bEEPROM_iHotColdInHot( uint16_t Fu16VirtAddr )
+{
+    uint32_t u32Value;
+
+    return( ( u8EEPROM_eInstReadVar( &stEEPROM_iHot, Fu16VirtAddr, &u32Value ) != Du8EEPROM_eREAD_ERROR ) ? TRUE : FALSE );
+}
+
+
+/**
+ * @brief Relocation hook of the hot region: a variable that cooled down is written to the cold region
+ *        instead of being copied by the hot transfer
+ * @param Fu16VirtAddr Virtual address of the variable
+ * @param Fu32Data Value of the variable
+ * @return TRUE if the variable now lives in the cold region, FALSE to keep it in the hot region
+ */
+static BOOL bEEPROM_iHotColdRelocate( uint16_t Fu16VirtAddr,
+                                      uint32_t Fu32Data )
+{
+    Tst_EepromKeyTrack * pstTrack = pstEEPROM_iTrackFind( Fu16VirtAddr );
+
+    if( pstTrack == NULL )
+    {
+        /*not written since boot (or evicted): it stays hot for one more decay period*/
+        pstTrack = pstEEPROM_iTrackAlloc( Fu16VirtAddr );
+
+        if( pstTrack != NULL )
+        {
+            pstTrack->u8Score = EEPROM_HOTCOLD_HOT_SCORE;
+        }
+
+        return FALSE;
+    }
+
+    if( ( TRUE == bEEPROM_iHotColdIsHot( pstTrack ) ) || ( pstTrack->bMoving == TRUE ) )
+    {
+        return FALSE;
+    }
+
+    if( Du8EEPROM_eSUCCESS != u8EEPROM_eWriteVar( Fu16VirtAddr, Fu32Data ) )
+    {
+        return FALSE;
+    }
+
+    pstTrack->bMoving = TRUE;
+    u32MovingCount++;
+
+    return TRUE;
+}
+
+
+/**
+ * @brief Find the tracking entry of a variable
+ * @param Fu16VirtAddr Virtual address of the variable
+ * @return Pointer to the entry, NULL if the variable is not tracked
+ */
+static Tst_EepromKeyTrack * pstEEPROM_iTrackFind( uint16_t Fu16VirtAddr )
+{
+    uint32_t u32Pos;
+
+    for( u32Pos = 0U; u32Pos < EEPROM_HOTCOLD_TRACK_SIZE; u32Pos++ )
+    {
+        if( astEEPROM_iTrack[ u32Pos ].u16VirtAddr == Fu16VirtAddr )
+        {
+            return &astEEPROM_iTrack[ u32Pos ];
+        }
+    }
+
+    return NULL;
+}
+
+
+/**
+ * @brief Get a tracking entry for a variable: an unused one, else the learned one with the lowest score
+ * @note declared and moving entries are never taken
+ * @param Fu16VirtAddr Virtual address of the variable
+ * @return Pointer to the entry (class EEPROM_KEY_AUTO, score 0), NULL if none can be taken
+ */
+static Tst_EepromKeyTrack * pstEEPROM_iTrackAlloc( uint16_t Fu16VirtAddr )
+{
+    Tst_EepromKeyTrack * pstVictim = NULL;
+    uint32_t u32Pos;
+
+    for( u32Pos = 0U; u32Pos < EEPROM_HOTCOLD_TRACK_SIZE; u32Pos++ )
+    {
+        if( astEEPROM_iTrack[ u32Pos ].u16VirtAddr == 0U )
+        {
+            pstVictim = &astEEPROM_iTrack[ u32Pos ];
+            break;
+        }
+
+        if( ( astEEPROM_iTrack[ u32Pos ].u8Class == ( uint8_t ) EEPROM_KEY_AUTO ) && ( astEEPROM_iTrack[ u32Pos ].bMoving == FALSE ) &&
+            ( ( pstVictim == NULL ) || ( astEEPROM_iTrack[ u32Pos ].u8Score < pstVictim->u8Score ) ) )
+        {
+            pstVictim = &astEEPROM_iTrack[ u32Pos ];
+        }
+    }
+
+    if( pstVictim != NULL )
+    {
+        pstVictim->u16VirtAddr = Fu16VirtAddr;
+        pstVictim->u8Class = ( uint8_t ) EEPROM_KEY_AUTO;
+        pstVictim->u8Score = 0U;
+        pstVictim->bMoving = FALSE;
+    }
+
+    return pstVictim;
+}
+
+#endif /* EEPROM_HOTCOLD_ENABLE */
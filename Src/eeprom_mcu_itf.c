@@ -7,25 +7,39 @@
 #if IS_FREERTOS_USED
 #include "FreeRTOS.h"
 #include "task.h"
+#include "semphr.h"
 #endif
+
+static volatile uint8_t u8EraseStatus = FLASH_ITF_ERASE_DONE;
+static volatile uint32_t u32SessionDepth = 0U; /*nesting of the programming sessions*/
+#if IS_FREERTOS_USED && EEPROM_THREAD_SAFE_ENABLE
+static StaticSemaphore_t stWriterMutexBuffer;
+static SemaphoreHandle_t xWriterMutex = NULL;
+#endif
+
+static void vFLASH_ITF_iUnlock( void );
+static void vFLASH_ITF_iLock( void );
+static HAL_StatusTypeDef eFLASH_ITF_iProgramPacket( uint32_t Fu32Address,
+                                                    uint64_t Fu64Data );
+
 /**
  * @brief Erase a sector of the MCU flash memory
- * @param Page Page number of the sector to erase
+ * @param Fu8Sector MCU sector to erase
  * @return Status code indicating the result of the erase operation
  */
-__attribute__((weak)) uint8_t u8FLASH_ITF_eFlashSectorErase( uint8_t Fu8Page )
+__attribute__((weak)) uint8_t u8FLASH_ITF_eFlashSectorErase( uint8_t Fu8Sector )
 {
     uint8_t ret = 0U;
     uint32_t u32SectorError = 0U;
     FLASH_EraseInitTypeDef eraseInit;
 
     eraseInit.TypeErase = FLASH_TYPEERASE_SECTORS;
-    eraseInit.VoltageRange = FLASH_VOLTAGE_RANGE_3;
-    eraseInit.Sector = MCU_PAGE_0_FLASH_SECTOR + Fu8Page;
+    eraseInit.VoltageRange = MCU_FLASH_VOLTAGE_RANGE;
+    eraseInit.Sector = Fu8Sector;
     eraseInit.NbSectors = 1;
 
     /*NOTE: ErasePage automatically sets page state to ERASED(0xffffffff) (fismail)*/
-    HAL_FLASH_Unlock();
+    vFLASH_ITF_iUnlock();
 
 
     /* Critical Section */
@@ -42,11 +56,178 @@ __attribute__((weak)) uint8_t u8FLASH_ITF_eFlashSectorErase( uint8_t Fu8Page )
 #if IS_FREERTOS_USED
     taskEXIT_CRITICAL();
 #endif
-    HAL_FLASH_Lock();
+    vFLASH_ITF_iLock();
     return ret;
 }
 
 
+/**
+ * @brief Start the erase of a sector of the MCU flash memory and return without waiting for it
+ * @param Fu8Sector MCU sector to erase
+ * @return Status code indicating the result of the operation : 0 OK ; 1 NOT OK
+ */
+__attribute__((weak)) uint8_t u8FLASH_ITF_eFlashSectorEraseStart( uint8_t Fu8Sector )
+{
+    FLASH_EraseInitTypeDef eraseInit;
+
+    eraseInit.TypeErase = FLASH_TYPEERASE_SECTORS;
+    eraseInit.VoltageRange = MCU_FLASH_VOLTAGE_RANGE;
+    eraseInit.Sector = Fu8Sector;
+    eraseInit.NbSectors = 1;
+
+    /*the flash stays unlocked until the end of operation callback*/
+    vFLASH_ITF_iUnlock();
+
+    u8EraseStatus = FLASH_ITF_ERASE_BUSY;
+
+    if( HAL_FLASHEx_Erase_IT( &eraseInit ) != HAL_OK )
+    {
+        u8EraseStatus = FLASH_ITF_ERASE_ERROR;
+        vFLASH_ITF_iLock();
+        return 1U;
+    }
+
+    return 0U;
+}
+
+
+/**
+ * @brief Get the status of the erase started by u8FLASH_ITF_eFlashSectorEraseStart
+ * @return FLASH_ITF_ERASE_DONE, FLASH_ITF_ERASE_BUSY or FLASH_ITF_ERASE_ERROR
+ */
+__attribute__((weak)) uint8_t u8FLASH_ITF_eFlashEraseStatus( void )
+{
+    /*polling: if the FLASH interrupt is not enabled, run its handler once the controller is idle*/
+    if( ( u8EraseStatus == FLASH_ITF_ERASE_BUSY ) && ( __HAL_FLASH_GET_FLAG( FLASH_FLAG_BSY ) == RESET ) )
+    {
+        HAL_FLASH_IRQHandler();
+    }
+
+    return u8EraseStatus;
+}
+
+
+/**
+ * @brief Called in loop while the driver has to wait for the end of an erase
+ */
+__attribute__((weak)) void vFLASH_ITF_eEraseWaitHook( void )
+{
+#if IS_FREERTOS_USED
+    taskYIELD();
+#endif
+}
+
+
+/**
+ * @brief Compute a CRC with the CRC unit of the MCU (EEPROM_CRC_HW)
+ * @param Fpu32Words Words to feed
+ * @param Fu32NbWords Number of words
+ * @return CRC of the words
+ */
+__attribute__((weak)) uint32_t u32FLASH_ITF_eHwCrc32( const uint32_t * Fpu32Words,
+                                                    uint32_t Fu32NbWords )
+{
+    uint32_t u32Pos;
+    uint32_t u32Crc;
+
+    /*concurrent reads (EEPROM_THREAD_SAFE_ENABLE) share the unit*/
+#if IS_FREERTOS_USED
+    taskENTER_CRITICAL();
+#endif
+
+    __HAL_RCC_CRC_CLK_ENABLE();
+    CRC->CR = CRC_CR_RESET;
+
+    for( u32Pos = 0U; u32Pos < Fu32NbWords; u32Pos++ )
+    {
+        CRC->DR = Fpu32Words[ u32Pos ];
+    }
+
+    u32Crc = CRC->DR;
+
+#if IS_FREERTOS_USED
+    taskEXIT_CRITICAL();
+#endif
+
+    return u32Crc;
+}
+
+
+/**
+ * @brief Get a millisecond tick
+ * @return Current time in ms
+ */
+__attribute__((weak)) uint32_t u32FLASH_ITF_eGetTickMs( void )
+{
+    return HAL_GetTick();
+}
+
+
+/**
+ * @brief Get a free running timestamp (CPU cycles)
+ * @return Current timestamp, may wrap around
+ */
+__attribute__((weak)) uint32_t u32FLASH_ITF_eGetTimestamp( void )
+{
+    if( ( DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk ) == 0U )
+    {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0U;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+
+    return DWT->CYCCNT;
+}
+
+
+/**
+ * @brief End the background erase from the flash interrupt
+ * @param Fu32ReturnValue ReturnValue of the HAL callback: sector erased, 0xFFFFFFFF once all the sectors are erased
+ * @param FbError TRUE from HAL_FLASH_OperationErrorCallback
+ */
+void vFLASH_ITF_eEraseIrqDone( uint32_t Fu32ReturnValue,
+                               BOOL FbError )
+{
+    if( u8EraseStatus != FLASH_ITF_ERASE_BUSY )
+    {
+        return;
+    }
+
+    if( FbError == TRUE )
+    {
+        u8EraseStatus = FLASH_ITF_ERASE_ERROR;
+        vFLASH_ITF_iLock();
+    }
+    else if( Fu32ReturnValue == 0xFFFFFFFFU )
+    {
+        u8EraseStatus = FLASH_ITF_ERASE_DONE;
+        vFLASH_ITF_iLock();
+    }
+}
+
+
+/**
+ * @brief HAL end of operation callback, default implementation: ends the background erase
+ * @note an application implementing this HAL callback calls vFLASH_ITF_eEraseIrqDone( ReturnValue, FALSE ) from it
+ * @param ReturnValue sector erased, 0xFFFFFFFF once all the sectors are erased
+ */
+__attribute__((weak)) void HAL_FLASH_EndOfOperationCallback( uint32_t ReturnValue )
+{
+    vFLASH_ITF_eEraseIrqDone( ReturnValue, FALSE );
+}
+
+
+/**
+ * @brief HAL operation error callback, default implementation: ends the background erase
+ * @note an application implementing this HAL callback calls vFLASH_ITF_eEraseIrqDone( ReturnValue, TRUE ) from it
+ * @param ReturnValue sector in error
+ */
+__attribute__((weak)) void HAL_FLASH_OperationErrorCallback( uint32_t ReturnValue )
+{
+    vFLASH_ITF_eEraseIrqDone( ReturnValue, TRUE );
+}
+
+
 
 /**
  * @brief Program data into the MCU flash memory at the specified address
@@ -60,9 +241,8 @@ __attribute__((weak)) uint8_t u8FLASH_ITF_FlashProgram( uint32_t Fu32Address,
                                   uint8_t fu8WriteSizeBytes )
 {
     uint8_t u8FnRet = 0U;
-    HAL_StatusTypeDef hal_status;
 
-    HAL_FLASH_Unlock();
+    vFLASH_ITF_iUnlock();
 
     switch( fu8WriteSizeBytes )
     {
@@ -95,15 +275,7 @@ __attribute__((weak)) uint8_t u8FLASH_ITF_FlashProgram( uint32_t Fu32Address,
 
         case 8:
            {
-#if IS_FREERTOS_USED
-               taskENTER_CRITICAL(); /*double word write should NOT be interrupted*/
-#endif
-               hal_status = HAL_FLASH_Program( FLASH_TYPEPROGRAM_WORD, Fu32Address, ( Fu64Data & 0xFFFFFFFFU ) );
-               hal_status |= HAL_FLASH_Program( FLASH_TYPEPROGRAM_WORD, Fu32Address + 4U, ( Fu64Data >> 32 ) & 0xFFFFFFFFU );
-#if IS_FREERTOS_USED
-               taskEXIT_CRITICAL();
-#endif
-               if( hal_status != HAL_OK )
+               if( eFLASH_ITF_iProgramPacket( Fu32Address, Fu64Data ) != HAL_OK )
                {
                    u8FnRet = 1U;
                }
@@ -117,11 +289,157 @@ __attribute__((weak)) uint8_t u8FLASH_ITF_FlashProgram( uint32_t Fu32Address,
            break;
     }
 
-    HAL_FLASH_Lock();
+    vFLASH_ITF_iLock();
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Program consecutive packets into the MCU flash memory in the native program unit
+ * @param Fu32Address Address in the flash memory of the first packet (8 bytes aligned)
+ * @param Fpu64Data Packets to be written
+ * @param Fu32NbPackets Number of packets
+ * @return Status code indicating the result of the program operation : 0 OK ; 1 NOT OK
+ */
+__attribute__((weak)) uint8_t u8FLASH_ITF_eFlashProgramBurst( uint32_t Fu32Address,
+                                                             const uint64_t * Fpu64Data,
+                                                             uint32_t Fu32NbPackets )
+{
+    uint8_t u8FnRet = 0U;
+    uint32_t u32Pos;
+
+    vFLASH_ITF_iUnlock();
+
+    for( u32Pos = 0U; u32Pos < Fu32NbPackets; u32Pos++ )
+    {
+        if( eFLASH_ITF_iProgramPacket( Fu32Address + ( u32Pos * 8U ), Fpu64Data[ u32Pos ] ) != HAL_OK )
+        {
+            u8FnRet = 1U;
+            break;
+        }
+    }
+
+    vFLASH_ITF_iLock();
 
     return u8FnRet;
 }
 
+
+/**
+ * @brief Open a programming session: the flash stays unlocked until the matching vFLASH_ITF_eSessionEnd
+ */
+__attribute__((weak)) void vFLASH_ITF_eSessionBegin( void )
+{
+    if( u32SessionDepth == 0U )
+    {
+        HAL_FLASH_Unlock();
+    }
+
+    u32SessionDepth++;
+}
+
+
+/**
+ * @brief Close a programming session, the flash is locked again when the outermost session ends
+ */
+__attribute__((weak)) void vFLASH_ITF_eSessionEnd( void )
+{
+    if( u32SessionDepth > 0U )
+    {
+        u32SessionDepth--;
+    }
+
+    vFLASH_ITF_iLock();
+}
+
+
+/**
+ * @brief Take the mutex serializing the writers of the driver, created by the first call
+ */
+__attribute__((weak)) void vFLASH_ITF_eMutexTake( void )
+{
+#if IS_FREERTOS_USED && EEPROM_THREAD_SAFE_ENABLE
+    if( xWriterMutex == NULL )
+    {
+        taskENTER_CRITICAL();
+
+        if( xWriterMutex == NULL )
+        {
+            xWriterMutex = xSemaphoreCreateRecursiveMutexStatic( &stWriterMutexBuffer );
+        }
+
+        taskEXIT_CRITICAL();
+    }
+
+    ( void ) xSemaphoreTakeRecursive( xWriterMutex, portMAX_DELAY );
+#endif
+}
+
+
+/**
+ * @brief Release the mutex serializing the writers of the driver
+ */
+__attribute__((weak)) void vFLASH_ITF_eMutexGive( void )
+{
+#if IS_FREERTOS_USED && EEPROM_THREAD_SAFE_ENABLE
+    ( void ) xSemaphoreGiveRecursive( xWriterMutex );
+#endif
+}
+
+
+/**
+ * @brief Unlock the flash for one operation, nothing to do inside a session
+ */
+static void vFLASH_ITF_iUnlock( void )
+{
+    if( u32SessionDepth == 0U )
+    {
+        HAL_FLASH_Unlock();
+    }
+}
+
+
+/**
+ * @brief Lock the flash after an operation, unless a session or a background erase still needs it
+ */
+static void vFLASH_ITF_iLock( void )
+{
+    if( ( u32SessionDepth == 0U ) && ( u8EraseStatus != FLASH_ITF_ERASE_BUSY ) )
+    {
+        HAL_FLASH_Lock();
+    }
+}
+
+
+/**
+ * @brief Program one 8 bytes packet in the native program unit, the flash must be unlocked
+ * @param Fu32Address Address in the flash memory to write the packet
+ * @param Fu64Data Packet to be written
+ * @return HAL status of the program operation
+ */
+static HAL_StatusTypeDef eFLASH_ITF_iProgramPacket( uint32_t Fu32Address,
+                                                    uint64_t Fu64Data )
+{
+    HAL_StatusTypeDef hal_status;
+
+#if ( MCU_FLASH_PROGRAM_UNIT == 8U )
+    /*x64 parallelism : one program operation per packet*/
+    hal_status = HAL_FLASH_Program( FLASH_TYPEPROGRAM_DOUBLEWORD, Fu32Address, Fu64Data );
+#else
+#if IS_FREERTOS_USED
+    taskENTER_CRITICAL(); /*double word write should NOT be interrupted*/
+#endif
+    hal_status = HAL_FLASH_Program( FLASH_TYPEPROGRAM_WORD, Fu32Address, ( Fu64Data & 0xFFFFFFFFU ) );
+    hal_status |= HAL_FLASH_Program( FLASH_TYPEPROGRAM_WORD, Fu32Address + 4U, ( Fu64Data >> 32 ) & 0xFFFFFFFFU );
+#if IS_FREERTOS_USED
+    taskEXIT_CRITICAL();
+#endif
+#endif
+
+    return hal_status;
+}
+
 /**
  * @}
  */
@@ -0,0 +1,354 @@
+/*
+ * eeprom_registry.c
+ * fyras1
+ *
+ */
+
+#include "eeprom_registry.h"
+
+#if EEPROM_REGISTRY_ENABLE
+
+/*packed width in bits of the field types*/
+#define EEPROM_REG_WIDTH_BOOL     ( 1 )
+#define EEPROM_REG_WIDTH_U8       ( 8 )
+#define EEPROM_REG_WIDTH_U16      ( 16 )
+
+/*value <-> bits of the packet (fields: low bits, shifted to their position by the caller)*/
+#define EEPROM_REG_ENCODE_BOOL( VALUE )     ( ( ( VALUE ) != FALSE ) ? 1U : 0U )
+#define EEPROM_REG_ENCODE_U8( VALUE )       ( ( uint32_t ) ( uint8_t ) ( VALUE ) )
+#define EEPROM_REG_ENCODE_U16( VALUE )      ( ( uint32_t ) ( uint16_t ) ( VALUE ) )
+#define EEPROM_REG_ENCODE_U32( VALUE )      ( ( uint32_t ) ( VALUE ) )
+#define EEPROM_REG_ENCODE_I32( VALUE )      ( ( uint32_t ) ( int32_t ) ( VALUE ) )
+#define EEPROM_REG_ENCODE_FLOAT( VALUE )    u32EEPROM_iRegFloatToBits( VALUE )
+#define EEPROM_REG_DECODE_BOOL( BITS )      ( ( ( BITS ) != 0U ) ? TRUE : FALSE )
+#define EEPROM_REG_DECODE_U8( BITS )        ( ( uint8_t ) ( BITS ) )
+#define EEPROM_REG_DECODE_U16( BITS )       ( ( uint16_t ) ( BITS ) )
+#define EEPROM_REG_DECODE_U32( BITS )       ( BITS )
+#define EEPROM_REG_DECODE_I32( BITS )       ( ( int32_t ) ( BITS ) )
+#define EEPROM_REG_DECODE_FLOAT( BITS )     fEEPROM_iRegBitsToFloat( BITS )
+
+/*bit position of the fields: slot n owns the positions [64 * n, 64 * n + 32), each field starts where the previous
+ * one ends. a field not declared right after its slot (or after another field of its slot) lands out of the range
+ * of its slot and is rejected at compile time below*/
+#define EEPROM_REG_SLOT_BASE( SLOT )    ( EEPROM_REG_IDX_##SLOT * 64 )
+#define EEPROM_REG_POS_SLOT( NAME, VIRT_ADDR ) \
+    EEPROM_REG_POS_##NAME = EEPROM_REG_SLOT_BASE( NAME ), EEPROM_REG_END_##NAME = EEPROM_REG_POS_##NAME - 1,
+#define EEPROM_REG_POS_FIELD( SLOT, NAME, TYPE, DEFAULT ) \
+    EEPROM_REG_POS_##NAME, EEPROM_REG_END_##NAME = EEPROM_REG_POS_##NAME + EEPROM_REG_WIDTH_##TYPE - 1,
+#define EEPROM_REG_POS_VAR( NAME, TYPE, VIRT_ADDR, DEFAULT )
+
+enum
+{
+    EEPROM_REGISTRY( EEPROM_REG_POS_SLOT, EEPROM_REG_POS_FIELD, EEPROM_REG_POS_VAR )
+    EEPROM_REG_POS_NONE
+};
+
+#define EEPROM_REG_SHIFT( SLOT, NAME )    ( ( uint32_t ) ( EEPROM_REG_POS_##NAME - EEPROM_REG_SLOT_BASE( SLOT ) ) )
+
+#define EEPROM_REG_CHECK_SLOT( NAME, VIRT_ADDR )
+#define EEPROM_REG_CHECK_FIELD( SLOT, NAME, TYPE, DEFAULT )                                              \
+    typedef uint8_t Tau8EEPROM_iRegFits##NAME[ ( ( EEPROM_REG_POS_##NAME >= EEPROM_REG_SLOT_BASE( SLOT ) ) && \
+                                                 ( EEPROM_REG_END_##NAME < ( EEPROM_REG_SLOT_BASE( SLOT ) + 32 ) ) ) ? 1 : -1 ];
+#define EEPROM_REG_CHECK_VAR( NAME, TYPE, VIRT_ADDR, DEFAULT )
+
+/*"size of array is negative": the fields of a slot exceed 32 bits or don't follow their slot in EEPROM_REGISTRY*/
+EEPROM_REGISTRY( EEPROM_REG_CHECK_SLOT, EEPROM_REG_CHECK_FIELD, EEPROM_REG_CHECK_VAR )
+
+#define EEPROM_REG_ADDR_SLOT( NAME, VIRT_ADDR )                 ( VIRT_ADDR ),
+#define EEPROM_REG_ADDR_FIELD( SLOT, NAME, TYPE, DEFAULT )
+#define EEPROM_REG_ADDR_VAR( NAME, TYPE, VIRT_ADDR, DEFAULT )   ( VIRT_ADDR ),
+
+static const uint16_t au16EEPROM_iRegAddr[ EEPROM_REG_NB_PACKETS ] =
+{
+    EEPROM_REGISTRY( EEPROM_REG_ADDR_SLOT, EEPROM_REG_ADDR_FIELD, EEPROM_REG_ADDR_VAR )
+};
+
+static uint32_t au32EEPROM_iRegValue[ EEPROM_REG_NB_PACKETS ];  /*RAM copy of the packets*/
+static BOOL abEEPROM_iRegStored[ EEPROM_REG_NB_PACKETS ];      /*packet found in the flash (else default value)*/
+static BOOL bRegistryLoaded = FALSE;
+
+
+/*Internal -----------*/
+
+
+/** @defgroup EEPROMRegistryPrivate_Func Private_Functions
+ * @{
+ */
+
+static void vEEPROM_iRegDefaults( void );
+static uint8_t u8EEPROM_iRegGet( uint32_t Fu32Idx,
+                                 uint32_t Fu32Shift,
+                                 uint32_t Fu32Width,
+                                 const void * FpValue,
+                                 uint32_t * Fpu32Bits );
+static uint8_t u8EEPROM_iRegSet( uint32_t Fu32Idx,
+                                 uint32_t Fu32Shift,
+                                 uint32_t Fu32Width,
+                                 uint32_t Fu32Bits );
+static uint32_t u32EEPROM_iRegFloatToBits( float FfValue );
+static float fEEPROM_iRegBitsToFloat( uint32_t Fu32Bits );
+/**
+ * @}
+ */
+
+
+/**
+ * @brief Initialize the EEPROM (u8EEPROM_eInit) and load the registry in RAM, the defaults for the variables never written
+ * @return Status code indicating the result of the initialization
+ */
+uint8_t u8EEPROM_eRegistryInit( void )
+{
+    uint32_t u32Idx;
+    uint32_t u32Other;
+    uint32_t u32Value;
+    uint8_t u8ReadRet;
+    uint8_t u8FnRet;
+
+    bRegistryLoaded = FALSE;
+
+    for( u32Idx = 0U; u32Idx < EEPROM_REG_NB_PACKETS; u32Idx++ )
+    {
+        if( FALSE == IS_VIRTUAL_ADDRESS_VALID( au16EEPROM_iRegAddr[ u32Idx ] ) )
+        {
+            return Du8EEPROM_eBAD_PARAM;
+        }
+
+        for( u32Other = u32Idx + 1U; u32Other < EEPROM_REG_NB_PACKETS; u32Other++ )
+        {
+            if( au16EEPROM_iRegAddr[ u32Other ] == au16EEPROM_iRegAddr[ u32Idx ] )
+            {
+                return Du8EEPROM_eBAD_PARAM;
+            }
+        }
+    }
+
+    u8FnRet = u8EEPROM_eInit();
+
+    if( u8FnRet != Du8EEPROM_eSUCCESS )
+    {
+        return u8FnRet;
+    }
+
+    vEEPROM_iRegDefaults();
+
+    /*one lookup per packet, the RAM index answers the packets never written without a page scan*/
+    for( u32Idx = 0U; u32Idx < EEPROM_REG_NB_PACKETS; u32Idx++ )
+    {
+        u8ReadRet = u8EEPROM_eReadVar( au16EEPROM_iRegAddr[ u32Idx ], &u32Value );
+
+        if( u8ReadRet == Du8EEPROM_eSUCCESS )
+        {
+            au32EEPROM_iRegValue[ u32Idx ] = u32Value;
+            abEEPROM_iRegStored[ u32Idx ] = TRUE;
+        }
+        else if( u8ReadRet == Du8EEPROM_eDATA_CORRUPTED )
+        {
+            /*default value, the next write stores the packet again*/
+            u8FnRet = Du8EEPROM_eDATA_CORRUPTED;
+        }
+        else
+        {
+            /*never written*/
+        }
+    }
+
+    bRegistryLoaded = TRUE;
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Format the EEPROM (u8EEPROM_eFormat) and set every variable of the registry back to its default
+ * @return Status code indicating the result of the operation
+ */
+uint8_t u8EEPROM_eRegistryFormat( void )
+{
+    uint8_t u8FnRet;
+
+    u8FnRet = u8EEPROM_eFormat();
+
+    if( u8FnRet == Du8EEPROM_eSUCCESS )
+    {
+        vEEPROM_iRegDefaults();
+    }
+
+    return u8FnRet;
+}
+
+
+/*typed accessors of the registry*/
+#define EEPROM_REG_ACCESS_SLOT( NAME, VIRT_ADDR )
+#define EEPROM_REG_ACCESS_FIELD( SLOT, NAME, TYPE, DEFAULT )                                                     \
+    uint8_t u8EEPROM_eRegGet##NAME( EEPROM_REG_CTYPE_##TYPE * FpValue )                                          \
+    {                                                                                                            \
+        uint32_t u32Bits;                                                                                        \
+        uint8_t u8FnRet = u8EEPROM_iRegGet( EEPROM_REG_IDX_##SLOT, EEPROM_REG_SHIFT( SLOT, NAME ),               \
+                                            EEPROM_REG_WIDTH_##TYPE, FpValue, &u32Bits );                        \
+        if( u8FnRet == Du8EEPROM_eSUCCESS )                                                                      \
+        {                                                                                                        \
+            *FpValue = EEPROM_REG_DECODE_##TYPE( u32Bits );                                                      \
+        }                                                                                                        \
+        return u8FnRet;                                                                                          \
+    }                                                                                                            \
+    uint8_t u8EEPROM_eRegSet##NAME( EEPROM_REG_CTYPE_##TYPE FValue )                                             \
+    {                                                                                                            \
+        return u8EEPROM_iRegSet( EEPROM_REG_IDX_##SLOT, EEPROM_REG_SHIFT( SLOT, NAME ),                          \
+                                 EEPROM_REG_WIDTH_##TYPE, EEPROM_REG_ENCODE_##TYPE( FValue ) );                  \
+    }
+#define EEPROM_REG_ACCESS_VAR( NAME, TYPE, VIRT_ADDR, DEFAULT )                                                  \
+    uint8_t u8EEPROM_eRegGet##NAME( EEPROM_REG_CTYPE_##TYPE * FpValue )                                          \
+    {                                                                                                            \
+        uint32_t u32Bits;                                                                                        \
+        uint8_t u8FnRet = u8EEPROM_iRegGet( EEPROM_REG_IDX_##NAME, 0U, 32U, FpValue, &u32Bits );                 \
+        if( u8FnRet == Du8EEPROM_eSUCCESS )                                                                      \
+        {                                                                                                        \
+            *FpValue = EEPROM_REG_DECODE_##TYPE( u32Bits );                                                      \
+        }                                                                                                        \
+        return u8FnRet;                                                                                          \
+    }                                                                                                            \
+    uint8_t u8EEPROM_eRegSet##NAME( EEPROM_REG_CTYPE_##TYPE FValue )                                             \
+    {                                                                                                            \
+        return u8EEPROM_iRegSet( EEPROM_REG_IDX_##NAME, 0U, 32U, EEPROM_REG_ENCODE_##TYPE( FValue ) );           \
+    }
+
+EEPROM_REGISTRY( EEPROM_REG_ACCESS_SLOT, EEPROM_REG_ACCESS_FIELD, EEPROM_REG_ACCESS_VAR )
+
+
+/*default value of each packet: the defaults of the fields of a slot, packed*/
+#define EEPROM_REG_DEFAULT_SLOT( NAME, VIRT_ADDR ) \
+    au32EEPROM_iRegValue[ EEPROM_REG_IDX_##NAME ] = 0U;
+#define EEPROM_REG_DEFAULT_FIELD( SLOT, NAME, TYPE, DEFAULT ) \
+    au32EEPROM_iRegValue[ EEPROM_REG_IDX_##SLOT ] |= EEPROM_REG_ENCODE_##TYPE( DEFAULT ) << EEPROM_REG_SHIFT( SLOT, NAME );
+#define EEPROM_REG_DEFAULT_VAR( NAME, TYPE, VIRT_ADDR, DEFAULT ) \
+    au32EEPROM_iRegValue[ EEPROM_REG_IDX_##NAME ] = EEPROM_REG_ENCODE_##TYPE( DEFAULT );
+
+/**
+ * @brief Set the RAM copy of the registry to the default values, nothing stored
+ */
+static void vEEPROM_iRegDefaults( void )
+{
+    uint32_t u32Idx;
+
+    EEPROM_REGISTRY( EEPROM_REG_DEFAULT_SLOT, EEPROM_REG_DEFAULT_FIELD, EEPROM_REG_DEFAULT_VAR )
+
+    for( u32Idx = 0U; u32Idx < EEPROM_REG_NB_PACKETS; u32Idx++ )
+    {
+        abEEPROM_iRegStored[ u32Idx ] = FALSE;
+    }
+}
+
+
+/**
+ * @brief Get the bits of a variable from the RAM copy
+ * @param Fu32Idx Packet of the variable (EEPROM_REG_IDX_*)
+ * @param Fu32Shift Position of the variable in the packet
+ * @param Fu32Width Width of the variable in bits
+ * @param FpValue Destination of the caller, checked for NULL
+ * @param Fpu32Bits Pointer to store the bits, shifted down
+ * @return Status code indicating the result of the read operation
+ */
+static uint8_t u8EEPROM_iRegGet( uint32_t Fu32Idx,
+                                 uint32_t Fu32Shift,
+                                 uint32_t Fu32Width,
+                                 const void * FpValue,
+                                 uint32_t * Fpu32Bits )
+{
+    uint32_t u32Mask = ( Fu32Width >= 32U ) ? 0xFFFFFFFFU : ( ( 1UL << Fu32Width ) - 1U );
+
+    if( FpValue == NULL )
+    {
+        return Du8EEPROM_eBAD_PARAM;
+    }
+
+    if( bRegistryLoaded == FALSE )
+    {
+        return Du8EEPROM_eERROR;
+    }
+
+    *Fpu32Bits = ( au32EEPROM_iRegValue[ Fu32Idx ] >> Fu32Shift ) & u32Mask;
+
+    return Du8EEPROM_eSUCCESS;
+}
+
+
+/**
+ * @brief Write a variable: read-modify-write of its packet, the RAM copy is updated once the packet is stored
+ * @param Fu32Idx Packet of the variable (EEPROM_REG_IDX_*)
+ * @param Fu32Shift Position of the variable in the packet
+ * @param Fu32Width Width of the variable in bits
+ * @param Fu32Bits Encoded value
+ * @return Status code indicating the result of the write operation
+ */
+static uint8_t u8EEPROM_iRegSet( uint32_t Fu32Idx,
+                                 uint32_t Fu32Shift,
+                                 uint32_t Fu32Width,
+                                 uint32_t Fu32Bits )
+{
+    uint32_t u32Mask = ( Fu32Width >= 32U ) ? 0xFFFFFFFFU : ( ( 1UL << Fu32Width ) - 1U );
+    uint32_t u32Packet;
+    uint8_t u8FnRet;
+
+    if( bRegistryLoaded == FALSE )
+    {
+        return Du8EEPROM_eERROR;
+    }
+
+    u32Packet = ( au32EEPROM_iRegValue[ Fu32Idx ] & ~( u32Mask << Fu32Shift ) ) | ( ( Fu32Bits & u32Mask ) << Fu32Shift );
+
+    if( ( u32Packet == au32EEPROM_iRegValue[ Fu32Idx ] ) && ( abEEPROM_iRegStored[ Fu32Idx ] == TRUE ) )
+    {
+        /*unchanged*/
+        return Du8EEPROM_eSUCCESS;
+    }
+
+    u8FnRet = u8EEPROM_eWriteVar( au16EEPROM_iRegAddr[ Fu32Idx ], u32Packet );
+
+    if( u8FnRet == Du8EEPROM_eSUCCESS )
+    {
+        au32EEPROM_iRegValue[ Fu32Idx ] = u32Packet;
+        abEEPROM_iRegStored[ Fu32Idx ] = TRUE;
+    }
+
+    return u8FnRet;
+}
+
+
+/**
+ * @brief Get the bits of a float (IEEE 754 single precision) to store them in a packet
+ * @param FfValue Value
+ * @return Bits of the value
+ */
+static uint32_t u32EEPROM_iRegFloatToBits( float FfValue )
+{
+    union
+    {
+        float fValue;
+        uint32_t u32Bits;
+    } uFloat;
+
+    uFloat.fValue = FfValue;
+
+    return uFloat.u32Bits;
+}
+
+
+/**
+ * @brief Get the float stored in a packet
+ * @param Fu32Bits Bits of the value
+ * @return Value
+ */
+static float fEEPROM_iRegBitsToFloat( uint32_t Fu32Bits )
+{
+    union
+    {
+        float fValue;
+        uint32_t u32Bits;
+    } uFloat;
+
+    uFloat.u32Bits = Fu32Bits;
+
+    return uFloat.fValue;
+}
+
+#endif /* EEPROM_REGISTRY_ENABLE */